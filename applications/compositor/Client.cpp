@@ -119,11 +119,19 @@ void client_handle_flip_window(Client *client, CompositorFlipWindow flip_window)
         window->backbuffer = new_backbuffer.take_value();
     }
 
-    renderer_region_dirty(flip_window.bound.offset(window->bound.position()));
+    renderer_region_dirty(flip_window.region.offset(window->bound.position()));
 
-    CompositorMessage message = {};
-    message.type = COMPOSITOR_MESSAGE_ACK;
-    client_send_message(client, message);
+    if (client->ring)
+    {
+        // Acknowledged in bulk once the ring is drained.
+        __atomic_store_n(&client->ring->acknowledged, flip_window.sequence, __ATOMIC_SEQ_CST);
+    }
+    else
+    {
+        CompositorMessage message = {};
+        message.type = COMPOSITOR_MESSAGE_ACK;
+        client_send_message(client, message);
+    }
 }
 
 void client_handle_cursor_window(Client *client, CompositorCursorWindow cursor_window)
@@ -166,31 +174,109 @@ void client_handle_set_wallpaper(Client *client, CompositorSetWallaper set_wallp
     }
 }
 
-void client_request_callback(Client *client, Connection *connection, SelectEvent events)
+static bool client_include_ring(Client *client, int handle)
 {
-    assert(events & SELECT_READ);
+    if (client->ring)
+    {
+        logger_warn("Client %08x already has a message ring", client);
+        return false;
+    }
 
-    CompositorMessage message = {};
-    size_t message_size = 0;
+    uintptr_t address = 0;
+    size_t size = 0;
 
-    message_size = connection_receive(connection, &message, sizeof(CompositorMessage));
+    if (memory_include(handle, &address, &size) != SUCCESS)
+    {
+        logger_warn("Client %08x gave us a bad message ring handle", client);
+        return false;
+    }
 
-    if (handle_has_error(connection))
+    if (size < sizeof(CompositorRing))
+    {
+        logger_warn("Client %08x message ring is too small", client);
+        memory_free(address);
+        return false;
+    }
+
+    client->ring = (CompositorRing *)address;
+
+    return true;
+}
+
+void client_handle_greetings(Client *client, CompositorGreetings greetings)
+{
+    bool accepted = client_include_ring(client, greetings.ring);
+
+    client_send_message(client, (CompositorMessage){
+                                    .type = COMPOSITOR_MESSAGE_GREETINGS,
+                                    .greetings = {
+                                        .screen_bound = renderer_bound(),
+                                        .ring = accepted ? greetings.ring : -1,
+                                    },
+                                });
+}
+
+void client_handle_message(Client *client, CompositorMessage &message);
+
+void client_handle_flush(Client *client)
+{
+    CompositorRing *ring = client->ring;
+
+    if (!ring)
     {
-        client->disconnected = true;
-        client_destroy_disconnected();
         return;
     }
 
-    if (message_size != sizeof(CompositorMessage))
+    uint32_t tail = ring->tail;
+    uint32_t head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+
+    if (head - tail > COMPOSITOR_RING_CAPACITY)
     {
+        logger_error("Client %08x corrupted its message ring", client);
         client->disconnected = true;
-        client_destroy_disconnected();
         return;
     }
 
+    // Don't go past what was there when we started, a client that keeps
+    // pushing should not starve the others.
+    while (tail != head && !client->disconnected)
+    {
+        // Copy the message out of the ring, the client could change it under our feet.
+        CompositorMessage message = ring->messages[tail % COMPOSITOR_RING_CAPACITY];
+
+        tail++;
+        __atomic_store_n(&ring->tail, tail, __ATOMIC_RELEASE);
+
+        if (message.type == COMPOSITOR_MESSAGE_GREETINGS ||
+            message.type == COMPOSITOR_MESSAGE_FLUSH)
+        {
+            logger_warn("Client %08x sent a connection message through its ring", client);
+            continue;
+        }
+
+        client_handle_message(client, message);
+    }
+
+    if (__atomic_exchange_n(&ring->waiting, 0, __ATOMIC_SEQ_CST))
+    {
+        CompositorMessage message = {};
+        message.type = COMPOSITOR_MESSAGE_ACK;
+        client_send_message(client, message);
+    }
+}
+
+void client_handle_message(Client *client, CompositorMessage &message)
+{
     switch (message.type)
     {
+    case COMPOSITOR_MESSAGE_GREETINGS:
+        client_handle_greetings(client, message.greetings);
+        break;
+
+    case COMPOSITOR_MESSAGE_FLUSH:
+        client_handle_flush(client);
+        break;
+
     case COMPOSITOR_MESSAGE_CREATE_WINDOW:
         client_handle_create_window(client, message.create_window);
         break;
@@ -202,10 +288,11 @@ void client_request_callback(Client *client, Connection *connection, SelectEvent
     case COMPOSITOR_MESSAGE_RESIZE_WINDOW:
         client_handle_resize_window(client, message.resize_window);
         break;
+
     case COMPOSITOR_MESSAGE_MOVE_WINDOW:
         client_handle_move_window(client, message.move_window);
-
         break;
+
     case COMPOSITOR_MESSAGE_FLIP_WINDOW:
         client_handle_flip_window(client, message.flip_window);
         break;
@@ -228,6 +315,32 @@ void client_request_callback(Client *client, Connection *connection, SelectEvent
     }
 }
 
+void client_request_callback(Client *client, Connection *connection, SelectEvent events)
+{
+    assert(events & SELECT_READ);
+
+    CompositorMessage message = {};
+    size_t message_size = 0;
+
+    message_size = connection_receive(connection, &message, sizeof(CompositorMessage));
+
+    if (handle_has_error(connection))
+    {
+        client->disconnected = true;
+        client_destroy_disconnected();
+        return;
+    }
+
+    if (message_size != sizeof(CompositorMessage))
+    {
+        client->disconnected = true;
+        client_destroy_disconnected();
+        return;
+    }
+
+    client_handle_message(client, message);
+}
+
 static List *_connected_client = nullptr;
 
 Client *client_create(Connection *connection)
@@ -254,6 +367,7 @@ Client *client_create(Connection *connection)
                                     .type = COMPOSITOR_MESSAGE_GREETINGS,
                                     .greetings = {
                                         .screen_bound = renderer_bound(),
+                                        .ring = -1,
                                     },
                                 });
 
@@ -283,6 +397,12 @@ void client_destroy(Client *client)
     list_remove(_connected_client, client);
     notifier_destroy(client->notifier);
     connection_close(client->connection);
+
+    if (client->ring)
+    {
+        memory_free((uintptr_t)client->ring);
+    }
+
     free(client);
 }
 
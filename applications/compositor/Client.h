@@ -10,6 +10,8 @@ struct Client
     Notifier *notifier;
     Connection *connection;
     bool disconnected;
+
+    CompositorRing *ring;
 };
 
 Client *client_create(Connection *connection);
@@ -19,6 +19,7 @@ enum CompositorMessageType
     COMPOSITOR_MESSAGE_CURSOR_WINDOW,
     COMPOSITOR_MESSAGE_SET_RESOLUTION,
     COMPOSITOR_MESSAGE_SET_WALLPAPER,
+    COMPOSITOR_MESSAGE_FLUSH,
 };
 
 #define WINDOW_NONE (0)
@@ -32,6 +33,11 @@ typedef unsigned int WindowFlag;
 struct CompositorGreetings
 {
     Rectangle screen_bound;
+
+    // Sent back by the client: shared memory handle of its message ring.
+    // The compositor answers with the same handle once it included the ring,
+    // or -1 when it couldn't and the client should stay on the connection.
+    int ring;
 };
 
 struct CompositorCreateWindow
@@ -69,13 +75,14 @@ struct CompositorMoveWindow
 struct CompositorFlipWindow
 {
     int id;
+    uint32_t sequence;
 
     int frontbuffer;
     Vec2i frontbuffer_size;
     int backbuffer;
     Vec2i backbuffer_size;
 
-    Rectangle bound;
+    Region region;
 };
 
 struct CompositorEventWindow
@@ -121,3 +128,30 @@ struct CompositorMessage
         CompositorSetWallaper set_wallaper;
     };
 };
+
+/* --- Message ring --------------------------------------------------------- */
+
+// Once the compositor accepted the ring offered in the greetings, every
+// message the client sends goes through the ring. A COMPOSITOR_MESSAGE_FLUSH on the connection tells the
+// compositor to drain it. The client is the only producer and the compositor
+// the only consumer.
+
+#define COMPOSITOR_RING_CAPACITY (128)
+
+// How many flips a client can queue before waiting for the compositor.
+#define COMPOSITOR_RING_MAX_PENDING_FLIPS (2)
+
+struct CompositorRing
+{
+    // Free running indexes, written by the client and the compositor.
+    uint32_t head;
+    uint32_t tail;
+
+    // Sequence number of the last flip handled by the compositor.
+    uint32_t acknowledged;
+
+    // Set by the client when it's blocked on the connection waiting for an ack.
+    uint32_t waiting;
+
+    CompositorMessage messages[COMPOSITOR_RING_CAPACITY];
+};
@@ -1,5 +1,4 @@
 #include <libgraphic/Framebuffer.h>
-#include <libutils/Vector.h>
 
 #include "compositor/Cursor.h"
 #include "compositor/Manager.h"
@@ -9,7 +8,7 @@
 static OwnPtr<Framebuffer> _framebuffer;
 static RefPtr<Bitmap> _wallpaper;
 
-static Vector<Rectangle> _dirty_regions;
+static Region _dirty_region;
 
 void renderer_initialize()
 {
@@ -19,47 +18,54 @@ void renderer_initialize()
     renderer_region_dirty(_framebuffer->resolution());
 }
 
-void renderer_region_dirty(Rectangle new_region)
+void renderer_region_dirty(Region region)
 {
-    bool merged = false;
+    _dirty_region = _dirty_region.unite(region);
+}
 
-    _dirty_regions.foreach ([&](Rectangle &region) {
-        int region_area = region.area();
-        int new_region_area = new_region.area();
-        int merge_area = region.merged_with(new_region).area();
+// Windows are opaque, so a window only shows the part of the dirty region
+// that isn't covered by the windows above it. Windows are painted from the
+// bottom up: when a region overflows and grows, the extra pixels are painted
+// over by the windows above instead of hiding them.
+static void renderer_region_from(Region dirty, ListItem *item)
+{
+    if (dirty.is_empty())
+    {
+        return;
+    }
 
-        if (region.colide_with(new_region) && (region_area + new_region_area > merge_area))
-        {
-            region = region.merged_with(new_region);
-            merged = true;
-        }
+    if (item == nullptr)
+    {
+        dirty.foreach ([](Rectangle rectangle) {
+            _framebuffer->painter().blit_bitmap_no_alpha(*_wallpaper, rectangle, rectangle);
 
-        return Iteration::CONTINUE;
-    });
+            return Iteration::CONTINUE;
+        });
 
-    if (!merged)
-    {
-        _dirty_regions.push_back(new_region);
+        return;
     }
-}
 
-void renderer_region(Rectangle region)
-{
-    _framebuffer->painter().blit_bitmap_no_alpha(*_wallpaper, region, region);
+    Window *window = (Window *)item->value;
+    Rectangle bound = window_bound(window);
 
-    list_foreach_reversed(Window, window, manager_get_windows())
-    {
-        if (window_bound(window).colide_with(region))
-        {
-            Rectangle destination = window_bound(window).clipped_with(region);
+    renderer_region_from(dirty.subtract(bound), item->next);
 
-            Rectangle source(
-                destination.position() - window_bound(window).position(),
-                destination.size());
+    Region visible = dirty.intersect(bound);
 
-            _framebuffer->painter().blit_bitmap_no_alpha(*window->frontbuffer, source, destination);
-        }
-    }
+    visible.foreach ([&](Rectangle destination) {
+        Rectangle source(
+            destination.position() - bound.position(),
+            destination.size());
+
+        _framebuffer->painter().blit_bitmap_no_alpha(*window->frontbuffer, source, destination);
+
+        return Iteration::CONTINUE;
+    });
+}
+
+static void renderer_region(Region region)
+{
+    renderer_region_from(region, manager_get_windows()->head());
 
     _framebuffer->mark_dirty(region);
 }
@@ -71,22 +77,30 @@ Rectangle renderer_bound()
 
 void renderer_repaint_dirty()
 {
-    _dirty_regions.foreach ([](Rectangle region) {
-        renderer_region(region);
+    if (_dirty_region.is_empty())
+    {
+        return;
+    }
 
-        if (region.colide_with(cursor_bound()))
-        {
-            renderer_region(cursor_bound());
+    // The cursor is drawn over the windows, repaint it as a whole if any part
+    // of it was overwritten.
+    bool cursor_dirty = _dirty_region.colide_with(cursor_bound());
 
-            cursor_render(_framebuffer->painter());
-        }
+    if (cursor_dirty)
+    {
+        _dirty_region = _dirty_region.unite(cursor_bound());
+    }
 
-        return Iteration::CONTINUE;
-    });
+    renderer_region(_dirty_region);
+
+    if (cursor_dirty)
+    {
+        cursor_render(_framebuffer->painter());
+    }
 
     _framebuffer->blit();
 
-    _dirty_regions.clear();
+    _dirty_region = Region::empty();
 }
 
 void renderer_set_resolution(int width, int height)
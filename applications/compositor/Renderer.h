@@ -7,7 +7,7 @@ void renderer_initialize();
 
 Rectangle renderer_bound();
 
-void renderer_region_dirty(Rectangle region);
+void renderer_region_dirty(Region region);
 
 void renderer_repaint_dirty();
 
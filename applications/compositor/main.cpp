@@ -133,6 +133,9 @@ int main(int argc, char const *argv[])
     Stream *lock_stream = stream_open("/Session/compositor.lock", OPEN_CREATE);
     stream_close(lock_stream);
 
+    // Input and frames should not lag behind background work.
+    process_set_priority(process_this(), PROCESS_PRIORITY_HIGH);
+
     notifier_create(nullptr, HANDLE(keyboard_stream), SELECT_READ, (NotifierCallback)keyboard_callback);
     notifier_create(nullptr, HANDLE(mouse_stream), SELECT_READ, (NotifierCallback)mouse_callback);
     notifier_create(nullptr, HANDLE(socket), SELECT_ACCEPT, (NotifierCallback)accept_callback);
@@ -14,6 +14,11 @@ void fonts_draw(Painter &painter, Rectangle screen, double time)
     {
         _family = truetype_family_create("/System/Fonts/Roboto/Roboto-Medium.ttf");
 
+        if (!_family)
+        {
+            return;
+        }
+
         for (size_t i = 0; i < 16; i++)
         {
             _fonts[i] = truetypefont_create(_family, 8 + 4 * i);
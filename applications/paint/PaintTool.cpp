@@ -99,6 +99,7 @@ PaintTool *eraser_tool_create()
 
 static void flood_fill(Bitmap &bitmap, Vec2i position, Color target, Color fill)
 {
+    fill = bitmap.color_to_storage(fill);
 
     if (!bitmap.bound().containe(position))
         return;
@@ -185,11 +186,11 @@ void picker_tool_mouse_event(PaintTool *tool, PaintDocument *document, Event eve
     {
         if (event.mouse.buttons & MOUSE_BUTTON_LEFT)
         {
-            document->primary_color = document->bitmap->get_pixel(event.mouse.position);
+            document->primary_color = document->bitmap->color_from_storage(document->bitmap->get_pixel(event.mouse.position));
         }
         else if (event.mouse.buttons & MOUSE_BUTTON_RIGHT)
         {
-            document->secondary_color = document->bitmap->get_pixel(event.mouse.position);
+            document->secondary_color = document->bitmap->color_from_storage(document->bitmap->get_pixel(event.mouse.position));
         }
     }
 }
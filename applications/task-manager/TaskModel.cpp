@@ -11,6 +11,7 @@ enum Column
     COLUMN_NAME,
     COLUMN_STATE,
     COLUMN_CPU,
+    COLUMN_TIME,
     COLUMN_RAM,
     COLUMN_DIRECTORY,
 
@@ -56,6 +57,14 @@ static Variant task_model_data(TaskModel *model, int row, int column)
     case COLUMN_CPU:
         return Variant("%2d%%", json_integer_value(json_object_get(task, "cpu")));
 
+    case COLUMN_TIME:
+    {
+        int time = json_integer_value(json_object_get(task, "user_time")) +
+                   json_integer_value(json_object_get(task, "kernel_time"));
+
+        return Variant("%d.%03ds", time / 1000, time % 1000);
+    }
+
     case COLUMN_RAM:
         return Variant("%5d Kio", json_integer_value(json_object_get(task, "ram")) / 1024);
 
@@ -93,6 +102,9 @@ static const char *task_model_column_name(int column)
     case COLUMN_CPU:
         return "CPU%";
 
+    case COLUMN_TIME:
+        return "Time";
+
     case COLUMN_RAM:
         return "RAM(Kio)";
 
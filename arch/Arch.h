@@ -19,3 +19,5 @@ void arch_load_context(Task *task);
 size_t arch_debug_write(const void *buffer, size_t size);
 
 TimeStamp arch_get_time();
+
+uint64_t arch_get_cycles();
@@ -0,0 +1,157 @@
+#include <libsystem/Logger.h>
+#include <libsystem/core/CString.h>
+
+#include "arch/x86/ACPI.h"
+#include "arch/x86/IOAPIC.h"
+#include "arch/x86/LAPIC.h"
+
+#include "kernel/memory/Virtual.h"
+
+#define ACPI_BIOS_AREA_BASE 0xE0000
+#define ACPI_BIOS_AREA_SIZE 0x20000
+
+static void *acpi_map(uintptr_t physical_address, size_t size)
+{
+    MemoryRange physical_range = memory_range_around_non_aligned_address(physical_address, size);
+    MemoryRange virtual_range = virtual_alloc(&kpdir, physical_range, MEMORY_NONE);
+
+    return (void *)(virtual_range.base + (physical_address - physical_range.base));
+}
+
+// The tables are only read once at boot, give the address space back.
+static void acpi_unmap(void *address, size_t size)
+{
+    virtual_free(&kpdir, memory_range_around_non_aligned_address((uintptr_t)address, size));
+}
+
+static bool acpi_checksum(void *table, size_t size)
+{
+    uint8_t sum = 0;
+
+    for (size_t i = 0; i < size; i++)
+    {
+        sum += ((uint8_t *)table)[i];
+    }
+
+    return sum == 0;
+}
+
+static SDTHeader *acpi_map_table(uintptr_t physical_address)
+{
+    SDTHeader *header = (SDTHeader *)acpi_map(physical_address, sizeof(SDTHeader));
+    size_t length = header->length;
+    acpi_unmap(header, sizeof(SDTHeader));
+
+    return (SDTHeader *)acpi_map(physical_address, length);
+}
+
+static void acpi_unmap_table(SDTHeader *table)
+{
+    acpi_unmap(table, table->length);
+}
+
+static uintptr_t acpi_find_rsdt_in_bios_area()
+{
+    uint8_t *bios_area = (uint8_t *)acpi_map(ACPI_BIOS_AREA_BASE, ACPI_BIOS_AREA_SIZE);
+    uintptr_t rsdt_address = 0;
+
+    for (size_t offset = 0; offset < ACPI_BIOS_AREA_SIZE; offset += 16)
+    {
+        RSDP *rsdp = (RSDP *)(bios_area + offset);
+
+        if (memcmp(rsdp->signature, "RSD PTR ", 8) == 0 &&
+            acpi_checksum(rsdp, sizeof(RSDP)))
+        {
+            rsdt_address = rsdp->rsdt_address;
+            break;
+        }
+    }
+
+    acpi_unmap(bios_area, ACPI_BIOS_AREA_SIZE);
+
+    return rsdt_address;
+}
+
+static void acpi_parse_madt(MADT *madt)
+{
+    lapic_found(madt->local_apic_address);
+
+    uintptr_t current = (uintptr_t)&madt->records[0];
+    uintptr_t end = (uintptr_t)madt + madt->header.length;
+
+    while (current < end)
+    {
+        MADTRecord *record = (MADTRecord *)current;
+
+        if (record->length == 0)
+        {
+            break;
+        }
+
+        switch (record->type)
+        {
+        case MADT_RECORD_PROCESSOR:
+        {
+            auto processor = (MADTLocalApicRecord *)record;
+
+            // Bit 0: enabled, bit 1: can be enabled.
+            if (processor->flags & 0b11)
+            {
+                lapic_found_processor(processor->apic_id);
+            }
+            break;
+        }
+
+        case MADT_RECORD_IOAPIC:
+        {
+            auto ioapic = (MADTIOApicRecord *)record;
+            ioapic_found(ioapic->id, ioapic->address, ioapic->interrupt_base);
+            break;
+        }
+
+        default:
+            break;
+        }
+
+        current += record->length;
+    }
+}
+
+// This only discovers the processors and the interrupt controllers. The
+// application processors are not started and interrupts still go through the PIC.
+void acpi_initialize(Multiboot *multiboot)
+{
+    uintptr_t rsdt_address = multiboot->acpi_rsdt_address;
+
+    if (rsdt_address == 0)
+    {
+        rsdt_address = acpi_find_rsdt_in_bios_area();
+    }
+
+    if (rsdt_address == 0)
+    {
+        logger_warn("No ACPI tables found!");
+        return;
+    }
+
+    RSDT *rsdt = (RSDT *)acpi_map_table(rsdt_address);
+
+    size_t childs_count = (rsdt->header.length - sizeof(SDTHeader)) / sizeof(uint32_t);
+
+    for (size_t i = 0; i < childs_count; i++)
+    {
+        SDTHeader *table = acpi_map_table(rsdt->childs[i]);
+
+        if (memcmp(table->signature, "APIC", 4) == 0)
+        {
+            acpi_parse_madt((MADT *)table);
+        }
+
+        acpi_unmap_table(table);
+    }
+
+    acpi_unmap_table(&rsdt->header);
+
+    lapic_initialize();
+    ioapic_initialize();
+}
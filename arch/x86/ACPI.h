@@ -0,0 +1,75 @@
+#pragma once
+
+#include <libsystem/Common.h>
+
+#include "kernel/multiboot/Multiboot.h"
+
+struct __packed RSDP
+{
+    char signature[8];
+    uint8_t checksum;
+    char oem_id[6];
+    uint8_t revision;
+    uint32_t rsdt_address;
+};
+
+struct __packed SDTHeader
+{
+    char signature[4];
+    uint32_t length;
+    uint8_t revision;
+    uint8_t checksum;
+    char oem_id[6];
+    char oem_table_id[8];
+    uint32_t oem_revision;
+    uint32_t creator_id;
+    uint32_t creator_revision;
+};
+
+struct __packed RSDT
+{
+    SDTHeader header;
+    uint32_t childs[];
+};
+
+enum MADTRecordType
+{
+    MADT_RECORD_PROCESSOR = 0,
+    MADT_RECORD_IOAPIC = 1,
+    MADT_RECORD_INTERRUPT_SOURCE_OVERRIDE = 2,
+    MADT_RECORD_NMI = 4,
+    MADT_RECORD_LAPIC_OVERRIDE = 5,
+};
+
+struct __packed MADTRecord
+{
+    uint8_t type;
+    uint8_t length;
+};
+
+struct __packed MADTLocalApicRecord
+{
+    MADTRecord header;
+    uint8_t processor_id;
+    uint8_t apic_id;
+    uint32_t flags;
+};
+
+struct __packed MADTIOApicRecord
+{
+    MADTRecord header;
+    uint8_t id;
+    uint8_t reserved;
+    uint32_t address;
+    uint32_t interrupt_base;
+};
+
+struct __packed MADT
+{
+    SDTHeader header;
+    uint32_t local_apic_address;
+    uint32_t flags;
+    MADTRecord records[];
+};
+
+void acpi_initialize(Multiboot *multiboot);
@@ -0,0 +1,55 @@
+#include <libsystem/Logger.h>
+
+#include "arch/x86/IOAPIC.h"
+
+#include "kernel/memory/Virtual.h"
+
+#define IOAPIC_REGISTER_SELECT 0x00
+#define IOAPIC_REGISTER_WINDOW 0x10
+
+#define IOAPIC_VERSION 0x01
+
+struct IOAPIC
+{
+    int id;
+    uintptr_t physical;
+    volatile uint32_t *registers;
+    int interrupt_base;
+};
+
+static IOAPIC _ioapics[IOAPIC_MAX_COUNT];
+static size_t _ioapics_count = 0;
+
+static uint32_t ioapic_read(IOAPIC *ioapic, uint32_t reg)
+{
+    ioapic->registers[IOAPIC_REGISTER_SELECT / sizeof(uint32_t)] = reg;
+    return ioapic->registers[IOAPIC_REGISTER_WINDOW / sizeof(uint32_t)];
+}
+
+void ioapic_found(int id, uintptr_t address, int interrupt_base)
+{
+    if (_ioapics_count < IOAPIC_MAX_COUNT)
+    {
+        _ioapics[_ioapics_count] = (IOAPIC){id, address, nullptr, interrupt_base};
+        _ioapics_count++;
+    }
+}
+
+void ioapic_initialize()
+{
+    for (size_t i = 0; i < _ioapics_count; i++)
+    {
+        IOAPIC *ioapic = &_ioapics[i];
+
+        ioapic->registers = (volatile uint32_t *)virtual_alloc(&kpdir, (MemoryRange){ioapic->physical, PAGE_SIZE}, MEMORY_UNCACHED).base;
+
+        uint32_t version = ioapic_read(ioapic, IOAPIC_VERSION);
+
+        logger_info("IOAPIC %d at %08x version %x with %d interrupts starting at %d",
+                    ioapic->id,
+                    ioapic->physical,
+                    version & 0xff,
+                    ((version >> 16) & 0xff) + 1,
+                    ioapic->interrupt_base);
+    }
+}
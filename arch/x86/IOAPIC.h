@@ -0,0 +1,9 @@
+#pragma once
+
+#include <libsystem/Common.h>
+
+#define IOAPIC_MAX_COUNT 8
+
+void ioapic_found(int id, uintptr_t address, int interrupt_base);
+
+void ioapic_initialize();
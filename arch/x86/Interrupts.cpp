@@ -11,6 +11,7 @@
 #include "kernel/scheduling/Scheduler.h"
 #include "kernel/system/System.h"
 #include "kernel/tasking/Syscalls.h"
+#include "kernel/tasking/Task-Memory.h"
 
 static const char *_exception_messages[32] = {
     "Division by zero",
@@ -79,7 +80,13 @@ extern "C" uint32_t interrupts_handler(uintptr_t esp, InterruptStackFrame stackf
 {
     if (stackframe.intno < 32)
     {
-        if (stackframe.eip >= 0x40000000)
+        if (stackframe.intno == 14 &&
+            CR2() >= 0x40000000 &&
+            task_memory_page_fault(scheduler_running(), CR2(), stackframe.err & 2) == SUCCESS)
+        {
+            // The page was lazily allocated or copied, the faulting instruction can be retried.
+        }
+        else if (stackframe.eip >= 0x40000000)
         {
             sti();
 
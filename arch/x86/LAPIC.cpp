@@ -0,0 +1,41 @@
+#include <libsystem/Logger.h>
+
+#include "arch/x86/LAPIC.h"
+
+#include "kernel/memory/Virtual.h"
+
+#define LAPIC_REGISTER_ID 0x20
+#define LAPIC_REGISTER_VERSION 0x30
+
+static uintptr_t _lapic_physical = 0;
+static volatile uint32_t *_lapic = nullptr;
+
+static uint32_t lapic_read(uint32_t reg)
+{
+    return _lapic[reg / sizeof(uint32_t)];
+}
+
+void lapic_found(uintptr_t address)
+{
+    _lapic_physical = address;
+}
+
+void lapic_found_processor(int apic_id)
+{
+    logger_info("Processor with APIC id %d found", apic_id);
+}
+
+void lapic_initialize()
+{
+    if (_lapic_physical == 0)
+    {
+        return;
+    }
+
+    _lapic = (volatile uint32_t *)virtual_alloc(&kpdir, (MemoryRange){_lapic_physical, PAGE_SIZE}, MEMORY_UNCACHED).base;
+
+    logger_info("LAPIC at %08x version %x, running on processor %d",
+                _lapic_physical,
+                lapic_read(LAPIC_REGISTER_VERSION) & 0xff,
+                lapic_read(LAPIC_REGISTER_ID) >> 24);
+}
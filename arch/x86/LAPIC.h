@@ -0,0 +1,9 @@
+#pragma once
+
+#include <libsystem/Common.h>
+
+void lapic_found(uintptr_t address);
+
+void lapic_found_processor(int apic_id);
+
+void lapic_initialize();
@@ -3,7 +3,7 @@ section .text
 global paging_enable
 paging_enable:
     mov eax, cr0
-    or eax, 0x80000000
+    or eax, 0x80010000 ; Paging and write protect, the kernel must respect read-only pages too.
     mov cr0, eax
     ret
 
@@ -26,6 +26,19 @@ paging_invalidate_tlb:
     mov cr3, eax
     ret
 
+global paging_invalidate_page
+paging_invalidate_page:
+    mov eax, [esp + 4]
+    invlpg [eax]
+    ret
+
+global paging_enable_global_pages
+paging_enable_global_pages:
+    mov eax, cr4
+    or eax, 0x80
+    mov cr4, eax
+    ret
+
 # --- CPU tables ------------------------------------------------------------- #
 
 global gdt_flush
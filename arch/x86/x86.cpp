@@ -75,3 +75,8 @@ TimeStamp arch_get_time()
 {
     return rtc_now();
 }
+
+uint64_t arch_get_cycles()
+{
+    return rdtsc();
+}
@@ -1,4 +1,6 @@
 UTILS = \
+	__BENCHPAINT \
+	__BENCHPIPE \
 	__TESTEXEC \
 	__TESTTERM \
 	CAT \
@@ -27,6 +29,12 @@ UTILS = \
 	WALLPAPERCTL \
 	LINK
 
+__BENCHPAINT_NAME = __benchpaint
+__BENCHPAINT_LIBS = graphic
+
+__BENCHPIPE_NAME = __benchpipe
+__BENCHPIPE_LIBS =
+
 __TESTEXEC_NAME = __testexec
 __TESTEXEC_LIBS =
 
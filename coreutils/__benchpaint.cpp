@@ -0,0 +1,86 @@
+#include <libgraphic/Painter.h>
+#include <libgraphic/Pixels.h>
+#include <libsystem/io/Stream.h>
+#include <libsystem/math/MinMax.h>
+#include <libsystem/system/System.h>
+
+// Run the painter primitives used by the compositor over a screen sized
+// bitmap and report the throughput of the scalar and SIMD kernels.
+
+#define BENCHMARK_WIDTH 1024
+#define BENCHMARK_HEIGHT 768
+#define BENCHMARK_ITERATIONS 64
+
+typedef void (*BenchmarkCallback)(Painter &painter, Bitmap &source);
+
+static void benchmark(const char *name, Painter &painter, Bitmap &source, BenchmarkCallback callback)
+{
+    uint start = system_get_ticks();
+
+    for (int i = 0; i < BENCHMARK_ITERATIONS; i++)
+    {
+        callback(painter, source);
+    }
+
+    uint elapsed = MAX(1u, system_get_ticks() - start);
+
+    uint pixels = BENCHMARK_WIDTH * BENCHMARK_HEIGHT * BENCHMARK_ITERATIONS;
+
+    printf("    %-24s %5d Mpx/s\n", name, pixels / elapsed / 1000);
+}
+
+static void benchmark_all(Painter &painter, Bitmap &source)
+{
+    benchmark("clear_rectangle", painter, source, [](Painter &painter, Bitmap &) {
+        painter.clear_rectangle(Rectangle(BENCHMARK_WIDTH, BENCHMARK_HEIGHT), COLOR_CORNFLOWERBLUE);
+    });
+
+    benchmark("fill_rectangle", painter, source, [](Painter &painter, Bitmap &) {
+        painter.fill_rectangle(Rectangle(BENCHMARK_WIDTH, BENCHMARK_HEIGHT), ALPHA(COLOR_CRIMSON, 0.5));
+    });
+
+    benchmark("blit_bitmap", painter, source, [](Painter &painter, Bitmap &source) {
+        painter.blit_bitmap(source, source.bound(), source.bound());
+    });
+
+    benchmark("blit_bitmap_no_alpha", painter, source, [](Painter &painter, Bitmap &source) {
+        painter.blit_bitmap_no_alpha(source, source.bound(), source.bound());
+    });
+}
+
+int main(int argc, char **argv)
+{
+    __unused(argc);
+    __unused(argv);
+
+    auto destination = Bitmap::create_shared(BENCHMARK_WIDTH, BENCHMARK_HEIGHT).take_value();
+    auto source = Bitmap::create_shared(BENCHMARK_WIDTH, BENCHMARK_HEIGHT).take_value();
+
+    // A gradient with every alpha value so the blend kernels don't only hit their fast paths.
+    for (int y = 0; y < BENCHMARK_HEIGHT; y++)
+    {
+        for (int x = 0; x < BENCHMARK_WIDTH; x++)
+        {
+            source->set_pixel(Vec2i(x, y), source->color_to_storage(COLOR_RGBA(x, y, x ^ y, x + y)));
+        }
+    }
+
+    Painter painter(destination);
+
+    printf("scalar:\n");
+    pixels_use_simd(false);
+    benchmark_all(painter, *source);
+
+    if (pixels_simd_available())
+    {
+        printf("sse2:\n");
+        pixels_use_simd(true);
+        benchmark_all(painter, *source);
+    }
+    else
+    {
+        printf("sse2: not supported by this CPU\n");
+    }
+
+    return 0;
+}
@@ -0,0 +1,53 @@
+#include <libsystem/io/Pipe.h>
+#include <libsystem/io/Stream.h>
+#include <libsystem/math/MinMax.h>
+#include <libsystem/system/System.h>
+
+// Push data through a pipe and report the throughput for a few transfer sizes.
+
+#define BENCHMARK_TOTAL_SIZE (16 * 1024 * 1024)
+
+static char _buffer[4096];
+
+static void benchmark(Pipe *pipe, size_t chunk_size)
+{
+    size_t total = 0;
+    uint start = system_get_ticks();
+
+    while (total < BENCHMARK_TOTAL_SIZE)
+    {
+        size_t written = stream_write(pipe->in, _buffer, chunk_size);
+        size_t read = 0;
+
+        while (read < written)
+        {
+            read += stream_read(pipe->out, _buffer, written - read);
+        }
+
+        total += read;
+    }
+
+    uint elapsed = MAX(1u, system_get_ticks() - start);
+
+    printf("%5d bytes per transfer: %5d MB/s\n", chunk_size, (total / elapsed) * 1000 / (1024 * 1024));
+}
+
+int main(int argc, char **argv)
+{
+    __unused(argc);
+    __unused(argv);
+
+    Pipe *pipe = pipe_create();
+
+    stream_set_write_buffer_mode(pipe->in, STREAM_BUFFERED_NONE);
+    stream_set_read_buffer_mode(pipe->out, STREAM_BUFFERED_NONE);
+
+    for (size_t chunk_size = 64; chunk_size <= sizeof(_buffer); chunk_size *= 4)
+    {
+        benchmark(pipe, chunk_size);
+    }
+
+    pipe_destroy(pipe);
+
+    return 0;
+}
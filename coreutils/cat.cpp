@@ -2,6 +2,35 @@
 #include <libsystem/Result.h>
 #include <libsystem/io/Stream.h>
 
+#define CAT_SPLICE_SIZE (64 * 1024)
+
+static bool output_is_pipe()
+{
+    FileState stat = {};
+    stream_stat(out_stream, &stat);
+
+    return stat.type == FILE_TYPE_PIPE;
+}
+
+// Let the kernel move the file into the pipe directly.
+static int cat_splice(Stream *stream, const char *path)
+{
+    stream_flush(out_stream);
+
+    while (handle_splice(HANDLE(stream), HANDLE(out_stream), CAT_SPLICE_SIZE) != 0)
+    {
+    }
+
+    if (handle_has_error(stream))
+    {
+        handle_printf_error(stream, "cat: Failled to read from %s", path);
+
+        return -1;
+    }
+
+    return 0;
+}
+
 int cat(const char *path)
 {
     __cleanup(stream_cleanup) Stream *stream = stream_open(path, OPEN_READ);
@@ -15,6 +44,11 @@ int cat(const char *path)
     FileState stat = {};
     stream_stat(stream, &stat);
 
+    if (stat.type == FILE_TYPE_REGULAR && output_is_pipe())
+    {
+        return cat_splice(stream, path);
+    }
+
     size_t read;
     char buffer[1024];
 
@@ -9,6 +9,10 @@
 #define PCI_REVISION_ID 0x08
 #define PCI_SUBSYSTEM_ID 0x2E
 
+#define PCI_COMMAND_IO (1 << 0)
+#define PCI_COMMAND_MEMORY (1 << 1)
+#define PCI_COMMAND_BUS_MASTER (1 << 2)
+
 #define PCI_PROG_IF 0x09
 #define PCI_SUBCLASS 0x0a
 #define PCI_CLASS 0x0b
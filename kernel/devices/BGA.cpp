@@ -9,6 +9,7 @@
 #include "kernel/devices/Devices.h"
 #include "kernel/filesystem/Filesystem.h"
 #include "kernel/graphics/Graphics.h"
+#include "kernel/memory/MemoryObject.h"
 #include "kernel/memory/Virtual.h"
 
 #define VBE_DISPI_BANK_ADDRESS 0xA0000
@@ -31,6 +32,7 @@
 #define VBE_DISPI_INDEX_VIRT_HEIGHT 0x7
 #define VBE_DISPI_INDEX_X_OFFSET 0x8
 #define VBE_DISPI_INDEX_Y_OFFSET 0x9
+#define VBE_DISPI_INDEX_VIDEO_MEMORY_64K 0xA
 
 #define VBE_DISPI_DISABLED 0x00
 #define VBE_DISPI_ENABLED 0x01
@@ -40,11 +42,21 @@
 
 #define VBE_DISPI_LFB_PHYSICAL_ADDRESS 0xE0000000
 
+// Older versions of the adapter don't report the size of their memory.
+#define VBE_DISPI_DEFAULT_MEMORY_SIZE (16 * 1024 * 1024)
+
 static uintptr_t framebuffer_physical = 0;
 static uintptr_t framebuffer_virtual = 0;
+static size_t framebuffer_size = 0;
 static int framebuffer_width = 0;
 static int framebuffer_height = 0;
 
+// The compositor maps the whole video memory and draws to the page which
+// is not on screen, then flips by moving the Y offset.
+static MemoryObject *framebuffer_memory_object = nullptr;
+static int framebuffer_pages = 1;
+static int framebuffer_page = 0;
+
 void bga_write_register(uint16_t IndexValue, uint16_t DataValue)
 {
     out16(VBE_DISPI_IOPORT_INDEX, IndexValue);
@@ -67,6 +79,31 @@ void bga_set_mode(int width, int height)
 
     framebuffer_width = width;
     framebuffer_height = height;
+    framebuffer_page = 0;
+
+    // Some implementations compute the virtual height from the size of
+    // the memory and ignore the write, so read it back.
+    if (width * height * 2 * sizeof(uint32_t) <= framebuffer_size)
+    {
+        bga_write_register(VBE_DISPI_INDEX_VIRT_HEIGHT, height * 2);
+    }
+
+    bga_write_register(VBE_DISPI_INDEX_Y_OFFSET, 0);
+
+    if (bga_read_register(VBE_DISPI_INDEX_VIRT_HEIGHT) >= height * 2 &&
+        width * height * 2 * sizeof(uint32_t) <= framebuffer_size)
+    {
+        framebuffer_pages = 2;
+    }
+    else
+    {
+        framebuffer_pages = 1;
+    }
+}
+
+static void bga_release(void *target)
+{
+    __unused(target);
 }
 
 Result bga_iocall(FsNode *node, FsHandle *handle, IOCall iocall, void *args)
@@ -87,17 +124,22 @@ Result bga_iocall(FsNode *node, FsHandle *handle, IOCall iocall, void *args)
     {
         IOCallDisplayBlitArgs *blit = (IOCallDisplayBlitArgs *)args;
 
-        for (int y = MAX(0, blit->blit_y); y < MIN(framebuffer_height, blit->blit_y + blit->blit_height); y++)
+        for (int i = 0; i < MIN(blit->blit_count, IOCALL_DISPLAY_BLIT_MAX_RECTANGLES); i++)
         {
-            for (int x = MAX(0, blit->blit_x); x < MIN(framebuffer_width, blit->blit_x + blit->blit_width); x++)
+            IOCallDisplayBlitRectangle &rectangle = blit->blit_rectangles[i];
+
+            for (int y = MAX(0, rectangle.y); y < MIN(framebuffer_height, rectangle.y + rectangle.height); y++)
             {
-                uint32_t pixel = blit->buffer[y * blit->buffer_width + x];
+                for (int x = MAX(0, rectangle.x); x < MIN(framebuffer_width, rectangle.x + rectangle.width); x++)
+                {
+                    uint32_t pixel = blit->buffer[y * blit->buffer_width + x];
 
-                uint32_t converted_pixel = ((pixel >> 16) & 0x000000ff) |
-                                           ((pixel)&0xff00ff00) |
-                                           ((pixel << 16) & 0x00ff0000);
+                    uint32_t converted_pixel = ((pixel >> 16) & 0x000000ff) |
+                                               ((pixel)&0xff00ff00) |
+                                               ((pixel << 16) & 0x00ff0000);
 
-                ((uint32_t *)framebuffer_virtual)[y * framebuffer_width + x] = converted_pixel;
+                    ((uint32_t *)framebuffer_virtual)[(framebuffer_page * framebuffer_height + y) * framebuffer_width + x] = converted_pixel;
+                }
             }
         }
 
@@ -106,9 +148,43 @@ Result bga_iocall(FsNode *node, FsHandle *handle, IOCall iocall, void *args)
     else if (iocall == IOCALL_DISPLAY_SET_MODE)
     {
         IOCallDisplayModeArgs *mode = (IOCallDisplayModeArgs *)args;
+
+        if (mode->width <= 0 || mode->height <= 0 ||
+            mode->width > VBE_DISPI_MAX_XRES || mode->height > VBE_DISPI_MAX_YRES ||
+            mode->width * mode->height * sizeof(uint32_t) > framebuffer_size)
+        {
+            return ERR_INVALID_ARGUMENT;
+        }
+
         bga_set_mode(mode->width, mode->height);
         return SUCCESS;
     }
+    else if (iocall == IOCALL_DISPLAY_MAP)
+    {
+        IOCallDisplayMapArgs *map = (IOCallDisplayMapArgs *)args;
+
+        map->handle = framebuffer_memory_object->id;
+        map->width = framebuffer_width;
+        map->height = framebuffer_height;
+        map->pitch = framebuffer_width * sizeof(uint32_t);
+        map->pages = framebuffer_pages;
+
+        return SUCCESS;
+    }
+    else if (iocall == IOCALL_DISPLAY_FLIP)
+    {
+        IOCallDisplayFlipArgs *flip = (IOCallDisplayFlipArgs *)args;
+
+        if (flip->page < 0 || flip->page >= framebuffer_pages)
+        {
+            return ERR_INVALID_ARGUMENT;
+        }
+
+        framebuffer_page = flip->page;
+        bga_write_register(VBE_DISPI_INDEX_Y_OFFSET, framebuffer_page * framebuffer_height);
+
+        return SUCCESS;
+    }
     else
     {
         return ERR_INAPPROPRIATE_CALL_FOR_DEVICE;
@@ -123,13 +199,20 @@ bool bga_match(DeviceInfo info)
 
 void bga_initialize(DeviceInfo info)
 {
+    framebuffer_size = bga_read_register(VBE_DISPI_INDEX_VIDEO_MEMORY_64K) * 64 * 1024;
+
+    if (framebuffer_size == 0)
+    {
+        framebuffer_size = VBE_DISPI_DEFAULT_MEMORY_SIZE;
+    }
+
     bga_set_mode(VBE_DISPI_DEFAULT_XRES, VBE_DISPI_DEFAULT_YRES);
     framebuffer_physical = pci_device_read_bar(info.pci_device, 0) & 0xFFFFFFF0;
     framebuffer_virtual = virtual_alloc(
                               &kpdir,
                               (MemoryRange){
                                   framebuffer_physical,
-                                  PAGE_ALIGN_UP(VBE_DISPI_MAX_XRES * VBE_DISPI_MAX_XRES * sizeof(uint32_t)),
+                                  framebuffer_size,
                               },
                               MEMORY_NONE)
                               .base;
@@ -140,6 +223,18 @@ void bga_initialize(DeviceInfo info)
         return;
     }
 
+    size_t page_count = framebuffer_size / PAGE_SIZE;
+    uintptr_t *pages = (uintptr_t *)calloc(page_count, sizeof(uintptr_t));
+
+    for (size_t i = 0; i < page_count; i++)
+    {
+        pages[i] = framebuffer_physical + i * PAGE_SIZE;
+    }
+
+    framebuffer_memory_object = memory_object_create_borrowed(framebuffer_size, pages, bga_release, nullptr);
+
+    free(pages);
+
     graphic_did_find_framebuffer();
 
     FsNode *file = __create(FsNode);
@@ -0,0 +1,612 @@
+#include <libsystem/Logger.h>
+#include <libsystem/core/CString.h>
+#include <libsystem/math/MinMax.h>
+#include <libsystem/thread/Lock.h>
+
+#include "kernel/devices/BlockCache.h"
+#include "kernel/memory/Memory.h"
+#include "kernel/scheduling/Blocker.h"
+#include "kernel/scheduling/Scheduler.h"
+#include "kernel/tasking/Task.h"
+
+// A page cache in front of the disks.
+// - Misses are read a window at a time, and reading the middle of a window
+//   start reading the next one in the background (read-ahead).
+// - Writes only dirty the cache, dirty pages are written back when they get
+//   evicted or by the flusher task, contiguous ones in a single request.
+
+#define BLOCK_CACHE_SIZE (1024)
+#define BLOCK_CACHE_BUCKETS (256)
+#define BLOCK_CACHE_READ_AHEAD (DISK_REQUEST_MAX_PAGES)
+#define BLOCK_CACHE_FLIGHTS (8)
+#define BLOCK_CACHE_FLUSH_INTERVAL (5000)
+
+#define BLOCK_CACHE_NO_FLIGHT (-1)
+
+struct BlockCacheEntry
+{
+    bool used;
+    Disk *disk;
+    size_t page;
+    uintptr_t data;
+
+    bool valid;
+    bool dirty;
+    bool referenced;
+
+    // Reading this page start reading the next window.
+    bool read_ahead;
+
+    // The request filling this page, if any.
+    int flight;
+
+    BlockCacheEntry *next_in_bucket;
+};
+
+struct BlockCacheFlight
+{
+    bool used;
+    uint generation;
+
+    Disk *disk;
+    DiskRequest request;
+    BlockCacheEntry *entries[DISK_REQUEST_MAX_PAGES];
+};
+
+static Lock _block_cache_lock;
+
+static BlockCacheEntry _entries[BLOCK_CACHE_SIZE] = {};
+static BlockCacheEntry *_buckets[BLOCK_CACHE_BUCKETS] = {};
+static size_t _clock_hand = 0;
+
+static BlockCacheFlight _flights[BLOCK_CACHE_FLIGHTS] = {};
+
+/* --- Lookup --------------------------------------------------------------- */
+
+static size_t block_cache_bucket(Disk *disk, size_t page)
+{
+    return (disk->id * 7919 + page) % BLOCK_CACHE_BUCKETS;
+}
+
+static BlockCacheEntry *block_cache_lookup(Disk *disk, size_t page)
+{
+    BlockCacheEntry *entry = _buckets[block_cache_bucket(disk, page)];
+
+    while (entry && !(entry->disk == disk && entry->page == page))
+    {
+        entry = entry->next_in_bucket;
+    }
+
+    return entry;
+}
+
+static void block_cache_hash(BlockCacheEntry *entry)
+{
+    size_t bucket = block_cache_bucket(entry->disk, entry->page);
+
+    entry->next_in_bucket = _buckets[bucket];
+    _buckets[bucket] = entry;
+}
+
+static void block_cache_unhash(BlockCacheEntry *entry)
+{
+    BlockCacheEntry **slot = &_buckets[block_cache_bucket(entry->disk, entry->page)];
+
+    while (*slot != entry)
+    {
+        slot = &(*slot)->next_in_bucket;
+    }
+
+    *slot = entry->next_in_bucket;
+    entry->next_in_bucket = nullptr;
+}
+
+static size_t block_cache_disk_pages(Disk *disk)
+{
+    return PAGE_ALIGN_UP(disk_size(disk)) / PAGE_SIZE;
+}
+
+static size_t block_cache_request_size(Disk *disk, size_t page, size_t page_count)
+{
+    return MIN(page_count * PAGE_SIZE, disk_size(disk) - page * PAGE_SIZE);
+}
+
+/* --- Write back ----------------------------------------------------------- */
+
+static bool block_cache_is_writeback_candidate(BlockCacheEntry *entry)
+{
+    return entry && entry->valid && entry->dirty && entry->flight == BLOCK_CACHE_NO_FLIGHT;
+}
+
+static Result block_cache_writeback(BlockCacheEntry *entry)
+{
+    Disk *disk = entry->disk;
+
+    // Find the begining of the run of dirty pages...
+    size_t first_page = entry->page;
+
+    while (first_page > 0 &&
+           entry->page - (first_page - 1) < DISK_REQUEST_MAX_PAGES &&
+           block_cache_is_writeback_candidate(block_cache_lookup(disk, first_page - 1)))
+    {
+        first_page--;
+    }
+
+    // ...and write it in one go.
+    BlockCacheEntry *run[DISK_REQUEST_MAX_PAGES];
+    DiskRequest request = {};
+
+    request.write = true;
+    request.sector = (uint64_t)first_page * DISK_SECTORS_PER_PAGE;
+
+    for (size_t page = first_page; request.page_count < DISK_REQUEST_MAX_PAGES; page++)
+    {
+        BlockCacheEntry *current = block_cache_lookup(disk, page);
+
+        if (!block_cache_is_writeback_candidate(current))
+        {
+            break;
+        }
+
+        run[request.page_count] = current;
+        request.pages[request.page_count] = current->data;
+        request.page_count++;
+    }
+
+    request.size = block_cache_request_size(disk, first_page, request.page_count);
+
+    Result result = disk_submit(disk, &request);
+
+    if (result == SUCCESS)
+    {
+        result = disk_request_wait(disk, &request);
+    }
+
+    if (result != SUCCESS)
+    {
+        logger_error("Failed to write back %d pages of disk %d: %s", request.page_count, disk->id, result_to_string(result));
+        return result;
+    }
+
+    for (size_t i = 0; i < request.page_count; i++)
+    {
+        run[i]->dirty = false;
+    }
+
+    return SUCCESS;
+}
+
+/* --- Eviction ------------------------------------------------------------- */
+
+static BlockCacheEntry *block_cache_evict()
+{
+    for (size_t i = 0; i < BLOCK_CACHE_SIZE * 3; i++)
+    {
+        BlockCacheEntry *entry = &_entries[_clock_hand];
+        _clock_hand = (_clock_hand + 1) % BLOCK_CACHE_SIZE;
+
+        if (entry->used)
+        {
+            if (entry->flight != BLOCK_CACHE_NO_FLIGHT)
+            {
+                continue;
+            }
+
+            if (entry->referenced)
+            {
+                entry->referenced = false;
+                continue;
+            }
+
+            if (entry->dirty && block_cache_writeback(entry) != SUCCESS)
+            {
+                continue;
+            }
+
+            block_cache_unhash(entry);
+            entry->used = false;
+        }
+
+        if (!entry->data &&
+            memory_alloc(memory_kpdir(), PAGE_SIZE, MEMORY_NONE, &entry->data) != SUCCESS)
+        {
+            return nullptr;
+        }
+
+        return entry;
+    }
+
+    return nullptr;
+}
+
+static BlockCacheEntry *block_cache_create_entry(Disk *disk, size_t page)
+{
+    BlockCacheEntry *entry = block_cache_evict();
+
+    if (!entry)
+    {
+        return nullptr;
+    }
+
+    entry->used = true;
+    entry->disk = disk;
+    entry->page = page;
+    entry->valid = false;
+    entry->dirty = false;
+    entry->referenced = false;
+    entry->read_ahead = false;
+    entry->flight = BLOCK_CACHE_NO_FLIGHT;
+
+    block_cache_hash(entry);
+
+    return entry;
+}
+
+/* --- Reads ---------------------------------------------------------------- */
+
+static void block_cache_reap(int index)
+{
+    BlockCacheFlight *flight = &_flights[index];
+
+    for (size_t i = 0; i < flight->request.page_count; i++)
+    {
+        flight->entries[i]->valid = flight->request.result == SUCCESS;
+        flight->entries[i]->flight = BLOCK_CACHE_NO_FLIGHT;
+    }
+
+    flight->used = false;
+    flight->generation++;
+}
+
+struct BlockerBlockCache : public Blocker
+{
+    int flight;
+    uint generation;
+};
+
+static void blocker_block_cache_on_block(BlockerBlockCache *blocker, Task *task)
+{
+    wait_queue_wait(&_flights[blocker->flight].disk->waiters, task);
+}
+
+static bool blocker_block_cache_can_unblock(BlockerBlockCache *blocker, Task *task)
+{
+    __unused(task);
+
+    BlockCacheFlight *flight = &_flights[blocker->flight];
+
+    return flight->generation != blocker->generation ||
+           __atomic_load_n(&flight->request.done, __ATOMIC_ACQUIRE);
+}
+
+// Wait for a read to land, the lock is released in the meantime.
+static void block_cache_wait(int index)
+{
+    BlockerBlockCache *blocker = __create(BlockerBlockCache);
+
+    TASK_BLOCKER(blocker)->on_block = (BlockerBlockCallback)blocker_block_cache_on_block;
+    TASK_BLOCKER(blocker)->can_unblock = (BlockerCanUnblockCallback)blocker_block_cache_can_unblock;
+
+    blocker->flight = index;
+    blocker->generation = _flights[index].generation;
+
+    lock_release(_block_cache_lock);
+    task_block(scheduler_running(), blocker, -1);
+    lock_acquire(_block_cache_lock);
+
+    BlockCacheFlight *flight = &_flights[index];
+
+    if (flight->used && flight->generation == blocker->generation && flight->request.done)
+    {
+        block_cache_reap(index);
+    }
+}
+
+static int block_cache_allocate_flight()
+{
+    for (int i = 0; i < BLOCK_CACHE_FLIGHTS; i++)
+    {
+        if (!_flights[i].used)
+        {
+            return i;
+        }
+    }
+
+    return BLOCK_CACHE_NO_FLIGHT;
+}
+
+// Start reading a window of pages, stopping at the first one already cached.
+// Return the number of pages being read.
+static size_t block_cache_fill(Disk *disk, size_t page)
+{
+    int index = block_cache_allocate_flight();
+
+    if (index == BLOCK_CACHE_NO_FLIGHT)
+    {
+        return 0;
+    }
+
+    BlockCacheFlight *flight = &_flights[index];
+    DiskRequest *request = &flight->request;
+
+    *request = {};
+    request->write = false;
+    request->sector = (uint64_t)page * DISK_SECTORS_PER_PAGE;
+
+    size_t last_page = MIN(page + BLOCK_CACHE_READ_AHEAD, block_cache_disk_pages(disk));
+
+    for (size_t current = page; current < last_page; current++)
+    {
+        if (block_cache_lookup(disk, current))
+        {
+            break;
+        }
+
+        BlockCacheEntry *entry = block_cache_create_entry(disk, current);
+
+        if (!entry)
+        {
+            break;
+        }
+
+        entry->flight = index;
+
+        flight->entries[request->page_count] = entry;
+        request->pages[request->page_count] = entry->data;
+        request->page_count++;
+    }
+
+    if (request->page_count == 0)
+    {
+        return 0;
+    }
+
+    if (request->page_count > 1)
+    {
+        flight->entries[request->page_count / 2]->read_ahead = true;
+    }
+
+    request->size = block_cache_request_size(disk, page, request->page_count);
+
+    // The tail of the last page is past the end of the disk.
+    if (request->size % PAGE_SIZE)
+    {
+        memset((void *)request->pages[request->page_count - 1], 0, PAGE_SIZE);
+    }
+
+    flight->used = true;
+    flight->disk = disk;
+
+    Result result = disk_submit(disk, request);
+
+    if (result != SUCCESS)
+    {
+        request->result = result;
+        block_cache_reap(index);
+    }
+
+    return request->page_count;
+}
+
+static void block_cache_read_ahead(Disk *disk, size_t page)
+{
+    size_t last_page = MIN(page + BLOCK_CACHE_READ_AHEAD, block_cache_disk_pages(disk));
+
+    while (page < last_page && block_cache_lookup(disk, page))
+    {
+        page++;
+    }
+
+    if (page < last_page)
+    {
+        block_cache_fill(disk, page);
+    }
+}
+
+static int block_cache_any_flight()
+{
+    for (int i = 0; i < BLOCK_CACHE_FLIGHTS; i++)
+    {
+        if (_flights[i].used)
+        {
+            return i;
+        }
+    }
+
+    return BLOCK_CACHE_NO_FLIGHT;
+}
+
+// Return the cache entry of a page, if the whole page is going to be
+// overwritten there is no need to read it from the disk.
+static Result block_cache_get(Disk *disk, size_t page, bool overwrite, BlockCacheEntry **out_entry)
+{
+    while (true)
+    {
+        BlockCacheEntry *entry = block_cache_lookup(disk, page);
+
+        if (entry && entry->flight != BLOCK_CACHE_NO_FLIGHT)
+        {
+            block_cache_wait(entry->flight);
+            continue;
+        }
+
+        if (entry && entry->valid)
+        {
+            *out_entry = entry;
+            return SUCCESS;
+        }
+
+        if (entry)
+        {
+            // The read failed, the next access will try again.
+            block_cache_unhash(entry);
+            entry->used = false;
+
+            return ERR_INPUT_OUTPUT_ERROR;
+        }
+
+        if (overwrite)
+        {
+            entry = block_cache_create_entry(disk, page);
+
+            if (!entry)
+            {
+                return ERR_OUT_OF_MEMORY;
+            }
+
+            entry->valid = true;
+            *out_entry = entry;
+
+            return SUCCESS;
+        }
+
+        if (block_cache_fill(disk, page) == 0)
+        {
+            // Every entries are busy, wait for some reads to complete.
+            int index = block_cache_any_flight();
+
+            if (index == BLOCK_CACHE_NO_FLIGHT)
+            {
+                return ERR_OUT_OF_MEMORY;
+            }
+
+            block_cache_wait(index);
+        }
+    }
+}
+
+/* --- Block cache API ------------------------------------------------------ */
+
+Result block_cache_read(Disk *disk, size_t offset, void *buffer, size_t size, size_t *read)
+{
+    Result result = SUCCESS;
+    *read = 0;
+
+    lock_acquire(_block_cache_lock);
+
+    while (*read < size)
+    {
+        size_t page = (offset + *read) / PAGE_SIZE;
+        size_t offset_in_page = (offset + *read) % PAGE_SIZE;
+        size_t chunk = MIN(PAGE_SIZE - offset_in_page, size - *read);
+
+        BlockCacheEntry *entry = nullptr;
+        result = block_cache_get(disk, page, false, &entry);
+
+        if (result != SUCCESS)
+        {
+            break;
+        }
+
+        if (entry->read_ahead)
+        {
+            entry->read_ahead = false;
+            block_cache_read_ahead(disk, page + 1);
+        }
+
+        memcpy((char *)buffer + *read, (char *)entry->data + offset_in_page, chunk);
+        entry->referenced = true;
+
+        *read += chunk;
+    }
+
+    lock_release(_block_cache_lock);
+
+    // Partial reads are reported as such.
+    return *read > 0 ? SUCCESS : result;
+}
+
+Result block_cache_write(Disk *disk, size_t offset, const void *buffer, size_t size, size_t *written)
+{
+    Result result = SUCCESS;
+    *written = 0;
+
+    lock_acquire(_block_cache_lock);
+
+    while (*written < size)
+    {
+        size_t page = (offset + *written) / PAGE_SIZE;
+        size_t offset_in_page = (offset + *written) % PAGE_SIZE;
+        size_t chunk = MIN(PAGE_SIZE - offset_in_page, size - *written);
+
+        BlockCacheEntry *entry = nullptr;
+        result = block_cache_get(disk, page, chunk == PAGE_SIZE, &entry);
+
+        if (result != SUCCESS)
+        {
+            break;
+        }
+
+        memcpy((char *)entry->data + offset_in_page, (const char *)buffer + *written, chunk);
+        entry->dirty = true;
+        entry->referenced = true;
+
+        *written += chunk;
+    }
+
+    lock_release(_block_cache_lock);
+
+    return *written > 0 ? SUCCESS : result;
+}
+
+void block_cache_prefetch(Disk *disk, size_t offset, size_t size)
+{
+    lock_acquire(_block_cache_lock);
+
+    size_t last_page = MIN(PAGE_ALIGN_UP(offset + size) / PAGE_SIZE, block_cache_disk_pages(disk));
+
+    for (size_t page = offset / PAGE_SIZE; page < last_page; page++)
+    {
+        if (!block_cache_lookup(disk, page) && block_cache_fill(disk, page) == 0)
+        {
+            break;
+        }
+    }
+
+    lock_release(_block_cache_lock);
+}
+
+Result block_cache_flush(Disk *disk)
+{
+    Result result = SUCCESS;
+
+    lock_acquire(_block_cache_lock);
+
+    for (size_t i = 0; i < BLOCK_CACHE_SIZE; i++)
+    {
+        BlockCacheEntry *entry = &_entries[i];
+
+        if (entry->used &&
+            (disk == nullptr || entry->disk == disk) &&
+            block_cache_is_writeback_candidate(entry))
+        {
+            Result writeback_result = block_cache_writeback(entry);
+
+            if (result == SUCCESS)
+            {
+                result = writeback_result;
+            }
+        }
+    }
+
+    lock_release(_block_cache_lock);
+
+    return result;
+}
+
+static void block_cache_flusher()
+{
+    while (true)
+    {
+        task_sleep(scheduler_running(), BLOCK_CACHE_FLUSH_INTERVAL);
+        block_cache_flush(nullptr);
+    }
+}
+
+void block_cache_initialize()
+{
+    lock_init(_block_cache_lock);
+
+    Task *flusher_task = task_spawn(nullptr, "BlockCacheFlusher", block_cache_flusher, nullptr, false);
+    task_go(flusher_task);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "kernel/devices/Disk.h"
+
+void block_cache_initialize();
+
+Result block_cache_read(Disk *disk, size_t offset, void *buffer, size_t size, size_t *read);
+
+Result block_cache_write(Disk *disk, size_t offset, const void *buffer, size_t size, size_t *written);
+
+// Start reading a range in the background, if it is not cached already.
+void block_cache_prefetch(Disk *disk, size_t offset, size_t size);
+
+// Write back the dirty pages of a disk, or of every disks if disk is nullptr.
+Result block_cache_flush(Disk *disk);
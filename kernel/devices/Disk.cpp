@@ -1,2 +1,169 @@
+#include <abi/Paths.h>
+#include <libsystem/Logger.h>
+#include <libsystem/core/CString.h>
+#include <libsystem/math/MinMax.h>
 
-#include "kernel/devices/Devices.h"
+#include "kernel/devices/BlockCache.h"
+#include "kernel/devices/Disk.h"
+#include "kernel/filesystem/Filesystem.h"
+#include "kernel/node/Handle.h"
+#include "kernel/scheduling/Blocker.h"
+#include "kernel/scheduling/Scheduler.h"
+
+static int _disk_count = 0;
+static List *_disks = nullptr;
+
+/* --- Disk requests -------------------------------------------------------- */
+
+Result disk_submit(Disk *disk, DiskRequest *request)
+{
+    request->done = false;
+    request->result = SUCCESS;
+
+    if (request->size == 0 ||
+        request->size % DISK_SECTOR_SIZE != 0 ||
+        request->size > request->page_count * PAGE_SIZE ||
+        request->sector + request->size / DISK_SECTOR_SIZE > disk->sector_count)
+    {
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    return disk->submit(disk, request);
+}
+
+void disk_request_complete(Disk *disk, DiskRequest *request, Result result)
+{
+    request->result = result;
+    __atomic_store_n(&request->done, true, __ATOMIC_RELEASE);
+
+    wait_queue_wake(&disk->waiters);
+}
+
+struct BlockerDisk : public Blocker
+{
+    Disk *disk;
+    DiskRequest *request;
+};
+
+static void blocker_disk_on_block(BlockerDisk *blocker, Task *task)
+{
+    wait_queue_wait(&blocker->disk->waiters, task);
+}
+
+static bool blocker_disk_can_unblock(BlockerDisk *blocker, Task *task)
+{
+    __unused(task);
+
+    return __atomic_load_n(&blocker->request->done, __ATOMIC_ACQUIRE);
+}
+
+Result disk_request_wait(Disk *disk, DiskRequest *request)
+{
+    BlockerDisk *blocker = __create(BlockerDisk);
+
+    TASK_BLOCKER(blocker)->on_block = (BlockerBlockCallback)blocker_disk_on_block;
+    TASK_BLOCKER(blocker)->can_unblock = (BlockerCanUnblockCallback)blocker_disk_can_unblock;
+
+    blocker->disk = disk;
+    blocker->request = request;
+
+    task_block(scheduler_running(), blocker, -1);
+
+    return request->result;
+}
+
+/* --- Disk device ---------------------------------------------------------- */
+
+struct FsDisk : public FsNode
+{
+    Disk *disk;
+};
+
+static Result disk_read(FsDisk *node, FsHandle *handle, void *buffer, size_t size, size_t *read)
+{
+    size_t disk_end = disk_size(node->disk);
+
+    if (handle->offset >= disk_end)
+    {
+        return SUCCESS;
+    }
+
+    return block_cache_read(node->disk, handle->offset, buffer, MIN(size, disk_end - handle->offset), read);
+}
+
+static Result disk_write(FsDisk *node, FsHandle *handle, const void *buffer, size_t size, size_t *written)
+{
+    size_t disk_end = disk_size(node->disk);
+
+    if (handle->offset >= disk_end)
+    {
+        return ERR_NO_SPACE_LEFT_ON_DEVICE;
+    }
+
+    return block_cache_write(node->disk, handle->offset, buffer, MIN(size, disk_end - handle->offset), written);
+}
+
+static size_t disk_node_size(FsDisk *node, FsHandle *handle)
+{
+    __unused(handle);
+
+    return disk_size(node->disk);
+}
+
+size_t disk_size(Disk *disk)
+{
+    // Offsets are 32bits wide, larger disks are truncated.
+    uint64_t size = disk->sector_count * DISK_SECTOR_SIZE;
+
+    return MIN(size, (uint64_t)0xFFFFF000);
+}
+
+void disk_iterate(void *target, DiskIterateCallback callback)
+{
+    if (!_disks)
+    {
+        return;
+    }
+
+    list_foreach(Disk, disk, _disks)
+    {
+        if (callback(target, disk) == Iteration::STOP)
+        {
+            return;
+        }
+    }
+}
+
+Disk *disk_create(uint64_t sector_count, DiskSubmitCallback submit, void *driver)
+{
+    Disk *disk = __create(Disk);
+
+    disk->id = _disk_count++;
+    disk->sector_count = sector_count;
+    disk->submit = submit;
+    disk->driver = driver;
+
+    FsDisk *node = __create(FsDisk);
+    fsnode_init(node, FILE_TYPE_DEVICE);
+
+    node->read = (FsNodeReadCallback)disk_read;
+    node->write = (FsNodeWriteCallback)disk_write;
+    node->size = (FsNodeSizeCallback)disk_node_size;
+    node->disk = disk;
+
+    char path[PATH_LENGTH];
+    snprintf(path, PATH_LENGTH, DEVICE_PATH "/disk%d", disk->id);
+
+    filesystem_link_and_take_ref_cstring(path, node);
+
+    if (!_disks)
+    {
+        _disks = list_create();
+    }
+
+    list_pushback(_disks, disk);
+
+    logger_info("Disk %d: %d Kio", disk->id, (int)(sector_count * DISK_SECTOR_SIZE / 1024));
+
+    return disk;
+}
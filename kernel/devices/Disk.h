@@ -0,0 +1,60 @@
+#pragma once
+
+#include <libsystem/Result.h>
+
+#include "kernel/memory/Paging.h"
+
+#include "kernel/scheduling/WaitQueue.h"
+
+#define DISK_SECTOR_SIZE (512)
+#define DISK_SECTORS_PER_PAGE (PAGE_SIZE / DISK_SECTOR_SIZE)
+
+// Larger transfers are split by the block cache.
+#define DISK_REQUEST_MAX_PAGES (32)
+
+struct Disk;
+
+struct DiskRequest
+{
+    bool write;
+    uint64_t sector;
+    size_t size; // In bytes, a multiple of DISK_SECTOR_SIZE.
+
+    size_t page_count;
+    uintptr_t pages[DISK_REQUEST_MAX_PAGES];
+
+    // Set by the driver once the request is completed.
+    bool done;
+    Result result;
+};
+
+// Queue the request and return immediately, the driver call
+// disk_request_complete() once the transfer is over.
+typedef Result (*DiskSubmitCallback)(struct Disk *disk, DiskRequest *request);
+
+struct Disk
+{
+    int id;
+    uint64_t sector_count;
+
+    DiskSubmitCallback submit;
+    void *driver;
+
+    // Woken up each time a request of this disk is completed.
+    WaitQueue waiters;
+};
+
+typedef Iteration (*DiskIterateCallback)(void *target, Disk *disk);
+
+void disk_iterate(void *target, DiskIterateCallback callback);
+
+Disk *disk_create(uint64_t sector_count, DiskSubmitCallback submit, void *driver);
+
+size_t disk_size(Disk *disk);
+
+Result disk_submit(Disk *disk, DiskRequest *request);
+
+void disk_request_complete(Disk *disk, DiskRequest *request, Result result);
+
+// Block the running task until the request is completed.
+Result disk_request_wait(Disk *disk, DiskRequest *request);
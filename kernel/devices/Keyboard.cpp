@@ -78,7 +78,10 @@ void keyboard_handle_key(Key key, KeyMotion motion)
                 int length = codepoint_to_utf8(codepoint, utf8);
 
                 if (_characters_node->readers)
+                {
                     ringbuffer_write(_characters_buffer, (const char *)utf8, length);
+                    fsnode_wake(_characters_node);
+                }
             }
         }
     }
@@ -105,6 +108,8 @@ void keyboard_handle_key(Key key, KeyMotion motion)
 
             ringbuffer_write(_events_buffer, (char *)&packet, sizeof(KeyboardPacket));
         }
+
+        fsnode_wake(_events_node);
     }
 
     _keystate[key] = motion;
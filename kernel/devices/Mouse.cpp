@@ -10,6 +10,7 @@
 #include "kernel/filesystem/Filesystem.h"
 #include "kernel/interrupts/Dispatcher.h"
 
+static FsNode *_mouse_node;
 static RingBuffer *_mouse_buffer;
 static int _mouse_cycle = 0;
 static uint8_t _mouse_packet[4];
@@ -49,6 +50,8 @@ static void ps2mouse_handle_finished_packet(uint8_t packet0, uint8_t packet1, ui
         logger_warn("Mouse buffer overflow!");
     }
     atomic_end();
+
+    fsnode_wake(_mouse_node);
 }
 
 void ps2mouse_handle_packet(uint8_t packet)
@@ -182,15 +185,17 @@ void mouse_initialize()
 
     // Setup the mouse handler
     _mouse_buffer = ringbuffer_create(sizeof(MousePacket) * 256);
-    dispatcher_register_handler(12, ps2mouse_interrupt_handler);
 
     FsNode *mouse_device = __create(FsNode);
+    _mouse_node = mouse_device;
 
     fsnode_init(mouse_device, FILE_TYPE_DEVICE);
 
     mouse_device->read = (FsNodeReadCallback)mouse_read;
     mouse_device->can_read = (FsNodeCanReadCallback)mouse_can_read;
 
+    dispatcher_register_handler(12, ps2mouse_interrupt_handler);
+
     Path *mouse_device_path = path_create(MOUSE_DEVICE_PATH);
     filesystem_link_and_take_ref(mouse_device_path, mouse_device);
     path_destroy(mouse_device_path);
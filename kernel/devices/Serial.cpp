@@ -10,6 +10,7 @@
 
 /* --- Serial device  node -------------------------------------------------- */
 
+static FsNode *serial_node;
 static RingBuffer *serial_buffer;
 
 void serial_interrupt_handler()
@@ -17,6 +18,7 @@ void serial_interrupt_handler()
     char byte = com_getc(COM1);
 
     ringbuffer_write(serial_buffer, (const char *)&byte, sizeof(byte));
+    fsnode_wake(serial_node);
 }
 
 bool serial_can_read(FsNode *node, FsHandle *handle)
@@ -55,15 +57,16 @@ void serial_initialize()
 {
     serial_buffer = ringbuffer_create(1024);
 
-    dispatcher_register_handler(4, serial_interrupt_handler);
-
     FsNode *serial_device = __create(FsNode);
+    serial_node = serial_device;
     fsnode_init(serial_device, FILE_TYPE_DEVICE);
 
     serial_device->can_read = (FsNodeCanReadCallback)serial_can_read;
     serial_device->read = (FsNodeReadCallback)serial_read;
     serial_device->write = (FsNodeWriteCallback)serial_write;
 
+    dispatcher_register_handler(4, serial_interrupt_handler);
+
     Path *serial_device_path = path_create(SERIAL_DEVICE_PATH);
     filesystem_link_and_take_ref(serial_device_path, serial_device);
     path_destroy(serial_device_path);
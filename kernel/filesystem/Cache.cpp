@@ -0,0 +1,186 @@
+#include <libsystem/Assert.h>
+#include <libsystem/core/CString.h>
+#include <libsystem/thread/Lock.h>
+#include <libsystem/utils/Hash.h>
+
+#include "kernel/filesystem/Cache.h"
+
+// Direct mapped cache of successful path lookups, entries are dropped when
+// the filesystem changes under their path (link, unlink or rename).
+
+#define FILESYSTEM_CACHE_SIZE 256
+
+struct FilesystemCacheEntry
+{
+    uint32_t hash;
+    char *path;
+    FsNode *node;
+};
+
+static FilesystemCacheEntry _cache[FILESYSTEM_CACHE_SIZE] = {};
+static Lock _cache_lock;
+
+// Bumped on invalidation so lookups racing with an unlink don't insert stale nodes.
+static uint32_t _cache_generation = 0;
+
+static FilesystemCacheStats _cache_stats = {};
+
+void filesystem_cache_initialize()
+{
+    lock_init(_cache_lock);
+}
+
+static bool filesystem_cache_key(Path *path, char *buffer, size_t size)
+{
+    size_t length = 0;
+
+    for (size_t i = 0; i < path_element_count(path); i++)
+    {
+        const char *element = path_peek_at(path, i);
+        size_t element_length = strlen(element);
+
+        if (length + 1 + element_length + 1 > size)
+        {
+            return false;
+        }
+
+        buffer[length++] = PATH_SEPARATOR;
+        memcpy(buffer + length, element, element_length);
+        length += element_length;
+    }
+
+    if (length == 0)
+    {
+        buffer[length++] = PATH_SEPARATOR;
+    }
+
+    buffer[length] = '\0';
+
+    return true;
+}
+
+static void filesystem_cache_evict(FilesystemCacheEntry &entry)
+{
+    if (entry.node)
+    {
+        fsnode_deref(entry.node);
+        free(entry.path);
+    }
+
+    entry = {};
+}
+
+FsNode *filesystem_cache_lookup_and_ref(Path *path, uint32_t *generation)
+{
+    char key[PATH_LENGTH];
+
+    lock_acquire(_cache_lock);
+
+    _cache_stats.lookups++;
+    *generation = _cache_generation;
+
+    FsNode *node = nullptr;
+
+    if (filesystem_cache_key(path, key, PATH_LENGTH))
+    {
+        uint32_t hash = hash_string(key);
+        FilesystemCacheEntry &entry = _cache[hash % FILESYSTEM_CACHE_SIZE];
+
+        if (entry.node && entry.hash == hash && strcmp(entry.path, key) == 0)
+        {
+            node = fsnode_ref(entry.node);
+        }
+    }
+
+    if (node)
+    {
+        _cache_stats.hits++;
+    }
+    else
+    {
+        _cache_stats.misses++;
+    }
+
+    lock_release(_cache_lock);
+
+    return node;
+}
+
+void filesystem_cache_insert(Path *path, FsNode *node, uint32_t generation)
+{
+    char key[PATH_LENGTH];
+
+    if (!filesystem_cache_key(path, key, PATH_LENGTH))
+    {
+        return;
+    }
+
+    uint32_t hash = hash_string(key);
+
+    lock_acquire(_cache_lock);
+
+    if (generation == _cache_generation)
+    {
+        FilesystemCacheEntry &entry = _cache[hash % FILESYSTEM_CACHE_SIZE];
+
+        filesystem_cache_evict(entry);
+
+        entry.hash = hash;
+        entry.path = strdup(key);
+        entry.node = fsnode_ref(node);
+    }
+
+    lock_release(_cache_lock);
+}
+
+void filesystem_cache_invalidate(Path *path)
+{
+    char key[PATH_LENGTH];
+
+    bool has_key = filesystem_cache_key(path, key, PATH_LENGTH);
+    size_t key_length = has_key ? strlen(key) : 0;
+
+    lock_acquire(_cache_lock);
+
+    _cache_generation++;
+    _cache_stats.invalidations++;
+
+    for (size_t i = 0; i < FILESYSTEM_CACHE_SIZE; i++)
+    {
+        FilesystemCacheEntry &entry = _cache[i];
+
+        if (!entry.node)
+        {
+            continue;
+        }
+
+        // Drop the path and everything under it, or everything if the path
+        // was too long to make a key.
+        bool stale = !has_key ||
+                     (strncmp(entry.path, key, key_length) == 0 &&
+                      (entry.path[key_length] == '\0' || entry.path[key_length] == PATH_SEPARATOR));
+
+        if (stale)
+        {
+            filesystem_cache_evict(entry);
+        }
+    }
+
+    lock_release(_cache_lock);
+}
+
+void filesystem_cache_account_walk(size_t elements)
+{
+    lock_acquire(_cache_lock);
+    _cache_stats.walked += elements;
+    lock_release(_cache_lock);
+}
+
+FilesystemCacheStats filesystem_cache_stats()
+{
+    lock_acquire(_cache_lock);
+    FilesystemCacheStats stats = _cache_stats;
+    lock_release(_cache_lock);
+
+    return stats;
+}
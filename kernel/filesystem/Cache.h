@@ -0,0 +1,30 @@
+#pragma once
+
+#include <libsystem/io/Path.h>
+
+#include "kernel/node/Node.h"
+
+struct FilesystemCacheStats
+{
+    size_t lookups;
+    size_t hits;
+    size_t misses;
+
+    // Path elements resolved through directories, divide by lookups to get
+    // the average cost of a lookup.
+    size_t walked;
+
+    size_t invalidations;
+};
+
+void filesystem_cache_initialize();
+
+FsNode *filesystem_cache_lookup_and_ref(Path *path, uint32_t *generation);
+
+void filesystem_cache_insert(Path *path, FsNode *node, uint32_t generation);
+
+void filesystem_cache_invalidate(Path *path);
+
+void filesystem_cache_account_walk(size_t elements);
+
+FilesystemCacheStats filesystem_cache_stats();
@@ -0,0 +1,566 @@
+#include <libsystem/Logger.h>
+#include <libsystem/core/CString.h>
+#include <libsystem/math/MinMax.h>
+
+#include "arch/Arch.h"
+#include "kernel/devices/BlockCache.h"
+#include "kernel/filesystem/Ext2.h"
+
+/* --- Disk access ---------------------------------------------------------- */
+
+Result ext2_read(Ext2Filesystem *filesystem, size_t offset, void *buffer, size_t size)
+{
+    size_t read = 0;
+    Result result = block_cache_read(filesystem->disk, offset, buffer, size, &read);
+
+    if (result == SUCCESS && read != size)
+    {
+        result = ERR_INPUT_OUTPUT_ERROR;
+    }
+
+    return result;
+}
+
+Result ext2_write(Ext2Filesystem *filesystem, size_t offset, const void *buffer, size_t size)
+{
+    size_t written = 0;
+    Result result = block_cache_write(filesystem->disk, offset, buffer, size, &written);
+
+    if (result == SUCCESS && written != size)
+    {
+        result = ERR_INPUT_OUTPUT_ERROR;
+    }
+
+    return result;
+}
+
+size_t ext2_block_offset(Ext2Filesystem *filesystem, uint32_t block)
+{
+    return (size_t)block * filesystem->block_size;
+}
+
+static Result ext2_write_superblock(Ext2Filesystem *filesystem)
+{
+    return ext2_write(filesystem, EXT2_SUPERBLOCK_OFFSET, &filesystem->superblock, sizeof(Ext2Superblock));
+}
+
+static Result ext2_write_group(Ext2Filesystem *filesystem, uint32_t group)
+{
+    return ext2_write(
+        filesystem,
+        ext2_block_offset(filesystem, filesystem->groups_block) + group * sizeof(Ext2GroupDescriptor),
+        &filesystem->groups[group],
+        sizeof(Ext2GroupDescriptor));
+}
+
+/* --- Bitmaps -------------------------------------------------------------- */
+
+static Result ext2_bitmap_allocate(Ext2Filesystem *filesystem, uint32_t bitmap, size_t bits, size_t *index)
+{
+    uint8_t *buffer = (uint8_t *)malloc(filesystem->block_size);
+
+    Result result = ext2_read(filesystem, ext2_block_offset(filesystem, bitmap), buffer, filesystem->block_size);
+
+    if (result != SUCCESS)
+    {
+        free(buffer);
+        return result;
+    }
+
+    result = ERR_NO_SPACE_LEFT_ON_DEVICE;
+
+    for (size_t i = 0; i < bits; i++)
+    {
+        if (buffer[i / 8] == 0xff)
+        {
+            i += 7;
+            continue;
+        }
+
+        if (!(buffer[i / 8] & (1 << (i % 8))))
+        {
+            buffer[i / 8] |= 1 << (i % 8);
+
+            result = ext2_write(filesystem, ext2_block_offset(filesystem, bitmap) + i / 8, &buffer[i / 8], 1);
+            *index = i;
+
+            break;
+        }
+    }
+
+    free(buffer);
+
+    return result;
+}
+
+static void ext2_bitmap_free(Ext2Filesystem *filesystem, uint32_t bitmap, size_t index)
+{
+    size_t offset = ext2_block_offset(filesystem, bitmap) + index / 8;
+    uint8_t byte = 0;
+
+    if (ext2_read(filesystem, offset, &byte, 1) == SUCCESS)
+    {
+        byte &= ~(1 << (index % 8));
+        ext2_write(filesystem, offset, &byte, 1);
+    }
+}
+
+/* --- Blocks --------------------------------------------------------------- */
+
+static Result ext2_allocate_block(Ext2Filesystem *filesystem, uint32_t group_hint, uint32_t *block)
+{
+    Ext2Superblock &superblock = filesystem->superblock;
+
+    lock_acquire(filesystem->lock);
+
+    for (size_t i = 0; i < filesystem->groups_count; i++)
+    {
+        uint32_t group = (group_hint + i) % filesystem->groups_count;
+
+        if (filesystem->groups[group].free_blocks_count == 0)
+        {
+            continue;
+        }
+
+        uint32_t first_block = superblock.first_data_block + group * superblock.blocks_per_group;
+        size_t bits = MIN(superblock.blocks_per_group, superblock.blocks_count - first_block);
+
+        size_t index = 0;
+
+        if (ext2_bitmap_allocate(filesystem, filesystem->groups[group].block_bitmap, bits, &index) != SUCCESS)
+        {
+            continue;
+        }
+
+        filesystem->groups[group].free_blocks_count--;
+        superblock.free_blocks_count--;
+
+        ext2_write_group(filesystem, group);
+        ext2_write_superblock(filesystem);
+
+        lock_release(filesystem->lock);
+
+        *block = first_block + index;
+
+        // Don't leak what was there before.
+        return ext2_write(filesystem, ext2_block_offset(filesystem, *block), filesystem->zeros, filesystem->block_size);
+    }
+
+    lock_release(filesystem->lock);
+
+    return ERR_NO_SPACE_LEFT_ON_DEVICE;
+}
+
+static void ext2_free_block(Ext2Filesystem *filesystem, uint32_t block)
+{
+    Ext2Superblock &superblock = filesystem->superblock;
+
+    if (block < superblock.first_data_block || block >= superblock.blocks_count)
+    {
+        logger_warn("Trying to free block %d which is out of the volume!", block);
+        return;
+    }
+
+    uint32_t group = (block - superblock.first_data_block) / superblock.blocks_per_group;
+    uint32_t index = (block - superblock.first_data_block) % superblock.blocks_per_group;
+
+    lock_acquire(filesystem->lock);
+
+    ext2_bitmap_free(filesystem, filesystem->groups[group].block_bitmap, index);
+
+    filesystem->groups[group].free_blocks_count++;
+    superblock.free_blocks_count++;
+
+    ext2_write_group(filesystem, group);
+    ext2_write_superblock(filesystem);
+
+    lock_release(filesystem->lock);
+}
+
+/* --- Inodes --------------------------------------------------------------- */
+
+uint32_t ext2_inode_group(Ext2Filesystem *filesystem, uint32_t number)
+{
+    return (number - 1) / filesystem->superblock.inodes_per_group;
+}
+
+static Result ext2_inode_offset(Ext2Filesystem *filesystem, uint32_t number, size_t *offset)
+{
+    if (number == 0 || number > filesystem->superblock.inodes_count)
+    {
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    uint32_t group = ext2_inode_group(filesystem, number);
+    uint32_t index = (number - 1) % filesystem->superblock.inodes_per_group;
+
+    *offset = ext2_block_offset(filesystem, filesystem->groups[group].inode_table) + index * filesystem->inode_size;
+
+    return SUCCESS;
+}
+
+Result ext2_read_inode(Ext2Filesystem *filesystem, uint32_t number, Ext2Inode *inode)
+{
+    size_t offset = 0;
+    Result result = ext2_inode_offset(filesystem, number, &offset);
+
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    return ext2_read(filesystem, offset, inode, sizeof(Ext2Inode));
+}
+
+Result ext2_write_inode(Ext2Filesystem *filesystem, uint32_t number, Ext2Inode *inode)
+{
+    size_t offset = 0;
+    Result result = ext2_inode_offset(filesystem, number, &offset);
+
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    return ext2_write(filesystem, offset, inode, sizeof(Ext2Inode));
+}
+
+Result ext2_allocate_inode(Ext2Filesystem *filesystem, uint32_t group_hint, bool directory, uint32_t *number)
+{
+    Ext2Superblock &superblock = filesystem->superblock;
+
+    lock_acquire(filesystem->lock);
+
+    for (size_t i = 0; i < filesystem->groups_count; i++)
+    {
+        uint32_t group = (group_hint + i) % filesystem->groups_count;
+
+        if (filesystem->groups[group].free_inodes_count == 0)
+        {
+            continue;
+        }
+
+        size_t index = 0;
+
+        if (ext2_bitmap_allocate(filesystem, filesystem->groups[group].inode_bitmap, superblock.inodes_per_group, &index) != SUCCESS)
+        {
+            continue;
+        }
+
+        filesystem->groups[group].free_inodes_count--;
+        superblock.free_inodes_count--;
+
+        if (directory)
+        {
+            filesystem->groups[group].used_directories_count++;
+        }
+
+        ext2_write_group(filesystem, group);
+        ext2_write_superblock(filesystem);
+
+        lock_release(filesystem->lock);
+
+        *number = group * superblock.inodes_per_group + index + 1;
+
+        return SUCCESS;
+    }
+
+    lock_release(filesystem->lock);
+
+    return ERR_NO_SPACE_LEFT_ON_DEVICE;
+}
+
+void ext2_free_inode(Ext2Filesystem *filesystem, uint32_t number, bool directory)
+{
+    uint32_t group = ext2_inode_group(filesystem, number);
+    uint32_t index = (number - 1) % filesystem->superblock.inodes_per_group;
+
+    lock_acquire(filesystem->lock);
+
+    ext2_bitmap_free(filesystem, filesystem->groups[group].inode_bitmap, index);
+
+    filesystem->groups[group].free_inodes_count++;
+    filesystem->superblock.free_inodes_count++;
+
+    if (directory)
+    {
+        filesystem->groups[group].used_directories_count--;
+    }
+
+    ext2_write_group(filesystem, group);
+    ext2_write_superblock(filesystem);
+
+    lock_release(filesystem->lock);
+}
+
+/* --- Inode blocks --------------------------------------------------------- */
+
+static Result ext2_allocate_inode_block(Ext2Filesystem *filesystem, Ext2Inode *inode, uint32_t group_hint, uint32_t *block)
+{
+    Result result = ext2_allocate_block(filesystem, group_hint, block);
+
+    if (result == SUCCESS)
+    {
+        inode->sectors += filesystem->block_size / DISK_SECTOR_SIZE;
+    }
+
+    return result;
+}
+
+Result ext2_inode_block(Ext2Filesystem *filesystem, Ext2Inode *inode, uint32_t group_hint, size_t index, bool allocate, uint32_t *block)
+{
+    size_t pointers = filesystem->block_size / sizeof(uint32_t);
+
+    size_t root = 0;
+    int depth = 0;
+
+    if (index < EXT2_DIRECT_BLOCKS)
+    {
+        root = index;
+    }
+    else if ((index -= EXT2_DIRECT_BLOCKS) < pointers)
+    {
+        root = EXT2_INDIRECT_BLOCK;
+        depth = 1;
+    }
+    else if ((index -= pointers) < pointers * pointers)
+    {
+        root = EXT2_DOUBLY_INDIRECT_BLOCK;
+        depth = 2;
+    }
+    else if ((index -= pointers * pointers) < pointers * pointers * pointers)
+    {
+        root = EXT2_TRIPLY_INDIRECT_BLOCK;
+        depth = 3;
+    }
+    else
+    {
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    *block = 0;
+
+    if (inode->blocks[root] == 0)
+    {
+        if (!allocate)
+        {
+            return SUCCESS;
+        }
+
+        uint32_t allocated = 0;
+        Result result = ext2_allocate_inode_block(filesystem, inode, group_hint, &allocated);
+
+        if (result != SUCCESS)
+        {
+            return result;
+        }
+
+        inode->blocks[root] = allocated;
+    }
+
+    uint32_t current = inode->blocks[root];
+
+    for (int level = depth - 1; level >= 0; level--)
+    {
+        size_t divisor = 1;
+
+        for (int i = 0; i < level; i++)
+        {
+            divisor *= pointers;
+        }
+
+        size_t slot_offset = ext2_block_offset(filesystem, current) + ((index / divisor) % pointers) * sizeof(uint32_t);
+
+        uint32_t next = 0;
+        Result result = ext2_read(filesystem, slot_offset, &next, sizeof(uint32_t));
+
+        if (result != SUCCESS)
+        {
+            return result;
+        }
+
+        if (next == 0)
+        {
+            if (!allocate)
+            {
+                return SUCCESS;
+            }
+
+            result = ext2_allocate_inode_block(filesystem, inode, group_hint, &next);
+
+            if (result == SUCCESS)
+            {
+                result = ext2_write(filesystem, slot_offset, &next, sizeof(uint32_t));
+            }
+
+            if (result != SUCCESS)
+            {
+                return result;
+            }
+        }
+
+        current = next;
+    }
+
+    *block = current;
+
+    return SUCCESS;
+}
+
+static void ext2_free_blocks_tree(Ext2Filesystem *filesystem, uint32_t block, int depth)
+{
+    if (block == 0)
+    {
+        return;
+    }
+
+    if (depth > 0)
+    {
+        uint32_t *pointers = (uint32_t *)malloc(filesystem->block_size);
+
+        if (ext2_read(filesystem, ext2_block_offset(filesystem, block), pointers, filesystem->block_size) == SUCCESS)
+        {
+            for (size_t i = 0; i < filesystem->block_size / sizeof(uint32_t); i++)
+            {
+                ext2_free_blocks_tree(filesystem, pointers[i], depth - 1);
+            }
+        }
+
+        free(pointers);
+    }
+
+    ext2_free_block(filesystem, block);
+}
+
+void ext2_inode_truncate(Ext2Filesystem *filesystem, Ext2Inode *inode)
+{
+    // Fast symbolic links keep their target in the block pointers.
+    bool has_blocks = !((inode->mode & EXT2_MODE_TYPE_MASK) == EXT2_MODE_SYMBOLIC_LINK && inode->sectors == 0);
+
+    if (has_blocks)
+    {
+        for (size_t i = 0; i < EXT2_DIRECT_BLOCKS; i++)
+        {
+            ext2_free_blocks_tree(filesystem, inode->blocks[i], 0);
+        }
+
+        ext2_free_blocks_tree(filesystem, inode->blocks[EXT2_INDIRECT_BLOCK], 1);
+        ext2_free_blocks_tree(filesystem, inode->blocks[EXT2_DOUBLY_INDIRECT_BLOCK], 2);
+        ext2_free_blocks_tree(filesystem, inode->blocks[EXT2_TRIPLY_INDIRECT_BLOCK], 3);
+    }
+
+    memset(inode->blocks, 0, sizeof(inode->blocks));
+    inode->sectors = 0;
+    inode->size = 0;
+    inode->modification_time = arch_get_time();
+}
+
+/* --- Mounting ------------------------------------------------------------- */
+
+Result ext2_mount(Disk *disk, FsNode **root)
+{
+    *root = nullptr;
+
+    Ext2Filesystem *filesystem = __create(Ext2Filesystem);
+    filesystem->disk = disk;
+    lock_init(filesystem->lock);
+
+    Ext2Superblock &superblock = filesystem->superblock;
+
+    Result result = ext2_read(filesystem, EXT2_SUPERBLOCK_OFFSET, &superblock, sizeof(Ext2Superblock));
+
+    if (result != SUCCESS)
+    {
+        goto cleanup_and_return;
+    }
+
+    if (superblock.magic != EXT2_MAGIC ||
+        superblock.blocks_per_group == 0 ||
+        superblock.inodes_per_group == 0)
+    {
+        result = ERR_INVALID_ARGUMENT;
+        goto cleanup_and_return;
+    }
+
+    filesystem->block_size = 1024 << superblock.log_block_size;
+
+    if (superblock.revision == EXT2_GOOD_OLD_REVISION)
+    {
+        filesystem->inode_size = EXT2_GOOD_OLD_INODE_SIZE;
+        filesystem->first_inode = EXT2_GOOD_OLD_FIRST_INODE;
+    }
+    else
+    {
+        filesystem->inode_size = superblock.inode_size;
+        filesystem->first_inode = superblock.first_inode;
+
+        if (superblock.features_incompatible & ~EXT2_FEATURE_INCOMPAT_FILETYPE)
+        {
+            logger_error("Disk %d: unsupported ext2 features %x", disk->id, superblock.features_incompatible);
+            result = ERR_OPERATION_NOT_SUPPORTED;
+            goto cleanup_and_return;
+        }
+
+        filesystem->read_only = superblock.features_read_only &
+                                ~(EXT2_FEATURE_RO_COMPAT_SPARSE_SUPER | EXT2_FEATURE_RO_COMPAT_LARGE_FILE);
+    }
+
+    if (filesystem->block_size > PAGE_SIZE || filesystem->inode_size < sizeof(Ext2Inode))
+    {
+        result = ERR_OPERATION_NOT_SUPPORTED;
+        goto cleanup_and_return;
+    }
+
+    filesystem->groups_count = __align_up(superblock.blocks_count - superblock.first_data_block, superblock.blocks_per_group) / superblock.blocks_per_group;
+    filesystem->groups_block = superblock.first_data_block + 1;
+    filesystem->groups = (Ext2GroupDescriptor *)calloc(filesystem->groups_count, sizeof(Ext2GroupDescriptor));
+
+    result = ext2_read(
+        filesystem,
+        ext2_block_offset(filesystem, filesystem->groups_block),
+        filesystem->groups,
+        filesystem->groups_count * sizeof(Ext2GroupDescriptor));
+
+    if (result != SUCCESS)
+    {
+        goto cleanup_and_return;
+    }
+
+    filesystem->zeros = calloc(1, filesystem->block_size);
+
+    *root = ext2_node_get(filesystem, EXT2_ROOT_INODE);
+
+    if (*root == nullptr || (*root)->type != FILE_TYPE_DIRECTORY)
+    {
+        result = ERR_INPUT_OUTPUT_ERROR;
+        goto cleanup_and_return;
+    }
+
+    if (!filesystem->read_only)
+    {
+        superblock.mount_count++;
+        superblock.mount_time = arch_get_time();
+        ext2_write_superblock(filesystem);
+    }
+
+    logger_info("Disk %d: ext2 volume of %d Kio (%d Kio free)%s",
+                disk->id,
+                superblock.blocks_count * (filesystem->block_size / 1024),
+                superblock.free_blocks_count * (filesystem->block_size / 1024),
+                filesystem->read_only ? ", read-only" : "");
+
+    return SUCCESS;
+
+cleanup_and_return:
+    if (*root)
+    {
+        fsnode_deref(*root);
+        *root = nullptr;
+    }
+
+    free(filesystem->zeros);
+    free(filesystem->groups);
+    free(filesystem);
+
+    return result;
+}
@@ -0,0 +1,202 @@
+#pragma once
+
+#include <libsystem/thread/Lock.h>
+
+#include "kernel/devices/Disk.h"
+#include "kernel/node/Node.h"
+
+// The Second Extended Filesystem, as described by "The Second Extended File
+// System: Internal Layout" (https://www.nongnu.org/ext2-doc/ext2.html).
+
+#define EXT2_MAGIC (0xEF53)
+#define EXT2_SUPERBLOCK_OFFSET (1024)
+#define EXT2_ROOT_INODE (2)
+
+#define EXT2_DIRECT_BLOCKS (12)
+#define EXT2_INDIRECT_BLOCK (12)
+#define EXT2_DOUBLY_INDIRECT_BLOCK (13)
+#define EXT2_TRIPLY_INDIRECT_BLOCK (14)
+#define EXT2_BLOCK_POINTERS (15)
+
+#define EXT2_GOOD_OLD_REVISION (0)
+#define EXT2_GOOD_OLD_INODE_SIZE (128)
+#define EXT2_GOOD_OLD_FIRST_INODE (11)
+
+#define EXT2_FEATURE_INCOMPAT_FILETYPE (0x0002)
+
+#define EXT2_FEATURE_RO_COMPAT_SPARSE_SUPER (0x0001)
+#define EXT2_FEATURE_RO_COMPAT_LARGE_FILE (0x0002)
+
+#define EXT2_MODE_TYPE_MASK (0xF000)
+#define EXT2_MODE_DIRECTORY (0x4000)
+#define EXT2_MODE_REGULAR (0x8000)
+#define EXT2_MODE_SYMBOLIC_LINK (0xA000)
+
+#define EXT2_DIRECTORY_ENTRY_UNKNOWN (0)
+#define EXT2_DIRECTORY_ENTRY_REGULAR (1)
+#define EXT2_DIRECTORY_ENTRY_DIRECTORY (2)
+
+#define EXT2_NAME_LENGTH (255)
+
+struct __packed Ext2Superblock
+{
+    uint32_t inodes_count;
+    uint32_t blocks_count;
+    uint32_t reserved_blocks_count;
+    uint32_t free_blocks_count;
+    uint32_t free_inodes_count;
+    uint32_t first_data_block;
+    uint32_t log_block_size;
+    uint32_t log_fragment_size;
+    uint32_t blocks_per_group;
+    uint32_t fragments_per_group;
+    uint32_t inodes_per_group;
+    uint32_t mount_time;
+    uint32_t write_time;
+    uint16_t mount_count;
+    uint16_t max_mount_count;
+    uint16_t magic;
+    uint16_t state;
+    uint16_t errors;
+    uint16_t minor_revision;
+    uint32_t last_check;
+    uint32_t check_interval;
+    uint32_t creator_os;
+    uint32_t revision;
+    uint16_t reserved_uid;
+    uint16_t reserved_gid;
+
+    // EXT2_DYNAMIC_REV only
+    uint32_t first_inode;
+    uint16_t inode_size;
+    uint16_t block_group;
+    uint32_t features_compatible;
+    uint32_t features_incompatible;
+    uint32_t features_read_only;
+    uint8_t uuid[16];
+    char volume_name[16];
+    char last_mounted[64];
+    uint32_t algorithm_bitmap;
+
+    uint8_t unused[820];
+};
+
+struct __packed Ext2GroupDescriptor
+{
+    uint32_t block_bitmap;
+    uint32_t inode_bitmap;
+    uint32_t inode_table;
+    uint16_t free_blocks_count;
+    uint16_t free_inodes_count;
+    uint16_t used_directories_count;
+    uint16_t padding;
+    uint8_t reserved[12];
+};
+
+struct __packed Ext2Inode
+{
+    uint16_t mode;
+    uint16_t uid;
+    uint32_t size;
+    uint32_t access_time;
+    uint32_t creation_time;
+    uint32_t modification_time;
+    uint32_t deletion_time;
+    uint16_t gid;
+    uint16_t links_count;
+    uint32_t sectors; // In 512 bytes units, whatever the block size is.
+    uint32_t flags;
+    uint32_t os_specific1;
+    uint32_t blocks[EXT2_BLOCK_POINTERS];
+    uint32_t generation;
+    uint32_t file_acl;
+    uint32_t directory_acl;
+    uint32_t fragment_address;
+    uint8_t os_specific2[12];
+};
+
+struct __packed Ext2DirectoryEntry
+{
+    uint32_t inode;
+    uint16_t record_length;
+    uint8_t name_length;
+    uint8_t file_type;
+    char name[];
+};
+
+#define EXT2_NODE_BUCKETS (64)
+
+struct Ext2Node;
+
+struct Ext2Filesystem
+{
+    Disk *disk;
+    Lock lock;
+    bool read_only;
+
+    Ext2Superblock superblock;
+    size_t block_size;
+    size_t inode_size;
+    size_t first_inode;
+
+    size_t groups_count;
+    uint32_t groups_block;
+    Ext2GroupDescriptor *groups;
+
+    void *zeros;
+
+    // Inodes currently loaded, by number.
+    Ext2Node *nodes[EXT2_NODE_BUCKETS];
+};
+
+struct Ext2Node : public FsNode
+{
+    Ext2Filesystem *filesystem;
+    uint32_t number;
+    Ext2Inode inode;
+
+    Ext2Node *next_in_bucket;
+
+    // The inode is freed when the last reference goes away.
+    bool deleted;
+
+    // Directories only have one name on disk, a second one only
+    // exists in the middle of a rename.
+    int directory_names;
+
+    // Sequential reads detection.
+    size_t last_read_end;
+    size_t read_ahead_end;
+};
+
+Result ext2_mount(Disk *disk, FsNode **root);
+
+/* --- Ext2.cpp ------------------------------------------------------------- */
+
+Result ext2_read(Ext2Filesystem *filesystem, size_t offset, void *buffer, size_t size);
+
+Result ext2_write(Ext2Filesystem *filesystem, size_t offset, const void *buffer, size_t size);
+
+size_t ext2_block_offset(Ext2Filesystem *filesystem, uint32_t block);
+
+uint32_t ext2_inode_group(Ext2Filesystem *filesystem, uint32_t number);
+
+Result ext2_read_inode(Ext2Filesystem *filesystem, uint32_t number, Ext2Inode *inode);
+
+Result ext2_write_inode(Ext2Filesystem *filesystem, uint32_t number, Ext2Inode *inode);
+
+Result ext2_allocate_inode(Ext2Filesystem *filesystem, uint32_t group_hint, bool directory, uint32_t *number);
+
+void ext2_free_inode(Ext2Filesystem *filesystem, uint32_t number, bool directory);
+
+// Find the disk block holding a block of an inode, holes are returned as block 0
+// unless allocate is true, in which case the block (and the indirect blocks
+// leading to it) are allocated and zeroed.
+Result ext2_inode_block(Ext2Filesystem *filesystem, Ext2Inode *inode, uint32_t group_hint, size_t index, bool allocate, uint32_t *block);
+
+// Free every blocks of an inode.
+void ext2_inode_truncate(Ext2Filesystem *filesystem, Ext2Inode *inode);
+
+/* --- Ext2Node.cpp --------------------------------------------------------- */
+
+Ext2Node *ext2_node_get(Ext2Filesystem *filesystem, uint32_t number);
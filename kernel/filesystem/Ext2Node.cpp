@@ -0,0 +1,1076 @@
+#include <libsystem/Logger.h>
+#include <libsystem/core/CString.h>
+#include <libsystem/math/MinMax.h>
+
+#include "arch/Arch.h"
+#include "kernel/devices/BlockCache.h"
+#include "kernel/filesystem/Ext2.h"
+#include "kernel/node/Directory.h"
+#include "kernel/node/Handle.h"
+
+// How far ahead of a sequential reader the content of a file is prefetched.
+#define EXT2_READ_AHEAD (128 * 1024)
+
+#define EXT2_DIRECTORY_ENTRY_SIZE(__name_length) __align_up(sizeof(Ext2DirectoryEntry) + (__name_length), 4)
+
+static void ext2_node_destroy(Ext2Node *node);
+
+static bool ext2_is_node_of(FsNode *node, Ext2Filesystem *filesystem)
+{
+    return node->destroy == (FsNodeDestroyCallback)ext2_node_destroy &&
+           ((Ext2Node *)node)->filesystem == filesystem;
+}
+
+static Result ext2_node_write_inode(Ext2Node *node)
+{
+    return ext2_write_inode(node->filesystem, node->number, &node->inode);
+}
+
+static uint32_t ext2_node_group(Ext2Node *node)
+{
+    return ext2_inode_group(node->filesystem, node->number);
+}
+
+/* --- Directories ---------------------------------------------------------- */
+
+typedef Iteration (*Ext2DirectoryIterateCallback)(void *target, Ext2DirectoryEntry *entry);
+
+static Result ext2_directory_iterate(Ext2Node *directory, void *target, Ext2DirectoryIterateCallback callback)
+{
+    Ext2Filesystem *filesystem = directory->filesystem;
+    uint8_t *buffer = (uint8_t *)malloc(filesystem->block_size);
+    Result result = SUCCESS;
+
+    for (size_t index = 0; index * filesystem->block_size < directory->inode.size; index++)
+    {
+        uint32_t block = 0;
+        result = ext2_inode_block(filesystem, &directory->inode, 0, index, false, &block);
+
+        if (result != SUCCESS)
+        {
+            break;
+        }
+
+        if (block == 0)
+        {
+            continue;
+        }
+
+        result = ext2_read(filesystem, ext2_block_offset(filesystem, block), buffer, filesystem->block_size);
+
+        if (result != SUCCESS)
+        {
+            break;
+        }
+
+        for (size_t position = 0; position + sizeof(Ext2DirectoryEntry) <= filesystem->block_size;)
+        {
+            Ext2DirectoryEntry *entry = (Ext2DirectoryEntry *)(buffer + position);
+
+            if (entry->record_length < sizeof(Ext2DirectoryEntry) ||
+                position + entry->record_length > filesystem->block_size)
+            {
+                logger_error("Corrupted directory entry in inode %d", directory->number);
+                break;
+            }
+
+            if (entry->inode != 0 && callback(target, entry) == Iteration::STOP)
+            {
+                free(buffer);
+                return SUCCESS;
+            }
+
+            position += entry->record_length;
+        }
+    }
+
+    free(buffer);
+
+    return result;
+}
+
+static bool ext2_directory_entry_is(Ext2DirectoryEntry *entry, const char *name)
+{
+    return entry->name_length == strlen(name) &&
+           memcmp(entry->name, name, entry->name_length) == 0;
+}
+
+static bool ext2_directory_entry_is_dot_or_dot_dot(Ext2DirectoryEntry *entry)
+{
+    return ext2_directory_entry_is(entry, ".") || ext2_directory_entry_is(entry, "..");
+}
+
+struct Ext2DirectorySearch
+{
+    const char *name;
+    uint32_t inode;
+};
+
+static Iteration ext2_directory_search_callback(Ext2DirectorySearch *search, Ext2DirectoryEntry *entry)
+{
+    if (ext2_directory_entry_is(entry, search->name))
+    {
+        search->inode = entry->inode;
+        return Iteration::STOP;
+    }
+
+    return Iteration::CONTINUE;
+}
+
+static uint32_t ext2_directory_search(Ext2Node *directory, const char *name)
+{
+    Ext2DirectorySearch search = {name, 0};
+
+    ext2_directory_iterate(directory, &search, (Ext2DirectoryIterateCallback)ext2_directory_search_callback);
+
+    return search.inode;
+}
+
+static Iteration ext2_directory_is_empty_callback(bool *empty, Ext2DirectoryEntry *entry)
+{
+    if (ext2_directory_entry_is_dot_or_dot_dot(entry))
+    {
+        return Iteration::CONTINUE;
+    }
+
+    *empty = false;
+    return Iteration::STOP;
+}
+
+static bool ext2_directory_is_empty(Ext2Node *directory)
+{
+    bool empty = true;
+
+    ext2_directory_iterate(directory, &empty, (Ext2DirectoryIterateCallback)ext2_directory_is_empty_callback);
+
+    return empty;
+}
+
+static uint8_t ext2_directory_entry_type(Ext2Filesystem *filesystem, FileType type)
+{
+    if (!(filesystem->superblock.features_incompatible & EXT2_FEATURE_INCOMPAT_FILETYPE))
+    {
+        return EXT2_DIRECTORY_ENTRY_UNKNOWN;
+    }
+
+    if (type == FILE_TYPE_DIRECTORY)
+    {
+        return EXT2_DIRECTORY_ENTRY_DIRECTORY;
+    }
+
+    if (type == FILE_TYPE_REGULAR)
+    {
+        return EXT2_DIRECTORY_ENTRY_REGULAR;
+    }
+
+    return EXT2_DIRECTORY_ENTRY_UNKNOWN;
+}
+
+static void ext2_directory_entry_fill(Ext2DirectoryEntry *entry, const char *name, uint32_t inode, uint8_t file_type)
+{
+    entry->inode = inode;
+    entry->name_length = strlen(name);
+    entry->file_type = file_type;
+    memcpy(entry->name, name, entry->name_length);
+}
+
+static Result ext2_directory_add_entry(Ext2Node *directory, const char *name, uint32_t inode, FileType type)
+{
+    Ext2Filesystem *filesystem = directory->filesystem;
+
+    size_t name_length = strlen(name);
+
+    if (name_length == 0 || name_length > EXT2_NAME_LENGTH)
+    {
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    size_t needed = EXT2_DIRECTORY_ENTRY_SIZE(name_length);
+    uint8_t file_type = ext2_directory_entry_type(filesystem, type);
+
+    uint8_t *buffer = (uint8_t *)malloc(filesystem->block_size);
+    Result result = SUCCESS;
+
+    // Look for a large enough gap in the existing blocks...
+    for (size_t index = 0; index * filesystem->block_size < directory->inode.size; index++)
+    {
+        uint32_t block = 0;
+        result = ext2_inode_block(filesystem, &directory->inode, ext2_node_group(directory), index, false, &block);
+
+        if (result != SUCCESS)
+        {
+            goto cleanup_and_return;
+        }
+
+        if (block == 0)
+        {
+            continue;
+        }
+
+        size_t block_offset = ext2_block_offset(filesystem, block);
+        result = ext2_read(filesystem, block_offset, buffer, filesystem->block_size);
+
+        if (result != SUCCESS)
+        {
+            goto cleanup_and_return;
+        }
+
+        for (size_t position = 0; position + sizeof(Ext2DirectoryEntry) <= filesystem->block_size;)
+        {
+            Ext2DirectoryEntry *entry = (Ext2DirectoryEntry *)(buffer + position);
+
+            if (entry->record_length < sizeof(Ext2DirectoryEntry) ||
+                position + entry->record_length > filesystem->block_size)
+            {
+                break;
+            }
+
+            size_t used = entry->inode ? EXT2_DIRECTORY_ENTRY_SIZE(entry->name_length) : 0;
+
+            if (entry->record_length - used >= needed)
+            {
+                Ext2DirectoryEntry *new_entry = entry;
+
+                if (used)
+                {
+                    new_entry = (Ext2DirectoryEntry *)(buffer + position + used);
+                    new_entry->record_length = entry->record_length - used;
+                    entry->record_length = used;
+                }
+
+                ext2_directory_entry_fill(new_entry, name, inode, file_type);
+
+                result = ext2_write(filesystem, block_offset, buffer, filesystem->block_size);
+                goto cleanup_and_return;
+            }
+
+            position += entry->record_length;
+        }
+    }
+
+    // ...or grow the directory by one block.
+    {
+        uint32_t block = 0;
+        size_t index = directory->inode.size / filesystem->block_size;
+
+        result = ext2_inode_block(filesystem, &directory->inode, ext2_node_group(directory), index, true, &block);
+
+        if (result != SUCCESS)
+        {
+            goto cleanup_and_return;
+        }
+
+        memset(buffer, 0, filesystem->block_size);
+
+        Ext2DirectoryEntry *entry = (Ext2DirectoryEntry *)buffer;
+        entry->record_length = filesystem->block_size;
+        ext2_directory_entry_fill(entry, name, inode, file_type);
+
+        result = ext2_write(filesystem, ext2_block_offset(filesystem, block), buffer, filesystem->block_size);
+
+        directory->inode.size += filesystem->block_size;
+        ext2_node_write_inode(directory);
+    }
+
+cleanup_and_return:
+    free(buffer);
+
+    return result;
+}
+
+static Result ext2_directory_remove_entry(Ext2Node *directory, const char *name)
+{
+    Ext2Filesystem *filesystem = directory->filesystem;
+
+    uint8_t *buffer = (uint8_t *)malloc(filesystem->block_size);
+    Result result = ERR_NO_SUCH_FILE_OR_DIRECTORY;
+
+    for (size_t index = 0; index * filesystem->block_size < directory->inode.size; index++)
+    {
+        uint32_t block = 0;
+
+        if (ext2_inode_block(filesystem, &directory->inode, 0, index, false, &block) != SUCCESS || block == 0)
+        {
+            continue;
+        }
+
+        size_t block_offset = ext2_block_offset(filesystem, block);
+
+        if (ext2_read(filesystem, block_offset, buffer, filesystem->block_size) != SUCCESS)
+        {
+            continue;
+        }
+
+        Ext2DirectoryEntry *previous = nullptr;
+
+        for (size_t position = 0; position + sizeof(Ext2DirectoryEntry) <= filesystem->block_size;)
+        {
+            Ext2DirectoryEntry *entry = (Ext2DirectoryEntry *)(buffer + position);
+
+            if (entry->record_length < sizeof(Ext2DirectoryEntry) ||
+                position + entry->record_length > filesystem->block_size)
+            {
+                break;
+            }
+
+            if (entry->inode != 0 && ext2_directory_entry_is(entry, name))
+            {
+                // Merge the entry with the previous one, the first entry of
+                // a block can't be merged so it's just marked as unused.
+                if (previous)
+                {
+                    previous->record_length += entry->record_length;
+                }
+                else
+                {
+                    entry->inode = 0;
+                }
+
+                result = ext2_write(filesystem, block_offset, buffer, filesystem->block_size);
+
+                free(buffer);
+                return result;
+            }
+
+            previous = entry;
+            position += entry->record_length;
+        }
+    }
+
+    free(buffer);
+
+    return result;
+}
+
+// The ".." entry is always the second one of the first block.
+static Result ext2_directory_parent_offset(Ext2Node *directory, size_t *offset)
+{
+    Ext2Filesystem *filesystem = directory->filesystem;
+
+    uint32_t block = 0;
+    Result result = ext2_inode_block(filesystem, &directory->inode, 0, 0, false, &block);
+
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    if (block == 0)
+    {
+        return ERR_INPUT_OUTPUT_ERROR;
+    }
+
+    uint16_t first_record_length = 0;
+    result = ext2_read(filesystem, ext2_block_offset(filesystem, block) + 4, &first_record_length, sizeof(uint16_t));
+
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    *offset = ext2_block_offset(filesystem, block) + first_record_length;
+
+    return SUCCESS;
+}
+
+static uint32_t ext2_directory_get_parent(Ext2Node *directory)
+{
+    size_t offset = 0;
+    uint32_t parent = 0;
+
+    if (ext2_directory_parent_offset(directory, &offset) == SUCCESS)
+    {
+        ext2_read(directory->filesystem, offset, &parent, sizeof(uint32_t));
+    }
+
+    return parent;
+}
+
+static Result ext2_directory_set_parent(Ext2Node *directory, uint32_t parent)
+{
+    size_t offset = 0;
+    Result result = ext2_directory_parent_offset(directory, &offset);
+
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    return ext2_write(directory->filesystem, offset, &parent, sizeof(uint32_t));
+}
+
+static void ext2_node_adjust_links(Ext2Filesystem *filesystem, uint32_t number, int delta)
+{
+    Ext2Node *node = ext2_node_get(filesystem, number);
+
+    if (node)
+    {
+        node->inode.links_count += delta;
+        ext2_node_write_inode(node);
+        fsnode_deref(node);
+    }
+}
+
+/* --- Inodes creation ------------------------------------------------------ */
+
+static Result ext2_create_inode(Ext2Node *parent, FileType type, uint32_t *number)
+{
+    Ext2Filesystem *filesystem = parent->filesystem;
+    bool directory = type == FILE_TYPE_DIRECTORY;
+
+    Result result = ext2_allocate_inode(filesystem, ext2_node_group(parent), directory, number);
+
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    Ext2Inode inode = {};
+
+    inode.mode = directory ? (EXT2_MODE_DIRECTORY | 0755) : (EXT2_MODE_REGULAR | 0644);
+    inode.access_time = arch_get_time();
+    inode.creation_time = inode.access_time;
+    inode.modification_time = inode.access_time;
+    inode.links_count = directory ? 2 : 1;
+
+    if (directory)
+    {
+        uint32_t block = 0;
+        result = ext2_inode_block(filesystem, &inode, ext2_node_group(parent), 0, true, &block);
+
+        if (result != SUCCESS)
+        {
+            ext2_free_inode(filesystem, *number, directory);
+            return result;
+        }
+
+        uint8_t *buffer = (uint8_t *)calloc(1, filesystem->block_size);
+
+        Ext2DirectoryEntry *dot = (Ext2DirectoryEntry *)buffer;
+        dot->record_length = EXT2_DIRECTORY_ENTRY_SIZE(1);
+        ext2_directory_entry_fill(dot, ".", *number, ext2_directory_entry_type(filesystem, FILE_TYPE_DIRECTORY));
+
+        Ext2DirectoryEntry *dot_dot = (Ext2DirectoryEntry *)(buffer + dot->record_length);
+        dot_dot->record_length = filesystem->block_size - dot->record_length;
+        ext2_directory_entry_fill(dot_dot, "..", parent->number, ext2_directory_entry_type(filesystem, FILE_TYPE_DIRECTORY));
+
+        result = ext2_write(filesystem, ext2_block_offset(filesystem, block), buffer, filesystem->block_size);
+        free(buffer);
+
+        inode.size = filesystem->block_size;
+
+        parent->inode.links_count++;
+        ext2_node_write_inode(parent);
+    }
+
+    if (result == SUCCESS)
+    {
+        result = ext2_write_inode(filesystem, *number, &inode);
+    }
+
+    return result;
+}
+
+/* --- Regular files -------------------------------------------------------- */
+
+static Result ext2_file_open(Ext2Node *node, FsHandle *handle)
+{
+    if (fshandle_has_flag(handle, OPEN_TRUNC) &&
+        fshandle_has_flag(handle, OPEN_WRITE) &&
+        !node->filesystem->read_only)
+    {
+        ext2_inode_truncate(node->filesystem, &node->inode);
+        node->read_ahead_end = 0;
+
+        return ext2_node_write_inode(node);
+    }
+
+    return SUCCESS;
+}
+
+static void ext2_file_read_ahead(Ext2Node *node, size_t offset)
+{
+    Ext2Filesystem *filesystem = node->filesystem;
+
+    if (offset + EXT2_READ_AHEAD / 2 < node->read_ahead_end)
+    {
+        // Still far enough ahead of the reader.
+        return;
+    }
+
+    size_t start = MAX(offset, node->read_ahead_end) / filesystem->block_size;
+    size_t end = __align_up(MIN(offset + EXT2_READ_AHEAD, (size_t)node->inode.size), filesystem->block_size) / filesystem->block_size;
+
+    // Prefetch runs of contiguous blocks.
+    uint32_t run_start = 0;
+    size_t run_length = 0;
+
+    for (size_t index = start; index < end; index++)
+    {
+        uint32_t block = 0;
+
+        if (ext2_inode_block(filesystem, &node->inode, 0, index, false, &block) != SUCCESS)
+        {
+            break;
+        }
+
+        if (run_length && block == run_start + run_length)
+        {
+            run_length++;
+            continue;
+        }
+
+        if (run_length)
+        {
+            block_cache_prefetch(filesystem->disk, ext2_block_offset(filesystem, run_start), run_length * filesystem->block_size);
+        }
+
+        run_start = block;
+        run_length = block ? 1 : 0;
+    }
+
+    if (run_length)
+    {
+        block_cache_prefetch(filesystem->disk, ext2_block_offset(filesystem, run_start), run_length * filesystem->block_size);
+    }
+
+    node->read_ahead_end = end * filesystem->block_size;
+}
+
+static Result ext2_file_read(Ext2Node *node, FsHandle *handle, void *buffer, size_t size, size_t *read)
+{
+    Ext2Filesystem *filesystem = node->filesystem;
+
+    if (handle->offset >= node->inode.size)
+    {
+        return SUCCESS;
+    }
+
+    size = MIN(node->inode.size - handle->offset, size);
+
+    bool sequential = handle->offset == node->last_read_end;
+
+    size_t offset = handle->offset;
+    size_t done = 0;
+    Result result = SUCCESS;
+
+    while (done < size)
+    {
+        size_t in_block = offset % filesystem->block_size;
+        size_t chunk = MIN(filesystem->block_size - in_block, size - done);
+
+        uint32_t block = 0;
+        result = ext2_inode_block(filesystem, &node->inode, 0, offset / filesystem->block_size, false, &block);
+
+        if (result != SUCCESS)
+        {
+            break;
+        }
+
+        if (block)
+        {
+            result = ext2_read(filesystem, ext2_block_offset(filesystem, block) + in_block, (char *)buffer + done, chunk);
+
+            if (result != SUCCESS)
+            {
+                break;
+            }
+        }
+        else
+        {
+            memset((char *)buffer + done, 0, chunk);
+        }
+
+        offset += chunk;
+        done += chunk;
+    }
+
+    if (sequential)
+    {
+        ext2_file_read_ahead(node, offset);
+    }
+
+    node->last_read_end = offset;
+    *read = done;
+
+    return done > 0 ? SUCCESS : result;
+}
+
+static Result ext2_file_write(Ext2Node *node, FsHandle *handle, const void *buffer, size_t size, size_t *written)
+{
+    Ext2Filesystem *filesystem = node->filesystem;
+
+    if (filesystem->read_only)
+    {
+        return ERR_READ_ONLY_STREAM;
+    }
+
+    size_t offset = handle->offset;
+    size_t done = 0;
+    Result result = SUCCESS;
+
+    while (done < size)
+    {
+        size_t in_block = offset % filesystem->block_size;
+        size_t chunk = MIN(filesystem->block_size - in_block, size - done);
+
+        uint32_t block = 0;
+        result = ext2_inode_block(filesystem, &node->inode, ext2_node_group(node), offset / filesystem->block_size, true, &block);
+
+        if (result != SUCCESS)
+        {
+            break;
+        }
+
+        result = ext2_write(filesystem, ext2_block_offset(filesystem, block) + in_block, (const char *)buffer + done, chunk);
+
+        if (result != SUCCESS)
+        {
+            break;
+        }
+
+        offset += chunk;
+        done += chunk;
+    }
+
+    node->inode.size = MAX(offset, (size_t)node->inode.size);
+    node->inode.modification_time = arch_get_time();
+    ext2_node_write_inode(node);
+
+    *written = done;
+
+    return done > 0 ? SUCCESS : result;
+}
+
+/* --- Directories nodes ---------------------------------------------------- */
+
+struct Ext2DirectoryListing
+{
+    Ext2Filesystem *filesystem;
+    DirectoryListing *listing;
+    size_t allocated;
+};
+
+static FileType ext2_mode_to_type(uint16_t mode)
+{
+    switch (mode & EXT2_MODE_TYPE_MASK)
+    {
+    case EXT2_MODE_DIRECTORY:
+        return FILE_TYPE_DIRECTORY;
+
+    case EXT2_MODE_REGULAR:
+        return FILE_TYPE_REGULAR;
+
+    default:
+        return FILE_TYPE_UNKNOWN;
+    }
+}
+
+static Iteration ext2_directory_list_callback(Ext2DirectoryListing *listing, Ext2DirectoryEntry *entry)
+{
+    if (ext2_directory_entry_is_dot_or_dot_dot(entry) || entry->name_length >= FILE_NAME_LENGTH)
+    {
+        return Iteration::CONTINUE;
+    }
+
+    if (listing->listing->count == listing->allocated)
+    {
+        listing->allocated *= 2;
+        listing->listing = (DirectoryListing *)realloc(
+            listing->listing,
+            sizeof(DirectoryListing) + sizeof(DirectoryEntry) * listing->allocated);
+    }
+
+    DirectoryEntry *record = &listing->listing->entries[listing->listing->count];
+
+    memcpy(record->name, entry->name, entry->name_length);
+    record->name[entry->name_length] = '\0';
+
+    Ext2Inode inode = {};
+    ext2_read_inode(listing->filesystem, entry->inode, &inode);
+
+    record->stat.type = ext2_mode_to_type(inode.mode);
+    record->stat.size = inode.size;
+
+    listing->listing->count++;
+
+    return Iteration::CONTINUE;
+}
+
+static Result ext2_directory_open(Ext2Node *node, FsHandle *handle)
+{
+    Ext2DirectoryListing listing = {};
+
+    listing.filesystem = node->filesystem;
+    listing.allocated = 16;
+    listing.listing = (DirectoryListing *)malloc(sizeof(DirectoryListing) + sizeof(DirectoryEntry) * listing.allocated);
+    listing.listing->count = 0;
+
+    ext2_directory_iterate(node, &listing, (Ext2DirectoryIterateCallback)ext2_directory_list_callback);
+
+    handle->attached = listing.listing;
+
+    return SUCCESS;
+}
+
+static void ext2_directory_close(Ext2Node *node, FsHandle *handle)
+{
+    __unused(node);
+
+    free(handle->attached);
+}
+
+static Result ext2_directory_read(Ext2Node *node, FsHandle *handle, void *buffer, size_t size, size_t *read)
+{
+    __unused(node);
+
+    if (size == sizeof(DirectoryEntry))
+    {
+        size_t index = handle->offset / sizeof(DirectoryEntry);
+
+        DirectoryListing *listing = (DirectoryListing *)handle->attached;
+
+        if (index < listing->count)
+        {
+            *((DirectoryEntry *)buffer) = listing->entries[index];
+
+            *read = sizeof(DirectoryEntry);
+        }
+    }
+
+    return SUCCESS;
+}
+
+static FsNode *ext2_directory_find(Ext2Node *node, const char *name)
+{
+    uint32_t number = ext2_directory_search(node, name);
+
+    if (number == 0)
+    {
+        return nullptr;
+    }
+
+    return ext2_node_get(node->filesystem, number);
+}
+
+static Result ext2_directory_link_existing(Ext2Node *node, const char *name, Ext2Node *child)
+{
+    Result result = ext2_directory_add_entry(node, name, child->number, child->type);
+
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    if (child->type != FILE_TYPE_DIRECTORY)
+    {
+        child->inode.links_count++;
+        return ext2_node_write_inode(child);
+    }
+
+    // A directory is being moved around, the old name is going to be unlinked.
+    child->directory_names++;
+
+    uint32_t old_parent = ext2_directory_get_parent(child);
+
+    if (old_parent != node->number)
+    {
+        ext2_directory_set_parent(child, node->number);
+
+        node->inode.links_count++;
+        ext2_node_write_inode(node);
+
+        ext2_node_adjust_links(node->filesystem, old_parent, -1);
+    }
+
+    return SUCCESS;
+}
+
+// Read the first entry of a directory from any filesystem.
+static bool ext2_is_empty_foreign_directory(FsNode *node)
+{
+    FsHandle *handle = fshandle_create(node, OPEN_READ | OPEN_DIRECTORY);
+
+    DirectoryEntry entry;
+    size_t read = 0;
+
+    Result result = fshandle_read(handle, &entry, sizeof(DirectoryEntry), &read);
+
+    fshandle_destroy(handle);
+
+    return result == SUCCESS && read == 0;
+}
+
+static Result ext2_directory_link(Ext2Node *node, const char *name, FsNode *child)
+{
+    Ext2Filesystem *filesystem = node->filesystem;
+
+    if (filesystem->read_only)
+    {
+        return ERR_READ_ONLY_STREAM;
+    }
+
+    if (ext2_directory_search(node, name))
+    {
+        return ERR_FILE_EXISTS;
+    }
+
+    if (ext2_is_node_of(child, filesystem))
+    {
+        return ext2_directory_link_existing(node, name, (Ext2Node *)child);
+    }
+
+    // Nodes from elsewhere can't live on the disk, but new empty files and
+    // directories are recreated here (see filesystem_open() and
+    // filesystem_mkdir()). Anything with content would be lost on the way.
+    bool is_empty_file = child->type == FILE_TYPE_REGULAR && (!child->size || child->size(child, nullptr) == 0);
+    bool is_empty_directory = child->type == FILE_TYPE_DIRECTORY && ext2_is_empty_foreign_directory(child);
+
+    if (!is_empty_file && !is_empty_directory)
+    {
+        return ERR_OPERATION_NOT_SUPPORTED;
+    }
+
+    uint32_t number = 0;
+    Result result = ext2_create_inode(node, child->type, &number);
+
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    result = ext2_directory_add_entry(node, name, number, child->type);
+
+    if (result != SUCCESS)
+    {
+        logger_warn("Failed to link inode %d as '%s', it is lost", number, name);
+    }
+
+    return result;
+}
+
+static Result ext2_directory_unlink(Ext2Node *node, const char *name)
+{
+    Ext2Filesystem *filesystem = node->filesystem;
+
+    if (filesystem->read_only)
+    {
+        return ERR_READ_ONLY_STREAM;
+    }
+
+    if (strcmp(name, ".") == 0 || strcmp(name, "..") == 0)
+    {
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    uint32_t number = ext2_directory_search(node, name);
+
+    if (number == 0)
+    {
+        return ERR_NO_SUCH_FILE_OR_DIRECTORY;
+    }
+
+    Ext2Node *child = ext2_node_get(filesystem, number);
+
+    if (!child)
+    {
+        return ERR_INPUT_OUTPUT_ERROR;
+    }
+
+    Result result = SUCCESS;
+
+    if (child->type == FILE_TYPE_DIRECTORY && child->directory_names > 1)
+    {
+        // The other half of a rename.
+        result = ext2_directory_remove_entry(node, name);
+
+        if (result == SUCCESS)
+        {
+            child->directory_names--;
+        }
+    }
+    else if (child->type == FILE_TYPE_DIRECTORY)
+    {
+        if (!ext2_directory_is_empty(child))
+        {
+            result = ERR_DIRECTORY_NOT_EMPTY;
+        }
+        else
+        {
+            result = ext2_directory_remove_entry(node, name);
+        }
+
+        if (result == SUCCESS)
+        {
+            if (ext2_directory_get_parent(child) == node->number)
+            {
+                node->inode.links_count--;
+                ext2_node_write_inode(node);
+            }
+
+            child->directory_names = 0;
+            child->inode.links_count = 0;
+            child->deleted = true;
+            ext2_node_write_inode(child);
+        }
+    }
+    else
+    {
+        result = ext2_directory_remove_entry(node, name);
+
+        if (result == SUCCESS)
+        {
+            child->inode.links_count--;
+            child->deleted = child->inode.links_count == 0;
+            ext2_node_write_inode(child);
+        }
+    }
+
+    fsnode_deref(child);
+
+    return result;
+}
+
+/* --- Nodes ---------------------------------------------------------------- */
+
+static size_t ext2_node_size(Ext2Node *node, FsHandle *handle)
+{
+    __unused(handle);
+
+    return node->inode.size;
+}
+
+static void ext2_node_destroy(Ext2Node *node)
+{
+    Ext2Filesystem *filesystem = node->filesystem;
+
+    lock_acquire(filesystem->lock);
+
+    Ext2Node **slot = &filesystem->nodes[node->number % EXT2_NODE_BUCKETS];
+
+    while (*slot && *slot != node)
+    {
+        slot = &(*slot)->next_in_bucket;
+    }
+
+    if (*slot)
+    {
+        *slot = node->next_in_bucket;
+    }
+
+    lock_release(filesystem->lock);
+
+    // The last name is gone and nobody has it open anymore.
+    if (node->deleted)
+    {
+        ext2_inode_truncate(filesystem, &node->inode);
+        node->inode.deletion_time = arch_get_time();
+        ext2_node_write_inode(node);
+
+        ext2_free_inode(filesystem, node->number, node->type == FILE_TYPE_DIRECTORY);
+    }
+}
+
+static Ext2Node *ext2_node_create(Ext2Filesystem *filesystem, uint32_t number, Ext2Inode *inode)
+{
+    Ext2Node *node = __create(Ext2Node);
+
+    fsnode_init(node, ext2_mode_to_type(inode->mode));
+
+    node->filesystem = filesystem;
+    node->number = number;
+    node->inode = *inode;
+
+    node->size = (FsNodeSizeCallback)ext2_node_size;
+    node->destroy = (FsNodeDestroyCallback)ext2_node_destroy;
+
+    if (node->type == FILE_TYPE_REGULAR)
+    {
+        node->open = (FsNodeOpenCallback)ext2_file_open;
+        node->read = (FsNodeReadCallback)ext2_file_read;
+        node->write = (FsNodeWriteCallback)ext2_file_write;
+    }
+    else if (node->type == FILE_TYPE_DIRECTORY)
+    {
+        node->open = (FsNodeOpenCallback)ext2_directory_open;
+        node->close = (FsNodeCloseCallback)ext2_directory_close;
+        node->read = (FsNodeReadCallback)ext2_directory_read;
+        node->find = (FsNodeFindCallback)ext2_directory_find;
+        node->link = (FsNodeLinkCallback)ext2_directory_link;
+        node->unlink = (FsNodeUnlinkCallback)ext2_directory_unlink;
+
+        node->directory_names = 1;
+    }
+
+    return node;
+}
+
+// Nodes are dropped from the table by their destroy callback, a node
+// found with no reference left is on its way out and can't be revived.
+static Ext2Node *ext2_node_lookup_and_ref(Ext2Filesystem *filesystem, uint32_t number)
+{
+    Ext2Node *node = filesystem->nodes[number % EXT2_NODE_BUCKETS];
+
+    while (node)
+    {
+        if (node->number == number)
+        {
+            uint refcount = __atomic_load_n(&node->refcount, __ATOMIC_SEQ_CST);
+
+            while (refcount > 0)
+            {
+                if (__atomic_compare_exchange_n(&node->refcount, &refcount, refcount + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+                {
+                    return node;
+                }
+            }
+        }
+
+        node = node->next_in_bucket;
+    }
+
+    return nullptr;
+}
+
+Ext2Node *ext2_node_get(Ext2Filesystem *filesystem, uint32_t number)
+{
+    lock_acquire(filesystem->lock);
+    Ext2Node *node = ext2_node_lookup_and_ref(filesystem, number);
+    lock_release(filesystem->lock);
+
+    if (node)
+    {
+        return node;
+    }
+
+    // Inodes are only loaded when someone looks for them.
+    Ext2Inode inode = {};
+
+    if (ext2_read_inode(filesystem, number, &inode) != SUCCESS)
+    {
+        return nullptr;
+    }
+
+    Ext2Node *new_node = ext2_node_create(filesystem, number, &inode);
+
+    lock_acquire(filesystem->lock);
+
+    node = ext2_node_lookup_and_ref(filesystem, number);
+
+    if (!node)
+    {
+        new_node->next_in_bucket = filesystem->nodes[number % EXT2_NODE_BUCKETS];
+        filesystem->nodes[number % EXT2_NODE_BUCKETS] = new_node;
+    }
+
+    lock_release(filesystem->lock);
+
+    if (node)
+    {
+        // Someone else loaded it in the meantime.
+        fsnode_deref(new_node);
+        return node;
+    }
+
+    return new_node;
+}
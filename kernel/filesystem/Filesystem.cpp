@@ -1,12 +1,16 @@
 
 /* filesystem.c: the skiftOS virtual filesystem.                              */
 
+#include <abi/Paths.h>
 #include <libsystem/Assert.h>
 #include <libsystem/Logger.h>
 #include <libsystem/Result.h>
 #include <libsystem/core/CString.h>
 #include <libsystem/math/Math.h>
 
+#include "kernel/devices/Disk.h"
+#include "kernel/filesystem/Cache.h"
+#include "kernel/filesystem/Ext2.h"
 #include "kernel/filesystem/Filesystem.h"
 #include "kernel/node/Directory.h"
 #include "kernel/node/File.h"
@@ -27,14 +31,60 @@ void filesystem_initialize()
     logger_info("Initializing filesystem...");
 
     _filesystem_root = directory_create();
+    filesystem_cache_initialize();
 
     logger_info("File system root at 0x%x", _filesystem_root);
 }
 
+static Iteration filesystem_mount_volume(void *target, Disk *disk)
+{
+    __unused(target);
+
+    FsNode *root = nullptr;
+    Result result = ext2_mount(disk, &root);
+
+    if (result != SUCCESS)
+    {
+        logger_info("Disk %d has no volume we can mount: %s", disk->id, result_to_string(result));
+        return Iteration::CONTINUE;
+    }
+
+    char path[PATH_LENGTH];
+    snprintf(path, PATH_LENGTH, VOLUMES_PATH "/disk%d", disk->id);
+
+    result = filesystem_link_and_take_ref_cstring(path, root);
+
+    if (result != SUCCESS)
+    {
+        logger_error("Failed to mount disk %d on %s: %s", disk->id, path, result_to_string(result));
+    }
+
+    return Iteration::CONTINUE;
+}
+
+void filesystem_mount_volumes()
+{
+    Path *path = path_create(VOLUMES_PATH);
+    filesystem_mkdir(path);
+    path_destroy(path);
+
+    disk_iterate(nullptr, filesystem_mount_volume);
+}
+
 FsNode *filesystem_find_and_ref(Path *path)
 {
     assert(_filesystem_root != nullptr);
 
+    uint32_t generation = 0;
+    FsNode *cached = filesystem_cache_lookup_and_ref(path, &generation);
+
+    if (cached)
+    {
+        return cached;
+    }
+
+    filesystem_cache_account_walk(path_element_count(path));
+
     FsNode *current = fsnode_ref(_filesystem_root);
 
     for (size_t i = 0; i < path_element_count(path); i++)
@@ -57,10 +107,20 @@ FsNode *filesystem_find_and_ref(Path *path)
         }
         else
         {
+            if (current)
+            {
+                fsnode_deref(current);
+            }
+
             return nullptr;
         }
     }
 
+    if (current)
+    {
+        filesystem_cache_insert(path, current, generation);
+    }
+
     return current;
 }
 
@@ -98,8 +158,32 @@ Result filesystem_open(Path *path, OpenFlag flags, FsHandle **handle)
                 }
 
                 fsnode_acquire_lock(parent, scheduler_running_id());
-                parent->link(parent, path_filename(path), node);
+
+                Result result = parent->link(parent, path_filename(path), node);
+
+                // On disk filesystems create their own node in place of ours.
+                if (result == SUCCESS && parent->find)
+                {
+                    FsNode *linked = parent->find(parent, path_filename(path));
+
+                    if (linked)
+                    {
+                        fsnode_deref(node);
+                        node = linked;
+                    }
+                }
+
                 fsnode_release_lock(parent, scheduler_running_id());
+
+                filesystem_cache_invalidate(path);
+
+                if (result != SUCCESS)
+                {
+                    fsnode_deref(node);
+                    fsnode_deref(parent);
+
+                    return result;
+                }
             }
 
             fsnode_deref(parent);
@@ -279,6 +363,8 @@ Result filesystem_link(Path *path, FsNode *node)
     result = parent->link(parent, path_filename(path), node);
     fsnode_release_lock(parent, scheduler_running_id());
 
+    filesystem_cache_invalidate(path);
+
 cleanup_and_return:
     if (parent != nullptr)
         fsnode_deref(parent);
@@ -332,6 +418,8 @@ Result filesystem_unlink(Path *path)
     result = parent->unlink(parent, path_filename(path));
     fsnode_release_lock(parent, scheduler_running_id());
 
+    filesystem_cache_invalidate(path);
+
 cleanup_and_return:
     if (parent)
         fsnode_deref(parent);
@@ -402,6 +490,9 @@ unlock_cleanup_and_return:
 
     fsnode_release_lock(new_parent, scheduler_running_id());
 
+    filesystem_cache_invalidate(old_path);
+    filesystem_cache_invalidate(new_path);
+
 cleanup_and_return:
     if (child)
         fsnode_deref(child);
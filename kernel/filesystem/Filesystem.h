@@ -8,6 +8,9 @@
 
 void filesystem_initialize();
 
+// Mount the volumes of every disks under VOLUMES_PATH.
+void filesystem_mount_volumes();
+
 FsNode *filesystem_find_and_ref(Path *path);
 
 FsNode *filesystem_find_parent_and_ref(Path *path);
@@ -158,6 +158,26 @@ Result __plug_process_set_directory(const char *directory)
     return task_set_directory(scheduler_running(), directory);
 }
 
+Result __plug_process_set_priority(int pid, int priority)
+{
+    Result result = SUCCESS;
+
+    ATOMIC({
+        Task *task = task_by_id(pid);
+
+        if (task == nullptr)
+        {
+            result = ERR_NO_SUCH_TASK;
+        }
+        else
+        {
+            result = task_set_priority(task, priority);
+        }
+    });
+
+    return result;
+}
+
 Result __plug_process_sleep(int time)
 {
     return task_sleep(scheduler_running(), time);
@@ -192,6 +212,16 @@ Result __plug_handle_select(
     return task_fshandle_select(scheduler_running(), handles, selected, selected_events, timeout);
 }
 
+Result __plug_handle_poll_control(int poll_handle, HandlePollOperation operation, int handle, SelectEvent events)
+{
+    return task_fshandle_poll_control(scheduler_running(), poll_handle, operation, handle, events);
+}
+
+Result __plug_handle_poll_wait(int poll_handle, HandlePollEvent *events, size_t count, size_t *ready, Timeout timeout)
+{
+    return task_fshandle_poll_wait(scheduler_running(), poll_handle, events, count, ready, timeout);
+}
+
 size_t __plug_handle_read(Handle *handle, void *buffer, size_t size)
 {
     assert(handle->id != INTERNAL_LOG_STREAM_HANDLE);
@@ -203,6 +233,15 @@ size_t __plug_handle_read(Handle *handle, void *buffer, size_t size)
     return read;
 }
 
+size_t __plug_handle_splice(Handle *source, Handle *destination, size_t size)
+{
+    size_t spliced = 0;
+
+    source->result = task_fshandle_splice(scheduler_running(), source->id, destination->id, size, &spliced);
+
+    return spliced;
+}
+
 size_t __plug_handle_write(Handle *handle, const void *buffer, size_t size)
 {
     if (handle->id == INTERNAL_LOG_STREAM_HANDLE)
@@ -221,6 +260,64 @@ size_t __plug_handle_write(Handle *handle, const void *buffer, size_t size)
     }
 }
 
+size_t __plug_handle_readv(Handle *handle, const IOVector *vectors, size_t count)
+{
+    assert(handle->id != INTERNAL_LOG_STREAM_HANDLE);
+
+    size_t read = 0;
+
+    handle->result = task_fshandle_readv(scheduler_running(), handle->id, vectors, count, &read);
+
+    return read;
+}
+
+size_t __plug_handle_writev(Handle *handle, const IOVector *vectors, size_t count)
+{
+    if (handle->id == INTERNAL_LOG_STREAM_HANDLE)
+    {
+        size_t written = 0;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            written += arch_debug_write(vectors[i].buffer, vectors[i].size);
+        }
+
+        handle->result = SUCCESS;
+
+        return written;
+    }
+    else
+    {
+        size_t written = 0;
+
+        handle->result = task_fshandle_writev(scheduler_running(), handle->id, vectors, count, &written);
+
+        return written;
+    }
+}
+
+size_t __plug_handle_pread(Handle *handle, void *buffer, size_t size, size_t offset)
+{
+    assert(handle->id != INTERNAL_LOG_STREAM_HANDLE);
+
+    size_t read = 0;
+
+    handle->result = task_fshandle_pread(scheduler_running(), handle->id, buffer, size, offset, &read);
+
+    return read;
+}
+
+size_t __plug_handle_pwrite(Handle *handle, const void *buffer, size_t size, size_t offset)
+{
+    assert(handle->id != INTERNAL_LOG_STREAM_HANDLE);
+
+    size_t written = 0;
+
+    handle->result = task_fshandle_pwrite(scheduler_running(), handle->id, buffer, size, offset, &written);
+
+    return written;
+}
+
 Result __plug_handle_call(Handle *handle, IOCall request, void *args)
 {
     assert(handle->id != INTERNAL_LOG_STREAM_HANDLE);
@@ -259,6 +356,15 @@ int __plug_handle_stat(Handle *handle, FileState *stat)
     return 0;
 }
 
+Result __plug_handle_map(Handle *handle, uintptr_t *address, size_t *size)
+{
+    assert(handle->id != INTERNAL_LOG_STREAM_HANDLE);
+
+    handle->result = task_fshandle_map(scheduler_running(), handle->id, address, size);
+
+    return handle->result;
+}
+
 void __plug_handle_connect(Handle *handle, const char *path)
 {
     assert(handle->id != INTERNAL_LOG_STREAM_HANDLE);
@@ -282,3 +388,8 @@ Result __plug_create_term(int *master_handle, int *slave_handle)
 {
     return task_create_term(scheduler_running(), master_handle, slave_handle);
 }
+
+Result __plug_create_poll(int *poll_handle)
+{
+    return task_create_poll(scheduler_running(), poll_handle);
+}
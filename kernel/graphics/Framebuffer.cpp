@@ -6,6 +6,7 @@
 
 #include "kernel/filesystem/Filesystem.h"
 #include "kernel/graphics/Graphics.h"
+#include "kernel/memory/MemoryObject.h"
 #include "kernel/memory/Virtual.h"
 
 static uintptr_t _framebuffer_physical = 0;
@@ -13,6 +14,12 @@ static uintptr_t _framebuffer_virtual = 0;
 static int _framebuffer_width = 0;
 static int _framebuffer_height = 0;
 static int _framebuffer_pitch = 0;
+static MemoryObject *_framebuffer_memory_object = nullptr;
+
+static void framebuffer_release(void *target)
+{
+    __unused(target);
+}
 
 Result framebuffer_iocall(FsNode *node, FsHandle *handle, IOCall iocall, void *args)
 {
@@ -34,17 +41,22 @@ Result framebuffer_iocall(FsNode *node, FsHandle *handle, IOCall iocall, void *a
 
         atomic_begin();
 
-        for (int y = MAX(0, blit->blit_y); y < MIN(_framebuffer_height, blit->blit_y + blit->blit_height); y++)
+        for (int i = 0; i < MIN(blit->blit_count, IOCALL_DISPLAY_BLIT_MAX_RECTANGLES); i++)
         {
-            for (int x = MAX(0, blit->blit_x); x < MIN(_framebuffer_width, blit->blit_x + blit->blit_width); x++)
+            IOCallDisplayBlitRectangle &rectangle = blit->blit_rectangles[i];
+
+            for (int y = MAX(0, rectangle.y); y < MIN(_framebuffer_height, rectangle.y + rectangle.height); y++)
             {
-                uint32_t pixel = blit->buffer[y * blit->buffer_width + x];
+                for (int x = MAX(0, rectangle.x); x < MIN(_framebuffer_width, rectangle.x + rectangle.width); x++)
+                {
+                    uint32_t pixel = blit->buffer[y * blit->buffer_width + x];
 
-                uint32_t converted_pixel = ((pixel >> 16) & 0x000000ff) |
-                                           ((pixel)&0xff00ff00) |
-                                           ((pixel << 16) & 0x00ff0000);
+                    uint32_t converted_pixel = ((pixel >> 16) & 0x000000ff) |
+                                               ((pixel)&0xff00ff00) |
+                                               ((pixel << 16) & 0x00ff0000);
 
-                ((uint32_t *)_framebuffer_virtual)[y * (_framebuffer_pitch / 4) + x] = converted_pixel;
+                    ((uint32_t *)_framebuffer_virtual)[y * (_framebuffer_pitch / 4) + x] = converted_pixel;
+                }
             }
         }
 
@@ -52,6 +64,18 @@ Result framebuffer_iocall(FsNode *node, FsHandle *handle, IOCall iocall, void *a
 
         return SUCCESS;
     }
+    else if (iocall == IOCALL_DISPLAY_MAP)
+    {
+        IOCallDisplayMapArgs *map = (IOCallDisplayMapArgs *)args;
+
+        map->handle = _framebuffer_memory_object->id;
+        map->width = _framebuffer_width;
+        map->height = _framebuffer_height;
+        map->pitch = _framebuffer_pitch;
+        map->pages = 1;
+
+        return SUCCESS;
+    }
     else
     {
         return ERR_INAPPROPRIATE_CALL_FOR_DEVICE;
@@ -65,11 +89,14 @@ void framebuffer_initialize(Multiboot *multiboot)
     _framebuffer_pitch = multiboot->framebuffer_pitch;
 
     _framebuffer_physical = multiboot->framebuffer_addr;
+
+    size_t size = PAGE_ALIGN_UP(_framebuffer_pitch * _framebuffer_height);
+
     _framebuffer_virtual = virtual_alloc(
                                &kpdir,
                                (MemoryRange){
                                    _framebuffer_physical,
-                                   PAGE_ALIGN_UP(_framebuffer_width * _framebuffer_height * sizeof(uint32_t)),
+                                   size,
                                },
                                MEMORY_NONE)
                                .base;
@@ -80,6 +107,18 @@ void framebuffer_initialize(Multiboot *multiboot)
         return;
     }
 
+    size_t page_count = size / PAGE_SIZE;
+    uintptr_t *pages = (uintptr_t *)calloc(page_count, sizeof(uintptr_t));
+
+    for (size_t i = 0; i < page_count; i++)
+    {
+        pages[i] = _framebuffer_physical + i * PAGE_SIZE;
+    }
+
+    _framebuffer_memory_object = memory_object_create_borrowed(size, pages, framebuffer_release, nullptr);
+
+    free(pages);
+
     graphic_did_find_framebuffer();
 
     FsNode *file = __create(FsNode);
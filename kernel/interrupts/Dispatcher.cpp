@@ -1,15 +1,17 @@
 
 #include <libsystem/Assert.h>
 #include <libsystem/Logger.h>
-#include <libsystem/thread/Atomic.h>
 #include <libsystem/utils/RingBuffer.h>
 
 #include "kernel/interrupts/Dispatcher.h"
 #include "kernel/scheduling/Blocker.h"
 #include "kernel/scheduling/Scheduler.h"
 
+// Filled by interrupt handlers and drained by the dispatcher task without locking.
 static RingBuffer *_interupts_to_dispatch = nullptr;
 static DispatcherInteruptHandler _interupts_to_handlers[255] = {};
+static DispatcherInteruptAcknowledge _interupts_to_acknowledges[255] = {};
+static WaitQueue _dispatcher_waiters = {};
 
 void dispatcher_initialize()
 {
@@ -21,28 +23,38 @@ void dispatcher_initialize()
 
 void dispatcher_dispatch(int interrupt)
 {
+    if (_interupts_to_acknowledges[interrupt])
+    {
+        _interupts_to_acknowledges[interrupt]();
+    }
+
     if (_interupts_to_handlers[interrupt])
     {
-        ringbuffer_putc(_interupts_to_dispatch, interrupt);
+        // The handler will catch up on the pending work when it is dispatched.
+        if (!ringbuffer_is_full(_interupts_to_dispatch))
+        {
+            ringbuffer_putc(_interupts_to_dispatch, interrupt);
+        }
+
+        wait_queue_wake(&_dispatcher_waiters);
     }
 }
 
 static bool dispatcher_has_interupt()
 {
-    atomic_begin();
-    bool result = !ringbuffer_is_empty(_interupts_to_dispatch);
-    atomic_end();
-
-    return result;
+    return !ringbuffer_is_empty(_interupts_to_dispatch);
 }
 
 static int dispatcher_get_interupt()
 {
-    atomic_begin();
-    int interrupt = ringbuffer_getc(_interupts_to_dispatch);
-    atomic_end();
+    return ringbuffer_getc(_interupts_to_dispatch);
+}
+
+static void dispatcher_on_block(Blocker *blocker, Task *task)
+{
+    __unused(blocker);
 
-    return interrupt;
+    wait_queue_wait(&_dispatcher_waiters, task);
 }
 
 static bool dispatcher_can_unblock(Blocker *blocker, Task *task)
@@ -58,6 +70,7 @@ void dispatcher_service()
     while (true)
     {
         Blocker *blocker = __create(Blocker);
+        blocker->on_block = (BlockerBlockCallback)dispatcher_on_block;
         blocker->can_unblock = (BlockerCanUnblockCallback)dispatcher_can_unblock;
         task_block(scheduler_running(), blocker, -1);
 
@@ -93,3 +106,9 @@ void dispatcher_unregister_handler(DispatcherInteruptHandler handler)
         }
     }
 }
+
+void dispatcher_register_acknowledge(int interrupt, DispatcherInteruptAcknowledge acknowledge)
+{
+    assert(!_interupts_to_acknowledges[interrupt]);
+    _interupts_to_acknowledges[interrupt] = acknowledge;
+}
@@ -4,6 +4,11 @@
 
 typedef void (*DispatcherInteruptHandler)();
 
+// Called from the interrupt itself, before the handler is dispatched.
+// Level triggered devices (like PCI ones) have to be quieted there or
+// the interrupt fires again as soon as interrupts are enabled.
+typedef void (*DispatcherInteruptAcknowledge)();
+
 void dispatcher_initialize();
 
 void dispatcher_dispatch(int interrupt);
@@ -13,3 +18,5 @@ void dispatcher_service();
 void dispatcher_register_handler(int interrupt, DispatcherInteruptHandler handler);
 
 void dispatcher_unregister_handler(DispatcherInteruptHandler handler);
+
+void dispatcher_register_acknowledge(int interrupt, DispatcherInteruptAcknowledge acknowledge);
@@ -9,12 +9,15 @@
 #include <libsystem/Logger.h>
 
 #include "arch/Arch.h"
+#include "arch/x86/ACPI.h"
 #include "arch/x86/Interrupts.h"
+#include "kernel/devices/BlockCache.h"
 #include "kernel/devices/Devices.h"
 #include "kernel/filesystem/Filesystem.h"
 #include "kernel/graphics/Graphics.h"
 #include "kernel/modules/Modules.h"
 #include "kernel/node/DevicesInfo.h"
+#include "kernel/node/FilesystemInfo.h"
 #include "kernel/node/ProcessInfo.h"
 #include "kernel/scheduling/Scheduler.h"
 #include "kernel/system/System.h"
@@ -27,12 +30,15 @@ void system_main(Multiboot *multiboot)
 
     system_initialize();
     memory_initialize(multiboot);
+    acpi_initialize(multiboot);
     scheduler_initialize();
     tasking_initialize();
     interrupts_initialize();
     filesystem_initialize();
     modules_initialize(multiboot);
+    block_cache_initialize();
     device_initialize();
+    filesystem_mount_volumes();
     null_initialize();
     zero_initialize();
     random_initialize();
@@ -41,6 +47,7 @@ void system_main(Multiboot *multiboot)
     keyboard_initialize();
     process_info_initialize();
     device_info_initialize();
+    filesystem_info_initialize();
     graphic_initialize(multiboot);
     userspace_initialize();
 
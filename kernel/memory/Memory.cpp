@@ -3,12 +3,15 @@
 #include <libsystem/Logger.h>
 #include <libsystem/core/CString.h>
 #include <libsystem/io/Stream.h>
+#include <libsystem/math/MinMax.h>
 #include <libsystem/thread/Atomic.h>
 
+#include "arch/x86/CPUID.h"
 #include "kernel/memory/Memory.h"
 #include "kernel/memory/MemoryObject.h"
 #include "kernel/memory/Physical.h"
 #include "kernel/memory/Virtual.h"
+#include "kernel/system/System.h"
 
 static bool _memory_initialized = false;
 
@@ -20,15 +23,89 @@ static MemoryRange kernel_memory_range()
     return memory_range_around_non_aligned_address((uintptr_t)&__start, (size_t)&__end - (size_t)&__start);
 }
 
-void memory_initialize(Multiboot *multiboot)
+static bool memory_range_is_reserved(Multiboot *multiboot, MemoryRange range, MemoryRange *reserved)
 {
-    logger_info("Initializing memory management...");
+    MemoryRange kernel_range = kernel_memory_range();
+
+    if (range.base < kernel_range.base + kernel_range.size &&
+        range.base + range.size > kernel_range.base)
+    {
+        *reserved = kernel_range;
+        return true;
+    }
+
+    for (size_t i = 0; i < multiboot->modules_size; i++)
+    {
+        MemoryRange module_range = multiboot->modules[i].range;
+
+        if (range.base < module_range.base + module_range.size &&
+            range.base + range.size > module_range.base)
+        {
+            *reserved = module_range;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static size_t memory_page_count(Multiboot *multiboot)
+{
+    uint64_t highest_address = 0;
+
+    for (size_t i = 0; i < multiboot->memory_map_size; i++)
+    {
+        MemoryMapEntry *entry = &multiboot->memory_map[i];
+
+        if (entry->type == MEMORY_MAP_ENTRY_AVAILABLE)
+        {
+            highest_address = MAX(highest_address, (uint64_t)entry->range.base + entry->range.size);
+        }
+    }
+
+    return MIN(highest_address / PAGE_SIZE, 1024 * 1024);
+}
 
-    for (size_t i = 0; i < 1024 * 1024 / 8; i++)
+// Find some room for the physical allocator metadata, before the allocator itself is up.
+static MemoryRange memory_find_metadata_range(Multiboot *multiboot, size_t size)
+{
+    for (size_t i = 0; i < multiboot->memory_map_size; i++)
     {
-        MEMORY[i] = 0xff;
+        MemoryMapEntry *entry = &multiboot->memory_map[i];
+
+        if (entry->type != MEMORY_MAP_ENTRY_AVAILABLE)
+        {
+            continue;
+        }
+
+        uint64_t entry_end = (uint64_t)entry->range.base + entry->range.size;
+        MemoryRange candidate = {PAGE_ALIGN_UP(MAX(entry->range.base, 0x100000)), size};
+        MemoryRange reserved = {};
+
+        while (candidate.base + (uint64_t)candidate.size <= entry_end &&
+               memory_range_is_reserved(multiboot, candidate, &reserved))
+        {
+            candidate.base = PAGE_ALIGN_UP(reserved.base + reserved.size);
+        }
+
+        if (candidate.base + (uint64_t)candidate.size <= entry_end)
+        {
+            return candidate;
+        }
     }
 
+    system_panic("No room for the physical memory allocator metadata!");
+}
+
+void memory_initialize(Multiboot *multiboot)
+{
+    logger_info("Initializing memory management...");
+
+    size_t page_count = memory_page_count(multiboot);
+    MemoryRange metadata_range = memory_find_metadata_range(multiboot, physical_metadata_size(page_count));
+
+    physical_initialize(metadata_range, page_count);
+
     // Setup the kernel pagedirectory.
     for (size_t i = 0; i < 256; i++)
     {
@@ -52,6 +129,9 @@ void memory_initialize(Multiboot *multiboot)
     USED_MEMORY = 0;
     TOTAL_MEMORY = multiboot->memory_usable;
 
+    logger_info("Mapping physical memory allocator...");
+    memory_map_identity(&kpdir, metadata_range, MEMORY_NONE);
+
     logger_info("Mapping kernel...");
     memory_map_identity(&kpdir, kernel_memory_range(), MEMORY_NONE);
 
@@ -67,6 +147,11 @@ void memory_initialize(Multiboot *multiboot)
     memory_pdir_switch(&kpdir);
     paging_enable();
 
+    if (cpuid_get_feature_EDX() & CPUID_FEAT_EDX_PGE)
+    {
+        paging_enable_global_pages();
+    }
+
     logger_info("%uKio of memory detected", TOTAL_MEMORY / 1024);
     logger_info("%uKio of memory is used by the kernel", USED_MEMORY / 1024);
 
@@ -82,6 +167,8 @@ void memory_dump()
     printf("\n\tMemory status:");
     printf("\n\t - Used  physical Memory: %12dkib", USED_MEMORY / 1024);
     printf("\n\t - Total physical Memory: %12dkib", TOTAL_MEMORY / 1024);
+    printf("\n\t - Largest free block:    %12dkib", physical_largest_free_block() / 1024);
+    printf("\n\t - Free blocks:           %12d", physical_free_block_count());
 }
 
 size_t memory_get_used()
@@ -110,6 +197,32 @@ size_t memory_get_total()
     return result;
 }
 
+size_t memory_get_largest_free()
+{
+    size_t result;
+
+    atomic_begin();
+
+    result = physical_largest_free_block();
+
+    atomic_end();
+
+    return result;
+}
+
+size_t memory_get_free_blocks()
+{
+    size_t result;
+
+    atomic_begin();
+
+    result = physical_free_block_count();
+
+    atomic_end();
+
+    return result;
+}
+
 PageDirectory *memory_kpdir()
 {
     return &kpdir;
@@ -128,15 +241,20 @@ Result memory_map(PageDirectory *page_directory, MemoryRange virtual_range, Memo
         if (!virtual_present(page_directory, virtual_address))
         {
             uintptr_t physical_address = physical_alloc(1);
-            Result virtual_map_result = virtual_map(page_directory, MemoryRange{physical_address, PAGE_SIZE}, virtual_address, flags);
+            Result virtual_map_result = virtual_map_batched(page_directory, MemoryRange{physical_address, PAGE_SIZE}, virtual_address, flags);
 
             if (virtual_map_result != SUCCESS)
             {
+                virtual_invalidate(page_directory, virtual_range);
+                atomic_end();
+
                 return virtual_map_result;
             }
         }
     }
 
+    virtual_invalidate(page_directory, virtual_range);
+
     atomic_end();
 
     if (flags & MEMORY_CLEAR)
@@ -192,16 +310,6 @@ Result memory_alloc(PageDirectory *page_directory, size_t size, MemoryFlags flag
 
     uintptr_t virtual_address = virtual_alloc(page_directory, (MemoryRange){physical_address, size}, flags).base;
 
-    if (!virtual_address)
-    {
-        physical_free(physical_address, page_count);
-        atomic_end();
-
-        logger_error("Failled to allocate memory: Not enough virtual memory!");
-
-        return ERR_OUT_OF_MEMORY;
-    }
-
     atomic_end();
 
     if (flags & MEMORY_CLEAR)
@@ -258,10 +366,12 @@ Result memory_free(PageDirectory *page_directory, MemoryRange virtual_range)
         if (virtual_present(page_directory, virtual_address))
         {
             physical_free(virtual_to_physical(page_directory, virtual_address), 1);
-            virtual_free(page_directory, (MemoryRange){virtual_address, PAGE_SIZE});
+            virtual_free_batched(page_directory, (MemoryRange){virtual_address, PAGE_SIZE});
         }
     }
 
+    virtual_invalidate(page_directory, virtual_range);
+
     atomic_end();
 
     return SUCCESS;
@@ -398,5 +508,6 @@ void memory_pdir_dump(PageDirectory *pdir, bool user)
 
 void memory_pdir_switch(PageDirectory *pdir)
 {
+    virtual_did_switch(pdir);
     paging_load_directory(virtual_to_physical(&kpdir, (uintptr_t)pdir));
 }
@@ -14,6 +14,10 @@ size_t memory_get_used();
 
 size_t memory_get_total();
 
+size_t memory_get_largest_free();
+
+size_t memory_get_free_blocks();
+
 PageDirectory *memory_kpdir();
 
 Result memory_map(PageDirectory *page_directory, MemoryRange range, MemoryFlags flags);
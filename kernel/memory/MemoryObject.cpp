@@ -1,10 +1,14 @@
+#include <libsystem/Assert.h>
 #include <libsystem/Logger.h>
+#include <libsystem/core/CString.h>
+#include <libsystem/thread/Atomic.h>
 #include <libsystem/thread/Lock.h>
 #include <libsystem/utils/List.h>
 
 #include "kernel/memory/Memory.h"
 #include "kernel/memory/MemoryObject.h"
 #include "kernel/memory/Physical.h"
+#include "kernel/memory/Virtual.h"
 
 static int _memory_object_id = 0;
 static List *_memory_objects;
@@ -24,8 +28,9 @@ MemoryObject *memory_object_create(size_t size)
 
     memory_object->id = _memory_object_id++;
     memory_object->refcount = 1;
-    memory_object->address = physical_alloc(size / PAGE_SIZE);
     memory_object->size = size;
+    memory_object->pages = (uintptr_t *)calloc(size / PAGE_SIZE, sizeof(uintptr_t));
+    memory_object->resident = 0;
 
     lock_acquire(_memory_objects_lock);
     list_pushback(_memory_objects, memory_object);
@@ -34,11 +39,48 @@ MemoryObject *memory_object_create(size_t size)
     return memory_object;
 }
 
+MemoryObject *memory_object_create_copy_on_write(MemoryObject *source)
+{
+    MemoryObject *memory_object = memory_object_create(source->size);
+
+    memory_object->source = memory_object_ref(source);
+
+    return memory_object;
+}
+
+MemoryObject *memory_object_create_borrowed(size_t size, const uintptr_t *pages, MemoryObjectReleaseCallback release, void *target)
+{
+    MemoryObject *memory_object = memory_object_create(size);
+
+    for (size_t i = 0; i < memory_object->page_count(); i++)
+    {
+        assert(pages[i]);
+        memory_object->pages[i] = pages[i];
+    }
+
+    memory_object->release = release;
+    memory_object->release_target = target;
+
+    return memory_object;
+}
+
 void memory_object_destroy(MemoryObject *memory_object)
 {
     list_remove(_memory_objects, memory_object);
 
-    physical_free(memory_object->address, PAGE_ALIGN_UP(memory_object->size) / PAGE_SIZE);
+    atomic_begin();
+
+    for (size_t i = 0; i < memory_object->page_count() && !memory_object->release; i++)
+    {
+        if (memory_object->pages[i])
+        {
+            physical_free(memory_object->pages[i], 1);
+        }
+    }
+
+    atomic_end();
+
+    free(memory_object->pages);
     free(memory_object);
 }
 
@@ -51,14 +93,32 @@ MemoryObject *memory_object_ref(MemoryObject *memory_object)
 
 void memory_object_deref(MemoryObject *memory_object)
 {
+    MemoryObject *source = nullptr;
+    MemoryObjectReleaseCallback release = nullptr;
+    void *release_target = nullptr;
+
     lock_acquire(_memory_objects_lock);
 
     if (__atomic_sub_fetch(&memory_object->refcount, 1, __ATOMIC_SEQ_CST) == 0)
     {
+        source = memory_object->source;
+        release = memory_object->release;
+        release_target = memory_object->release_target;
+
         memory_object_destroy(memory_object);
     }
 
     lock_release(_memory_objects_lock);
+
+    if (source)
+    {
+        memory_object_deref(source);
+    }
+
+    if (release)
+    {
+        release(release_target);
+    }
 }
 
 MemoryObject *memory_object_by_id(int id)
@@ -81,3 +141,91 @@ MemoryObject *memory_object_by_id(int id)
 
     return nullptr;
 }
+
+bool memory_object_page_present(MemoryObject *memory_object, size_t index)
+{
+    assert(index < memory_object->page_count());
+
+    return memory_object->pages[index] != 0;
+}
+
+bool memory_object_page_shared(MemoryObject *memory_object, size_t index)
+{
+    return !memory_object_page_present(memory_object, index) &&
+           memory_object->source &&
+           memory_object_page_present(memory_object->source, index);
+}
+
+// Fill a new page from a copy of another one or with zeros,
+// the pages are mapped in kernel space for the duration of the copy.
+static void memory_object_fill_page(uintptr_t page, uintptr_t content)
+{
+    void *destination = (void *)virtual_alloc(&kpdir, (MemoryRange){page, PAGE_SIZE}, MEMORY_NONE).base;
+
+    if (content)
+    {
+        void *source = (void *)virtual_alloc(&kpdir, (MemoryRange){content, PAGE_SIZE}, MEMORY_NONE).base;
+        memcpy(destination, source, PAGE_SIZE);
+        virtual_free(&kpdir, (MemoryRange){(uintptr_t)source, PAGE_SIZE});
+    }
+    else
+    {
+        memset(destination, 0, PAGE_SIZE);
+    }
+
+    virtual_free(&kpdir, (MemoryRange){(uintptr_t)destination, PAGE_SIZE});
+}
+
+uintptr_t memory_object_page(MemoryObject *memory_object, size_t index)
+{
+    assert(index < memory_object->page_count());
+
+    atomic_begin();
+
+    if (!memory_object->pages[index])
+    {
+        uintptr_t content = 0;
+
+        if (memory_object_page_shared(memory_object, index))
+        {
+            content = memory_object->source->pages[index];
+        }
+
+        memory_object->pages[index] = physical_alloc(1);
+        memory_object->resident++;
+
+        memory_object_fill_page(memory_object->pages[index], content);
+    }
+
+    uintptr_t page = memory_object->pages[index];
+
+    atomic_end();
+
+    return page;
+}
+
+void *memory_object_kernel_map(MemoryObject *memory_object)
+{
+    atomic_begin();
+
+    MemoryRange range = virtual_reserve(&kpdir, memory_object->size, MEMORY_NONE);
+
+    for (size_t i = 0; i < memory_object->page_count(); i++)
+    {
+        uintptr_t page = memory_object_page(memory_object, i);
+        virtual_map_batched(&kpdir, (MemoryRange){page, PAGE_SIZE}, range.base + i * PAGE_SIZE, MEMORY_NONE);
+    }
+
+    virtual_invalidate(&kpdir, range);
+
+    atomic_end();
+
+    return (void *)range.base;
+}
+
+void memory_object_kernel_unmap(MemoryObject *memory_object, void *address)
+{
+    atomic_begin();
+    virtual_free(&kpdir, (MemoryRange){(uintptr_t)address, memory_object->size});
+    atomic_end();
+}
@@ -2,21 +2,46 @@
 
 #include <libsystem/Common.h>
 
+#include "kernel/memory/Paging.h"
+
+typedef void (*MemoryObjectReleaseCallback)(void *target);
+
 struct MemoryObject
 {
     int id;
-    uintptr_t address;
     size_t size;
 
+    // Physical address of each page of the object or zero if the
+    // page was never touched, pages are allocated on first access.
+    uintptr_t *pages;
+    size_t resident;
+
+    // Copy-on-write objects read the pages they don't own yet from their source.
+    // The source must not be written to anymore.
+    MemoryObject *source;
+
+    // Objects borrowing their pages from someone else (like a file) don't free
+    // them on destruction, they call this instead.
+    MemoryObjectReleaseCallback release;
+    void *release_target;
+
+    // Every mapping of the object is read-only, like file blocks shared
+    // with all the other readers of the file.
+    bool read_only;
+
     int refcount;
 
-    auto range() { return MemoryRange{address, size}; }
+    auto page_count() { return size / PAGE_SIZE; }
 };
 
 void memory_object_initialize();
 
 MemoryObject *memory_object_create(size_t size);
 
+MemoryObject *memory_object_create_copy_on_write(MemoryObject *source);
+
+MemoryObject *memory_object_create_borrowed(size_t size, const uintptr_t *pages, MemoryObjectReleaseCallback release, void *target);
+
 void memory_object_destroy(MemoryObject *memory_object);
 
 MemoryObject *memory_object_ref(MemoryObject *memory_object);
@@ -24,3 +49,13 @@ MemoryObject *memory_object_ref(MemoryObject *memory_object);
 void memory_object_deref(MemoryObject *memory_object);
 
 MemoryObject *memory_object_by_id(int id);
+
+bool memory_object_page_present(MemoryObject *memory_object, size_t index);
+
+bool memory_object_page_shared(MemoryObject *memory_object, size_t index);
+
+uintptr_t memory_object_page(MemoryObject *memory_object, size_t index);
+
+void *memory_object_kernel_map(MemoryObject *memory_object);
+
+void memory_object_kernel_unmap(MemoryObject *memory_object, void *address);
@@ -28,7 +28,9 @@ union __packed PageTableEntry {
         bool Accessed : 1;
         bool Dirty : 1;
         bool Pat : 1;
-        uint32_t Ignored : 4;
+        bool Global : 1; // Kept in the TLB across page directory switches.
+        bool Lazy : 1; // Reserved but not present yet, it will be mapped on the first access.
+        uint32_t Available : 2;
         uint32_t PageFrameNumber : 20;
     };
 
@@ -66,3 +68,5 @@ extern "C" void paging_enable();
 extern "C" void paging_disable();
 extern "C" void paging_load_directory(uintptr_t directory);
 extern "C" void paging_invalidate_tlb();
+extern "C" void paging_invalidate_page(uintptr_t address);
+extern "C" void paging_enable_global_pages();
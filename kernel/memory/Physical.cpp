@@ -1,6 +1,7 @@
+#include <libsystem/math/MinMax.h>
 
-#include "kernel/memory/Physical.h"
 #include "kernel/memory/Paging.h"
+#include "kernel/memory/Physical.h"
 #include "kernel/system/System.h"
 
 size_t TOTAL_MEMORY = 0;
@@ -17,6 +18,195 @@ uint8_t MEMORY[1024 * 1024 / 8] = {};
 #define PHYSICAL_SET_FREE(__addr) \
     (MEMORY[(uint)(__addr) / PAGE_SIZE / 8] &= ~(1 << ((uint)(__addr) / PAGE_SIZE % 8)))
 
+/* --- Buddy allocator ------------------------------------------------------ */
+
+// The free pages are not mapped anywhere, so the free lists can't be stored
+// inside of them. Instead every page gets a small descriptor in a table
+// allocated at boot time (see memory_initialize()).
+
+#define PHYSICAL_NO_PAGE (0xffffffff)
+#define PHYSICAL_NOT_FREE (-1)
+
+struct PhysicalBlock
+{
+    uint32_t next;
+    uint32_t prev;
+
+    // Order of the free block starting at this page
+    // or PHYSICAL_NOT_FREE if this page is not the head of a free block.
+    int order;
+};
+
+static PhysicalBlock *_blocks = nullptr;
+static size_t _blocks_count = 0;
+
+static uint32_t _free_lists[PHYSICAL_MAX_ORDER + 1];
+static size_t _free_lists_size[PHYSICAL_MAX_ORDER + 1];
+
+static void physical_block_push(uint32_t page, int order)
+{
+    PhysicalBlock &block = _blocks[page];
+
+    block.order = order;
+    block.prev = PHYSICAL_NO_PAGE;
+    block.next = _free_lists[order];
+
+    if (block.next != PHYSICAL_NO_PAGE)
+    {
+        _blocks[block.next].prev = page;
+    }
+
+    _free_lists[order] = page;
+    _free_lists_size[order]++;
+}
+
+static void physical_block_remove(uint32_t page)
+{
+    PhysicalBlock &block = _blocks[page];
+
+    if (block.prev != PHYSICAL_NO_PAGE)
+    {
+        _blocks[block.prev].next = block.next;
+    }
+    else
+    {
+        _free_lists[block.order] = block.next;
+    }
+
+    if (block.next != PHYSICAL_NO_PAGE)
+    {
+        _blocks[block.next].prev = block.prev;
+    }
+
+    _free_lists_size[block.order]--;
+
+    block.order = PHYSICAL_NOT_FREE;
+    block.next = PHYSICAL_NO_PAGE;
+    block.prev = PHYSICAL_NO_PAGE;
+}
+
+static void physical_block_insert(uint32_t page, int order)
+{
+    // Merge with our buddy for as long as it is free and of the same size.
+    while (order < PHYSICAL_MAX_ORDER)
+    {
+        uint32_t buddy = page ^ (1 << order);
+
+        if (buddy >= _blocks_count || _blocks[buddy].order != order)
+        {
+            break;
+        }
+
+        physical_block_remove(buddy);
+
+        page = MIN(page, buddy);
+        order++;
+    }
+
+    physical_block_push(page, order);
+}
+
+static void physical_block_insert_range(uint32_t start, uint32_t end)
+{
+    while (start < end)
+    {
+        int order = 0;
+
+        while (order < PHYSICAL_MAX_ORDER &&
+               start % (1 << (order + 1)) == 0 &&
+               start + (1 << (order + 1)) <= end)
+        {
+            order++;
+        }
+
+        physical_block_insert(start, order);
+        start += 1 << order;
+    }
+}
+
+static bool physical_block_containing(uint32_t page, uint32_t *head, int *order)
+{
+    for (int current_order = 0; current_order <= PHYSICAL_MAX_ORDER; current_order++)
+    {
+        uint32_t current_head = __align_down(page, (uint32_t)1 << current_order);
+
+        if (_blocks[current_head].order == current_order)
+        {
+            *head = current_head;
+            *order = current_order;
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void physical_block_take_range(uint32_t start, uint32_t end)
+{
+    while (start < end)
+    {
+        uint32_t head;
+        int order;
+
+        if (!physical_block_containing(start, &head, &order))
+        {
+            system_panic("Physical page %08x is not in the free lists!", start * PAGE_SIZE);
+        }
+
+        uint32_t block_end = head + (1 << order);
+
+        physical_block_remove(head);
+        physical_block_insert_range(head, start);
+        physical_block_insert_range(MIN(end, block_end), block_end);
+
+        start = MIN(end, block_end);
+    }
+}
+
+static int physical_order_for(uint count)
+{
+    int order = 0;
+
+    while ((1u << order) < count)
+    {
+        order++;
+    }
+
+    return order;
+}
+
+size_t physical_metadata_size(size_t page_count)
+{
+    return PAGE_ALIGN_UP(page_count * sizeof(PhysicalBlock));
+}
+
+void physical_initialize(MemoryRange metadata_range, size_t page_count)
+{
+    for (size_t i = 0; i < 1024 * 1024 / 8; i++)
+    {
+        MEMORY[i] = 0xff;
+    }
+
+    _blocks = (PhysicalBlock *)metadata_range.base;
+    _blocks_count = page_count;
+
+    for (size_t i = 0; i < page_count; i++)
+    {
+        _blocks[i].next = PHYSICAL_NO_PAGE;
+        _blocks[i].prev = PHYSICAL_NO_PAGE;
+        _blocks[i].order = PHYSICAL_NOT_FREE;
+    }
+
+    for (int order = 0; order <= PHYSICAL_MAX_ORDER; order++)
+    {
+        _free_lists[order] = PHYSICAL_NO_PAGE;
+        _free_lists_size[order] = 0;
+    }
+}
+
+/* --- Physical memory API -------------------------------------------------- */
+
 int physical_is_used(uint addr, uint count)
 {
     for (uint i = 0; i < count; i++)
@@ -30,38 +220,88 @@ int physical_is_used(uint addr, uint count)
 
 void physical_set_used(uint addr, uint count)
 {
-    for (uint i = 0; i < count; i++)
+    uint32_t page = addr / PAGE_SIZE;
+    uint32_t end = page + count;
+
+    while (page < end)
     {
-        if (!PHYSICAL_IS_USED(addr + (i * PAGE_SIZE)))
+        if (PHYSICAL_IS_USED(page * PAGE_SIZE))
+        {
+            page++;
+            continue;
+        }
+
+        uint32_t run_start = page;
+
+        while (page < end && !PHYSICAL_IS_USED(page * PAGE_SIZE))
         {
             USED_MEMORY += PAGE_SIZE;
-            PHYSICAL_SET_USED(addr + (i * PAGE_SIZE));
+            PHYSICAL_SET_USED(page * PAGE_SIZE);
+            page++;
         }
+
+        physical_block_take_range(run_start, MIN(page, (uint32_t)_blocks_count));
     }
 }
 
 void physical_set_free(uint addr, uint count)
 {
-    for (uint i = 0; i < count; i++)
+    uint32_t page = addr / PAGE_SIZE;
+    uint32_t end = page + count;
+
+    while (page < end)
     {
-        if (PHYSICAL_IS_USED(addr + (i * PAGE_SIZE)))
+        if (!PHYSICAL_IS_USED(page * PAGE_SIZE))
+        {
+            page++;
+            continue;
+        }
+
+        uint32_t run_start = page;
+
+        while (page < end && PHYSICAL_IS_USED(page * PAGE_SIZE))
         {
             USED_MEMORY -= PAGE_SIZE;
-            PHYSICAL_SET_FREE(addr + (i * PAGE_SIZE));
+            PHYSICAL_SET_FREE(page * PAGE_SIZE);
+            page++;
         }
+
+        physical_block_insert_range(MIN(run_start, (uint32_t)_blocks_count), MIN(page, (uint32_t)_blocks_count));
     }
 }
 
 uint physical_alloc(uint count)
 {
-    for (uint i = 0; i < (TOTAL_MEMORY / PAGE_SIZE); i++)
+    int order = physical_order_for(count);
+
+    for (int current_order = order; current_order <= PHYSICAL_MAX_ORDER; current_order++)
     {
-        uint addr = i * PAGE_SIZE;
-        if (!physical_is_used(addr, count))
+        if (_free_lists[current_order] == PHYSICAL_NO_PAGE)
         {
-            physical_set_used(addr, count);
-            return addr;
+            continue;
         }
+
+        uint32_t page = _free_lists[current_order];
+        physical_block_remove(page);
+
+        // Split the block until it has the right size.
+        while (current_order > order)
+        {
+            current_order--;
+            physical_block_push(page + (1 << current_order), current_order);
+        }
+
+        // Give back the pages we don't need.
+        physical_block_insert_range(page + count, page + (1 << order));
+
+        for (uint i = 0; i < count; i++)
+        {
+            PHYSICAL_SET_USED((page + i) * PAGE_SIZE);
+        }
+
+        USED_MEMORY += count * PAGE_SIZE;
+
+        return page * PAGE_SIZE;
     }
 
     system_panic("Out of physical memory!\n\tTrying to allocat %d pages but free memory is %d pages !", count, (TOTAL_MEMORY - USED_MEMORY) / PAGE_SIZE);
@@ -72,3 +312,28 @@ void physical_free(uint addr, uint count)
 {
     physical_set_free(addr, count);
 }
+
+size_t physical_largest_free_block()
+{
+    for (int order = PHYSICAL_MAX_ORDER; order >= 0; order--)
+    {
+        if (_free_lists[order] != PHYSICAL_NO_PAGE)
+        {
+            return (1 << order) * PAGE_SIZE;
+        }
+    }
+
+    return 0;
+}
+
+size_t physical_free_block_count()
+{
+    size_t count = 0;
+
+    for (int order = 0; order <= PHYSICAL_MAX_ORDER; order++)
+    {
+        count += _free_lists_size[order];
+    }
+
+    return count;
+}
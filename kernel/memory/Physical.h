@@ -2,10 +2,19 @@
 
 #include <libsystem/Common.h>
 
+#include "kernel/memory/MemoryRange.h"
+
+// Blocks of 2^order pages, an order 20 block span the whole 4Gio address space.
+#define PHYSICAL_MAX_ORDER 20
+
 extern size_t TOTAL_MEMORY;
 extern size_t USED_MEMORY;
 extern uint8_t MEMORY[1024 * 1024 / 8];
 
+size_t physical_metadata_size(size_t page_count);
+
+void physical_initialize(MemoryRange metadata_range, size_t page_count);
+
 uint physical_alloc(uint count);
 
 void physical_free(uint addr, uint count);
@@ -15,3 +24,7 @@ int physical_is_used(uint addr, uint count);
 void physical_set_used(uint addr, uint count);
 
 void physical_set_free(uint addr, uint count);
+
+size_t physical_largest_free_block();
+
+size_t physical_free_block_count();
@@ -1,3 +1,9 @@
+#include <libsystem/Assert.h>
+#include <libsystem/Logger.h>
+#include <libsystem/core/CString.h>
+#include <libsystem/math/MinMax.h>
+#include <libsystem/thread/Atomic.h>
+
 #include "kernel/memory/Virtual.h"
 #include "kernel/memory/Memory.h"
 #include "kernel/system/System.h"
@@ -5,9 +11,291 @@
 #define PD_INDEX(vaddr) ((vaddr) >> 22)
 #define PT_INDEX(vaddr) (((vaddr) >> 12) & 0x03ff)
 
+#define VIRTUAL_KERNEL_SPACE_END (256 * 1024 * PAGE_SIZE)
+
+// Above this many pages, reloading CR3 is cheaper than invalidating the pages one by one.
+#define VIRTUAL_INVALIDATE_THRESHOLD 32
+
 PageDirectory kpdir __aligned(PAGE_SIZE) = {};
 PageTable kptable[256] __aligned(PAGE_SIZE) = {};
 
+static PageDirectory *_active_page_directory = &kpdir;
+
+void virtual_did_switch(PageDirectory *page_directory)
+{
+    _active_page_directory = page_directory;
+}
+
+void virtual_invalidate(PageDirectory *page_directory, MemoryRange virtual_range)
+{
+    bool is_kernel_space = virtual_range.base < VIRTUAL_KERNEL_SPACE_END;
+
+    // The user half of inactive page directories can't be in the TLB.
+    if (!is_kernel_space && page_directory != _active_page_directory)
+    {
+        return;
+    }
+
+    size_t page_count = virtual_range.size / PAGE_SIZE;
+
+    // Kernel pages are global and survive a CR3 reload.
+    if (!is_kernel_space && page_count > VIRTUAL_INVALIDATE_THRESHOLD)
+    {
+        paging_invalidate_tlb();
+    }
+    else
+    {
+        for (size_t i = 0; i < page_count; i++)
+        {
+            paging_invalidate_page(virtual_range.base + i * PAGE_SIZE);
+        }
+    }
+}
+
+/* --- Kernel address space ------------------------------------------------- */
+
+// The kernel half of the address space is shared by every page directory, its
+// free ranges are tracked in a sorted table. It starts in a static array since
+// the heap itself gets its memory from here, and moves to pages of its own
+// when it gets too fragmented.
+
+#define VIRTUAL_KERNEL_FREE_RANGES 256
+
+// Slots kept free for the inserts done while the table is being grown.
+#define VIRTUAL_KERNEL_FREE_RANGES_SPARE 16
+
+// We skip the first page to make null deref trigger a page fault.
+static MemoryRange _kernel_free_ranges_initial[VIRTUAL_KERNEL_FREE_RANGES] = {
+    {PAGE_SIZE, VIRTUAL_KERNEL_SPACE_END - PAGE_SIZE},
+};
+
+static MemoryRange *_kernel_free_ranges = _kernel_free_ranges_initial;
+static size_t _kernel_free_ranges_capacity = VIRTUAL_KERNEL_FREE_RANGES;
+static size_t _kernel_free_ranges_count = 1;
+static bool _kernel_free_ranges_growing = false;
+
+static uintptr_t virtual_range_end(MemoryRange range)
+{
+    return range.base + range.size;
+}
+
+// Index of the first free range ending at or after the address.
+static size_t virtual_kernel_lower_bound(uintptr_t address)
+{
+    size_t low = 0;
+    size_t high = _kernel_free_ranges_count;
+
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+
+        if (virtual_range_end(_kernel_free_ranges[middle]) < address)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+static void virtual_kernel_insert_at(size_t index, MemoryRange range)
+{
+    if (_kernel_free_ranges_count == _kernel_free_ranges_capacity)
+    {
+        system_panic("Kernel address space is too fragmented!");
+    }
+
+    memmove(
+        &_kernel_free_ranges[index + 1],
+        &_kernel_free_ranges[index],
+        sizeof(MemoryRange) * (_kernel_free_ranges_count - index));
+
+    _kernel_free_ranges[index] = range;
+    _kernel_free_ranges_count++;
+}
+
+static void virtual_kernel_remove_at(size_t index, size_t count)
+{
+    _kernel_free_ranges_count -= count;
+
+    memmove(
+        &_kernel_free_ranges[index],
+        &_kernel_free_ranges[index + count],
+        sizeof(MemoryRange) * (_kernel_free_ranges_count - index));
+}
+
+// Must be called once the table is consistent again, since allocating the new
+// table takes and gives back ranges itself.
+static void virtual_kernel_grow_if_needed()
+{
+    if (_kernel_free_ranges_growing ||
+        _kernel_free_ranges_count + VIRTUAL_KERNEL_FREE_RANGES_SPARE < _kernel_free_ranges_capacity)
+    {
+        return;
+    }
+
+    _kernel_free_ranges_growing = true;
+
+    MemoryRange *old_ranges = _kernel_free_ranges;
+    size_t old_size = _kernel_free_ranges_capacity * sizeof(MemoryRange);
+
+    size_t new_capacity = _kernel_free_ranges_capacity * 2;
+    size_t new_size = PAGE_ALIGN_UP(new_capacity * sizeof(MemoryRange));
+    MemoryRange *new_ranges = nullptr;
+
+    if (memory_alloc(&kpdir, new_size, MEMORY_NONE, (uintptr_t *)&new_ranges) == SUCCESS)
+    {
+        memcpy(new_ranges, _kernel_free_ranges, sizeof(MemoryRange) * _kernel_free_ranges_count);
+
+        _kernel_free_ranges = new_ranges;
+        _kernel_free_ranges_capacity = new_size / sizeof(MemoryRange);
+
+        if (old_ranges != _kernel_free_ranges_initial)
+        {
+            memory_free(&kpdir, (MemoryRange){(uintptr_t)old_ranges, PAGE_ALIGN_UP(old_size)});
+        }
+    }
+
+    _kernel_free_ranges_growing = false;
+}
+
+static MemoryRange virtual_kernel_clip(MemoryRange range)
+{
+    uintptr_t start = MAX(range.base, PAGE_SIZE);
+    uintptr_t end = MIN(virtual_range_end(range), VIRTUAL_KERNEL_SPACE_END);
+
+    if (range.base >= VIRTUAL_KERNEL_SPACE_END || start >= end)
+    {
+        return (MemoryRange){0, 0};
+    }
+
+    return (MemoryRange){start, end - start};
+}
+
+// Remove a range from the free ranges, parts of it might already be in use.
+static void virtual_kernel_take(MemoryRange range)
+{
+    range = virtual_kernel_clip(range);
+
+    if (memory_range_empty(range))
+    {
+        return;
+    }
+
+    atomic_begin();
+
+    size_t index = virtual_kernel_lower_bound(range.base + 1);
+
+    while (index < _kernel_free_ranges_count &&
+           _kernel_free_ranges[index].base < virtual_range_end(range))
+    {
+        MemoryRange current = _kernel_free_ranges[index];
+
+        bool has_before = current.base < range.base;
+        bool has_after = virtual_range_end(current) > virtual_range_end(range);
+
+        MemoryRange before = {current.base, range.base - current.base};
+        MemoryRange after = {virtual_range_end(range), virtual_range_end(current) - virtual_range_end(range)};
+
+        if (has_before && has_after)
+        {
+            _kernel_free_ranges[index] = before;
+            virtual_kernel_insert_at(index + 1, after);
+            break;
+        }
+        else if (has_before)
+        {
+            _kernel_free_ranges[index] = before;
+            index++;
+        }
+        else if (has_after)
+        {
+            _kernel_free_ranges[index] = after;
+            break;
+        }
+        else
+        {
+            virtual_kernel_remove_at(index, 1);
+        }
+    }
+
+    virtual_kernel_grow_if_needed();
+
+    atomic_end();
+}
+
+// Add a range back to the free ranges, merging it with its neighbours.
+static void virtual_kernel_give_back(MemoryRange range)
+{
+    range = virtual_kernel_clip(range);
+
+    if (memory_range_empty(range))
+    {
+        return;
+    }
+
+    atomic_begin();
+
+    size_t first = virtual_kernel_lower_bound(range.base);
+    size_t last = first;
+
+    uintptr_t start = range.base;
+    uintptr_t end = virtual_range_end(range);
+
+    while (last < _kernel_free_ranges_count &&
+           _kernel_free_ranges[last].base <= end)
+    {
+        start = MIN(start, _kernel_free_ranges[last].base);
+        end = MAX(end, virtual_range_end(_kernel_free_ranges[last]));
+        last++;
+    }
+
+    if (first == last)
+    {
+        virtual_kernel_insert_at(first, (MemoryRange){start, end - start});
+    }
+    else
+    {
+        _kernel_free_ranges[first] = (MemoryRange){start, end - start};
+        virtual_kernel_remove_at(first + 1, last - first - 1);
+    }
+
+    virtual_kernel_grow_if_needed();
+
+    atomic_end();
+}
+
+// First fit.
+static uintptr_t virtual_kernel_alloc(size_t size)
+{
+    uintptr_t address = 0;
+
+    atomic_begin();
+
+    for (size_t i = 0; i < _kernel_free_ranges_count; i++)
+    {
+        if (_kernel_free_ranges[i].size >= size)
+        {
+            address = _kernel_free_ranges[i].base;
+            virtual_kernel_take((MemoryRange){address, size});
+            break;
+        }
+    }
+
+    atomic_end();
+
+    if (!address)
+    {
+        system_panic("Out of virtual memory!");
+    }
+
+    return address;
+}
+
 bool virtual_present(PageDirectory *page_directory, uintptr_t virtual_address)
 {
     int page_directory_index = PD_INDEX(virtual_address);
@@ -54,84 +342,124 @@ uintptr_t virtual_to_physical(PageDirectory *page_directory, uintptr_t virtual_a
     return (page_table_entry.PageFrameNumber * PAGE_SIZE) + (virtual_address & 0xfff);
 }
 
-Result virtual_map(PageDirectory *page_directory, MemoryRange physical_range, uintptr_t virtual_address, MemoryFlags flags)
+static Result virtual_page_table(PageDirectory *page_directory, uintptr_t virtual_address, MemoryFlags flags, PageTable **out_page_table)
 {
+    PageDirectoryEntry &page_directory_entry = page_directory->entries[PD_INDEX(virtual_address)];
+    PageTable *page_table = reinterpret_cast<PageTable *>(page_directory_entry.PageFrameNumber * PAGE_SIZE);
+
+    if (!page_directory_entry.Present)
+    {
+        Result alloc_result = memory_alloc_identity(page_directory, MEMORY_CLEAR, (uintptr_t *)&page_table);
+
+        if (alloc_result != SUCCESS)
+        {
+            return alloc_result;
+        }
+
+        page_directory_entry.Present = 1;
+        page_directory_entry.Write = 1;
+        page_directory_entry.User = flags & MEMORY_USER;
+        page_directory_entry.PageFrameNumber = (uint32_t)(page_table) >> 12;
+    }
+
+    *out_page_table = page_table;
+
+    return SUCCESS;
+}
+
+Result virtual_map_batched(PageDirectory *page_directory, MemoryRange physical_range, uintptr_t virtual_address, MemoryFlags flags)
+{
+    virtual_kernel_take((MemoryRange){virtual_address, physical_range.size});
+
     for (size_t i = 0; i < physical_range.size / PAGE_SIZE; i++)
     {
         size_t offset = i * PAGE_SIZE;
 
-        int page_directory_index = PD_INDEX(virtual_address + offset);
-        PageDirectoryEntry &page_directory_entry = page_directory->entries[page_directory_index];
-        PageTable *page_table = reinterpret_cast<PageTable *>(page_directory_entry.PageFrameNumber * PAGE_SIZE);
+        PageTable *page_table = nullptr;
+        Result page_table_result = virtual_page_table(page_directory, virtual_address + offset, flags, &page_table);
 
-        if (!page_directory_entry.Present)
+        if (page_table_result != SUCCESS)
         {
-            Result alloc_result = memory_alloc_identity(page_directory, MEMORY_CLEAR, (uintptr_t *)&page_table);
-
-            if (alloc_result != SUCCESS)
-            {
-                return alloc_result;
-            }
-
-            page_directory_entry.Present = 1;
-            page_directory_entry.Write = 1;
-            page_directory_entry.User = flags & MEMORY_USER;
-            page_directory_entry.PageFrameNumber = (uint32_t)(page_table) >> 12;
+            return page_table_result;
         }
 
         int page_table_index = PT_INDEX(virtual_address + offset);
         PageTableEntry &page_table_entry = page_table->entries[page_table_index];
 
+        page_table_entry.as_uint = 0;
         page_table_entry.Present = 1;
-        page_table_entry.Write = 1;
+        page_table_entry.Write = !(flags & MEMORY_READONLY);
         page_table_entry.User = flags & MEMORY_USER;
+        page_table_entry.PageLevelWriteThrough = flags & MEMORY_UNCACHED;
+        page_table_entry.PageLevelCacheDisable = flags & MEMORY_UNCACHED;
+        page_table_entry.Global = virtual_address + offset < VIRTUAL_KERNEL_SPACE_END;
         page_table_entry.PageFrameNumber = (physical_range.base + offset) >> 12;
     }
 
-    paging_invalidate_tlb();
-
     return SUCCESS;
 }
 
+Result virtual_map(PageDirectory *page_directory, MemoryRange physical_range, uintptr_t virtual_address, MemoryFlags flags)
+{
+    Result result = virtual_map_batched(page_directory, physical_range, virtual_address, flags);
+
+    virtual_invalidate(page_directory, (MemoryRange){virtual_address, physical_range.size});
+
+    return result;
+}
+
 MemoryRange virtual_alloc(PageDirectory *page_directory, MemoryRange physical_range, MemoryFlags flags)
 {
-    bool is_user_memory = flags & MEMORY_USER;
+    assert(!(flags & MEMORY_USER));
 
-    uintptr_t virtual_address = 0;
-    size_t current_size = 0;
+    uintptr_t virtual_address = virtual_kernel_alloc(physical_range.size);
 
-    // we skip the first page to make null deref trigger a page fault
-    for (size_t i = (is_user_memory ? 256 : 1) * 1024; i < (is_user_memory ? 1024 : 256) * 1024; i++)
-    {
-        uintptr_t current_address = i * PAGE_SIZE;
+    virtual_map(page_directory, physical_range, virtual_address, flags);
 
-        if (!virtual_present(page_directory, current_address))
-        {
-            if (current_size == 0)
-            {
-                virtual_address = current_address;
-            }
+    return (MemoryRange){virtual_address, physical_range.size};
+}
+
+MemoryRange virtual_reserve(PageDirectory *page_directory, size_t size, MemoryFlags flags)
+{
+    assert(!(flags & MEMORY_USER));
 
-            current_size += PAGE_SIZE;
+    uintptr_t virtual_address = virtual_kernel_alloc(size);
 
-            if (current_size == physical_range.size)
-            {
-                virtual_map(page_directory, physical_range, virtual_address, flags);
+    virtual_reserve_at(page_directory, (MemoryRange){virtual_address, size}, flags);
 
-                return (MemoryRange){virtual_address, current_size};
-            }
-        }
-        else
+    return (MemoryRange){virtual_address, size};
+}
+
+Result virtual_reserve_at(PageDirectory *page_directory, MemoryRange virtual_range, MemoryFlags flags)
+{
+    virtual_kernel_take(virtual_range);
+
+    for (size_t i = 0; i < virtual_range.size / PAGE_SIZE; i++)
+    {
+        uintptr_t virtual_address = virtual_range.base + i * PAGE_SIZE;
+
+        PageTable *page_table = nullptr;
+        Result page_table_result = virtual_page_table(page_directory, virtual_address, flags, &page_table);
+
+        if (page_table_result != SUCCESS)
         {
-            current_size = 0;
+            return page_table_result;
         }
+
+        PageTableEntry &page_table_entry = page_table->entries[PT_INDEX(virtual_address)];
+
+        page_table_entry.as_uint = 0;
+        page_table_entry.Lazy = 1;
+        page_table_entry.User = flags & MEMORY_USER;
     }
 
-    system_panic("Out of virtual memory!");
+    return SUCCESS;
 }
 
-void virtual_free(PageDirectory *page_directory, MemoryRange virtual_range)
+void virtual_free_batched(PageDirectory *page_directory, MemoryRange virtual_range)
 {
+    virtual_kernel_give_back(virtual_range);
+
     for (size_t i = 0; i < virtual_range.size / PAGE_SIZE; i++)
     {
         size_t offset = i * PAGE_SIZE;
@@ -139,14 +467,22 @@ void virtual_free(PageDirectory *page_directory, MemoryRange virtual_range)
         size_t page_directory_index = PD_INDEX(virtual_range.base + offset);
         PageDirectoryEntry *page_directory_entry = &page_directory->entries[page_directory_index];
 
+        if (!page_directory_entry->Present)
+        {
+            continue;
+        }
+
         PageTable *page_table = (PageTable *)(page_directory_entry->PageFrameNumber * PAGE_SIZE);
 
         size_t page_table_index = PT_INDEX(virtual_range.base + offset);
         PageTableEntry *page_table_entry = &page_table->entries[page_table_index];
 
-        if (page_table_entry->Present)
-            page_table_entry->as_uint = 0;
+        page_table_entry->as_uint = 0;
     }
+}
 
-    paging_invalidate_tlb();
+void virtual_free(PageDirectory *page_directory, MemoryRange virtual_range)
+{
+    virtual_free_batched(page_directory, virtual_range);
+    virtual_invalidate(page_directory, virtual_range);
 }
@@ -16,6 +16,20 @@ uintptr_t virtual_to_physical(PageDirectory *page_directory, uintptr_t virtual_a
 
 Result virtual_map(PageDirectory *page_directory, MemoryRange physical_range, uintptr_t virtual_address, MemoryFlags flags);
 
+// Same as virtual_map() and virtual_free() but without invalidating the TLB,
+// call virtual_invalidate() once the whole range has been updated.
+Result virtual_map_batched(PageDirectory *page_directory, MemoryRange physical_range, uintptr_t virtual_address, MemoryFlags flags);
+
+void virtual_free_batched(PageDirectory *page_directory, MemoryRange virtual_range);
+
+void virtual_invalidate(PageDirectory *page_directory, MemoryRange virtual_range);
+
+void virtual_did_switch(PageDirectory *page_directory);
+
 MemoryRange virtual_alloc(PageDirectory *page_directory, MemoryRange physical_range, MemoryFlags flags);
 
+MemoryRange virtual_reserve(PageDirectory *page_directory, size_t size, MemoryFlags flags);
+
+Result virtual_reserve_at(PageDirectory *page_directory, MemoryRange virtual_range, MemoryFlags flags);
+
 void virtual_free(PageDirectory *page_directory, MemoryRange virtual_range);
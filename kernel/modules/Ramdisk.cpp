@@ -5,8 +5,8 @@
 #include <libsystem/core/CString.h>
 
 #include "kernel/filesystem/Filesystem.h"
-#include "kernel/memory/Memory.h"
 #include "kernel/modules/Modules.h"
+#include "kernel/node/File.h"
 
 void ramdisk_load(Module *module)
 {
@@ -26,24 +26,14 @@ void ramdisk_load(Module *module)
         }
         else if ((block.typeflag & 8) == 0 || (block.typeflag & 8) == 5)
         {
-            FsHandle *handle = nullptr;
-            Result result = filesystem_open(file_path, OPEN_WRITE | OPEN_CREATE, &handle);
+            // The file reads straight from the module, it gets copied only when written to or mapped.
+            FsNode *file = file_create_borrowed(block.data, block.size);
+            Result result = filesystem_link_and_take_ref(file_path, file);
 
             if (result != SUCCESS)
             {
-                logger_warn("Failed to open file %s! %s", block.name, result_to_string(result));
-                continue;
+                logger_warn("Failed to create file %s! %s", block.name, result_to_string(result));
             }
-
-            size_t written = 0;
-            result = fshandle_write(handle, block.data, block.size, &written);
-
-            if (result != SUCCESS)
-            {
-                logger_error("Failled to write file: %s", result_to_string(result));
-            }
-
-            fshandle_destroy(handle);
         }
         else if (block.name[strlen(block.name) - 1] != '/')
         {
@@ -55,7 +45,7 @@ void ramdisk_load(Module *module)
         path_destroy(file_path);
     }
 
-    memory_free(memory_kpdir(), module->range);
+    // The module is not freed, files loaded from the ramdisk are still using it.
 
     logger_info("Loading ramdisk succeeded.");
 }
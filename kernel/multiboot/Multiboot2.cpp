@@ -4,6 +4,7 @@
 
 #include <thirdparty/multiboot/Multiboot2.h>
 
+#include "arch/x86/ACPI.h"
 #include "kernel/multiboot/Multiboot.h"
 
 bool is_multiboot2(uint32_t magic)
@@ -148,6 +149,11 @@ void multiboot2_parse_header(Multiboot *multiboot, void *header_ptr)
             multiboot2_parse_framebuffer(multiboot, (struct multiboot_tag_framebuffer_common *)tag);
             break;
 
+        case MULTIBOOT_TAG_TYPE_ACPI_OLD:
+        case MULTIBOOT_TAG_TYPE_ACPI_NEW:
+            multiboot->acpi_rsdt_address = ((RSDP *)((struct multiboot_tag_old_acpi *)tag)->rsdp)->rsdt_address;
+            break;
+
         default:
             logger_warn("\t\t-> IGNORED");
             break;
@@ -2,6 +2,7 @@
 #include <libsystem/Logger.h>
 #include <libsystem/Result.h>
 #include <libsystem/core/CString.h>
+#include <libsystem/utils/Hash.h>
 
 #include "kernel/node/Directory.h"
 #include "kernel/node/Handle.h"
@@ -68,33 +69,78 @@ static Result directory_read(FsDirectory *node, FsHandle *handle, void *buffer,
     return SUCCESS;
 }
 
-static FsNode *directory_find(FsDirectory *node, const char *name)
+#define DIRECTORY_INITIAL_BUCKETS 8
+
+static void directory_rehash(FsDirectory *node, size_t new_count)
 {
-    list_foreach(FsDirectoryEntry, entry, node->childs)
+    FsDirectoryEntry **new_buckets = (FsDirectoryEntry **)calloc(new_count, sizeof(FsDirectoryEntry *));
+
+    for (size_t i = 0; i < node->buckets_count; i++)
     {
-        if (strcmp(entry->name, name) == 0)
+        FsDirectoryEntry *entry = node->buckets[i];
+
+        while (entry)
         {
-            return fsnode_ref(entry->node);
+            FsDirectoryEntry *next = entry->next_in_bucket;
+
+            entry->next_in_bucket = new_buckets[entry->hash % new_count];
+            new_buckets[entry->hash % new_count] = entry;
+
+            entry = next;
         }
-    };
+    }
+
+    free(node->buckets);
+    node->buckets = new_buckets;
+    node->buckets_count = new_count;
+}
+
+static FsDirectoryEntry **directory_lookup(FsDirectory *node, const char *name)
+{
+    uint32_t hash = hash_string(name);
+
+    FsDirectoryEntry **entry = &node->buckets[hash % node->buckets_count];
+
+    while (*entry && ((*entry)->hash != hash || strcmp((*entry)->name, name) != 0))
+    {
+        entry = &(*entry)->next_in_bucket;
+    }
+
+    return entry;
+}
+
+static FsNode *directory_find(FsDirectory *node, const char *name)
+{
+    FsDirectoryEntry *entry = *directory_lookup(node, name);
+
+    if (entry)
+    {
+        return fsnode_ref(entry->node);
+    }
 
     return nullptr;
 }
 
 static Result directory_link(FsDirectory *node, const char *name, FsNode *child)
 {
-    list_foreach(FsDirectoryEntry, entry, node->childs)
+    if (*directory_lookup(node, name))
     {
-        if (strcmp(entry->name, name) == 0)
-        {
-            return ERR_FILE_EXISTS;
-        }
-    };
+        return ERR_FILE_EXISTS;
+    }
+
+    if ((size_t)node->childs->count() >= node->buckets_count)
+    {
+        directory_rehash(node, node->buckets_count * 2);
+    }
 
     FsDirectoryEntry *new_entry = __create(FsDirectoryEntry);
 
     new_entry->node = fsnode_ref(child);
     strcpy(new_entry->name, name);
+    new_entry->hash = hash_string(name);
+
+    new_entry->next_in_bucket = node->buckets[new_entry->hash % node->buckets_count];
+    node->buckets[new_entry->hash % node->buckets_count] = new_entry;
 
     list_pushback(node->childs, new_entry);
 
@@ -109,23 +155,26 @@ static void directory_entry_destroy(FsDirectoryEntry *entry)
 
 static Result directory_unlink(FsDirectory *node, const char *name)
 {
-    list_foreach(FsDirectoryEntry, entry, node->childs)
-    {
-        if (strcmp(entry->name, name) == 0)
-        {
-            list_remove(node->childs, entry);
-            directory_entry_destroy(entry);
+    FsDirectoryEntry **slot = directory_lookup(node, name);
+    FsDirectoryEntry *entry = *slot;
 
-            return SUCCESS;
-        }
+    if (!entry)
+    {
+        return ERR_NO_SUCH_FILE_OR_DIRECTORY;
     }
 
-    return ERR_NO_SUCH_FILE_OR_DIRECTORY;
+    *slot = entry->next_in_bucket;
+
+    list_remove(node->childs, entry);
+    directory_entry_destroy(entry);
+
+    return SUCCESS;
 }
 
 static void directory_destroy(FsDirectory *node)
 {
     list_destroy_with_callback(node->childs, (ListDestroyElementCallback)directory_entry_destroy);
+    free(node->buckets);
 }
 
 FsNode *directory_create()
@@ -143,6 +192,8 @@ FsNode *directory_create()
     directory->destroy = (FsNodeDestroyCallback)directory_destroy;
 
     directory->childs = list_create();
+    directory->buckets = (FsDirectoryEntry **)calloc(DIRECTORY_INITIAL_BUCKETS, sizeof(FsDirectoryEntry *));
+    directory->buckets_count = DIRECTORY_INITIAL_BUCKETS;
 
     return (FsNode *)directory;
 }
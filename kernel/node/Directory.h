@@ -12,11 +12,19 @@ struct FsDirectoryEntry
 {
     char name[FILE_NAME_LENGTH];
     FsNode *node;
+
+    uint32_t hash;
+    FsDirectoryEntry *next_in_bucket;
 };
 
 struct FsDirectory : public FsNode
 {
+    // Keeps the entries in creation order for listing.
     List *childs;
+
+    // Hash table of the same entries for lookups by name.
+    FsDirectoryEntry **buckets;
+    size_t buckets_count;
 };
 
 FsNode *directory_create();
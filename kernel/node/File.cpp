@@ -4,17 +4,118 @@
 #include <libsystem/core/CString.h>
 #include <libsystem/math/MinMax.h>
 
+#include "kernel/memory/Memory.h"
+#include "kernel/memory/MemoryObject.h"
+#include "kernel/memory/Virtual.h"
 #include "kernel/node/File.h"
 #include "kernel/node/Handle.h"
 
+uintptr_t file_block(FsFile *file, size_t index)
+{
+    if (index >= file->blocks_allocated)
+    {
+        return 0;
+    }
+
+    return file->blocks[index];
+}
+
+static Result file_block_ensure(FsFile *file, size_t index, uintptr_t *block)
+{
+    if (index >= file->blocks_allocated)
+    {
+        size_t new_allocated = MAX(16, file->blocks_allocated * 2);
+
+        while (new_allocated <= index)
+        {
+            new_allocated *= 2;
+        }
+
+        uintptr_t *new_blocks = (uintptr_t *)realloc(file->blocks, new_allocated * sizeof(uintptr_t));
+
+        if (!new_blocks)
+        {
+            return ERR_OUT_OF_MEMORY;
+        }
+
+        memset(new_blocks + file->blocks_allocated, 0, (new_allocated - file->blocks_allocated) * sizeof(uintptr_t));
+
+        file->blocks = new_blocks;
+        file->blocks_allocated = new_allocated;
+    }
+
+    if (!file->blocks[index])
+    {
+        Result result = memory_alloc(memory_kpdir(), PAGE_SIZE, MEMORY_CLEAR, &file->blocks[index]);
+
+        if (result != SUCCESS)
+        {
+            return result;
+        }
+    }
+
+    *block = file->blocks[index];
+
+    return SUCCESS;
+}
+
+static Result file_unborrow(FsFile *file)
+{
+    if (!file->borrowed)
+    {
+        return SUCCESS;
+    }
+
+    for (size_t offset = 0; offset < file->content_size; offset += PAGE_SIZE)
+    {
+        uintptr_t block = 0;
+        Result result = file_block_ensure(file, offset / PAGE_SIZE, &block);
+
+        if (result != SUCCESS)
+        {
+            return result;
+        }
+
+        memcpy((void *)block, file->borrowed + offset, MIN(PAGE_SIZE, file->content_size - offset));
+    }
+
+    file->borrowed = nullptr;
+
+    return SUCCESS;
+}
+
+static void file_truncate(FsFile *file)
+{
+    bool mapped = __atomic_load_n(&file->mappings, __ATOMIC_SEQ_CST) > 0;
+
+    for (size_t i = 0; i < file->blocks_allocated; i++)
+    {
+        if (!file->blocks[i])
+        {
+            continue;
+        }
+
+        if (mapped)
+        {
+            // Someone still has the page mapped, keep it around but don't leak the old content.
+            memset((void *)file->blocks[i], 0, PAGE_SIZE);
+        }
+        else
+        {
+            memory_free(memory_kpdir(), (MemoryRange){file->blocks[i], PAGE_SIZE});
+            file->blocks[i] = 0;
+        }
+    }
+
+    file->borrowed = nullptr;
+    file->content_size = 0;
+}
+
 static Result file_open(FsFile *node, FsHandle *handle)
 {
     if (fshandle_has_flag(handle, OPEN_TRUNC))
     {
-        free(node->buffer);
-        node->buffer = (char *)malloc(512);
-        node->buffer_allocated = 512;
-        node->buffer_size = 0;
+        file_truncate(node);
     }
 
     return SUCCESS;
@@ -22,27 +123,84 @@ static Result file_open(FsFile *node, FsHandle *handle)
 
 static Result file_read(FsFile *node, FsHandle *handle, void *buffer, size_t size, size_t *read)
 {
-    if (handle->offset <= node->buffer_size)
+    if (handle->offset >= node->content_size)
+    {
+        return SUCCESS;
+    }
+
+    size = MIN(node->content_size - handle->offset, size);
+
+    size_t offset = handle->offset;
+    size_t done = 0;
+
+    while (done < size)
     {
-        *read = MIN(node->buffer_size - handle->offset, size);
-        memcpy(buffer, (char *)node->buffer + handle->offset, *read);
+        size_t in_block = offset % PAGE_SIZE;
+        size_t chunk = MIN(PAGE_SIZE - in_block, size - done);
+
+        uintptr_t block = file_block(node, offset / PAGE_SIZE);
+
+        if (node->borrowed)
+        {
+            memcpy((char *)buffer + done, node->borrowed + offset, chunk);
+        }
+        else if (block)
+        {
+            memcpy((char *)buffer + done, (char *)block + in_block, chunk);
+        }
+        else
+        {
+            memset((char *)buffer + done, 0, chunk);
+        }
+
+        offset += chunk;
+        done += chunk;
     }
 
+    *read = done;
+
     return SUCCESS;
 }
 
 static Result file_write(FsFile *node, FsHandle *handle, const void *buffer, size_t size, size_t *written)
 {
-    if ((handle->offset + size) > node->buffer_allocated)
+    Result result = file_unborrow(node);
+
+    if (result != SUCCESS)
     {
-        node->buffer = (char *)realloc(node->buffer, handle->offset + size);
-        node->buffer_allocated = handle->offset + size;
+        return result;
     }
 
-    node->buffer_size = MAX(handle->offset + size, node->buffer_size);
-    memcpy((char *)(node->buffer) + handle->offset, buffer, size);
+    size_t offset = handle->offset;
+    size_t done = 0;
+
+    while (done < size)
+    {
+        size_t in_block = offset % PAGE_SIZE;
+        size_t chunk = MIN(PAGE_SIZE - in_block, size - done);
+
+        uintptr_t block = 0;
+        result = file_block_ensure(node, offset / PAGE_SIZE, &block);
+
+        if (result != SUCCESS)
+        {
+            // Report what made it to the file, if anything did.
+            if (done == 0)
+            {
+                return result;
+            }
+
+            break;
+        }
 
-    *written = size;
+        memcpy((char *)block + in_block, (const char *)buffer + done, chunk);
+
+        offset += chunk;
+        done += chunk;
+    }
+
+    node->content_size = MAX(offset, node->content_size);
+    *written = done;
 
     return SUCCESS;
 }
@@ -51,12 +209,68 @@ static size_t file_size(FsFile *node, FsHandle *handle)
 {
     __unused(handle);
 
-    return node->buffer_size;
+    return node->content_size;
+}
+
+static void file_unmap(FsFile *node)
+{
+    __atomic_sub_fetch(&node->mappings, 1, __ATOMIC_SEQ_CST);
+    fsnode_deref(node);
+}
+
+static Result file_map(FsFile *node, FsHandle *handle, MemoryObject **memory_object)
+{
+    __unused(handle);
+
+    if (node->content_size == 0)
+    {
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    Result result = file_unborrow(node);
+
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    size_t page_count = PAGE_ALIGN_UP(node->content_size) / PAGE_SIZE;
+    uintptr_t *pages = (uintptr_t *)calloc(page_count, sizeof(uintptr_t));
+
+    for (size_t i = 0; i < page_count; i++)
+    {
+        // Holes get a real page so the mapping stays in sync with later writes.
+        uintptr_t block = 0;
+        result = file_block_ensure(node, i, &block);
+
+        if (result != SUCCESS)
+        {
+            free(pages);
+            return result;
+        }
+
+        pages[i] = virtual_to_physical(memory_kpdir(), block);
+    }
+
+    __atomic_add_fetch(&node->mappings, 1, __ATOMIC_SEQ_CST);
+
+    *memory_object = memory_object_create_borrowed(
+        page_count * PAGE_SIZE,
+        pages,
+        (MemoryObjectReleaseCallback)file_unmap,
+        fsnode_ref(node));
+
+    (*memory_object)->read_only = true;
+
+    free(pages);
+
+    return SUCCESS;
 }
 
 static void file_destroy(FsFile *node)
 {
-    free(node->buffer);
+    file_truncate(node);
+    free(node->blocks);
 }
 
 FsNode *file_create()
@@ -69,11 +283,22 @@ FsNode *file_create()
     file->read = (FsNodeReadCallback)file_read;
     file->write = (FsNodeWriteCallback)file_write;
     file->size = (FsNodeSizeCallback)file_size;
+    file->map = (FsNodeMapCallback)file_map;
     file->destroy = (FsNodeDestroyCallback)file_destroy;
 
-    file->buffer = (char *)malloc(512);
-    file->buffer_allocated = 512;
-    file->buffer_size = 0;
+    file->blocks = nullptr;
+    file->blocks_allocated = 0;
+    file->content_size = 0;
+
+    return (FsNode *)file;
+}
+
+FsNode *file_create_borrowed(const void *content, size_t size)
+{
+    FsFile *file = (FsFile *)file_create();
+
+    file->borrowed = (const char *)content;
+    file->content_size = size;
 
     return (FsNode *)file;
 }
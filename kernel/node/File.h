@@ -2,11 +2,23 @@
 
 #include "kernel/node/Node.h"
 
+// The content of a file is stored in page sized blocks, holes are read as zeros.
 struct FsFile : public FsNode
 {
-    char *buffer;
-    size_t buffer_allocated;
-    size_t buffer_size;
+    uintptr_t *blocks;
+    size_t blocks_allocated;
+    size_t content_size;
+
+    // Content living somewhere else in kernel memory (like the ramdisk module),
+    // copied to blocks the first time the file is written to or mapped.
+    const char *borrowed;
+
+    // Number of memory objects using the blocks, they can't be freed until it drops to zero.
+    int mappings;
 };
 
 FsNode *file_create();
+
+FsNode *file_create_borrowed(const void *content, size_t size);
+
+uintptr_t file_block(FsFile *file, size_t index);
@@ -0,0 +1,98 @@
+#include <libjson/Json.h>
+#include <libsystem/Logger.h>
+#include <libsystem/Result.h>
+#include <libsystem/core/CString.h>
+#include <libsystem/math/MinMax.h>
+
+#include "kernel/filesystem/Cache.h"
+#include "kernel/filesystem/Filesystem.h"
+#include "kernel/node/FilesystemInfo.h"
+#include "kernel/node/Handle.h"
+
+static Result filesystem_info_open(FsFilesystemInfo *node, FsHandle *handle)
+{
+    __unused(node);
+
+    FilesystemCacheStats stats = filesystem_cache_stats();
+
+    JsonValue *root = json_create_object();
+
+    json_object_put(root, "lookups", json_create_integer(stats.lookups));
+    json_object_put(root, "hits", json_create_integer(stats.hits));
+    json_object_put(root, "misses", json_create_integer(stats.misses));
+    json_object_put(root, "walked", json_create_integer(stats.walked));
+    json_object_put(root, "invalidations", json_create_integer(stats.invalidations));
+
+    if (stats.lookups)
+    {
+        json_object_put(root, "hit_rate_percent", json_create_integer(stats.hits * 100 / stats.lookups));
+        json_object_put(root, "average_walk_x100", json_create_integer(stats.walked * 100 / stats.lookups));
+    }
+
+    handle->attached = json_stringify(root);
+    handle->attached_size = strlen((const char *)handle->attached);
+
+    json_destroy(root);
+
+    return SUCCESS;
+}
+
+static void filesystem_info_close(FsFilesystemInfo *node, FsHandle *handle)
+{
+    __unused(node);
+
+    if (handle->attached)
+    {
+        free(handle->attached);
+    }
+}
+
+static Result filesystem_info_read(FsFilesystemInfo *node, FsHandle *handle, void *buffer, size_t size, size_t *read)
+{
+    __unused(node);
+
+    if (handle->offset <= handle->attached_size)
+    {
+        *read = MIN(handle->attached_size - handle->offset, size);
+        memcpy(buffer, (char *)handle->attached + handle->offset, *read);
+    }
+
+    return SUCCESS;
+}
+
+static size_t filesystem_info_size(FsFilesystemInfo *node, FsHandle *handle)
+{
+    __unused(node);
+
+    if (handle == nullptr)
+    {
+        return 0;
+    }
+    else
+    {
+        return handle->attached_size;
+    }
+}
+
+static FsNode *filesystem_info_create()
+{
+    FsFilesystemInfo *info = __create(FsFilesystemInfo);
+
+    fsnode_init(info, FILE_TYPE_DEVICE);
+
+    info->open = (FsNodeOpenCallback)filesystem_info_open;
+    info->close = (FsNodeCloseCallback)filesystem_info_close;
+    info->read = (FsNodeReadCallback)filesystem_info_read;
+    info->size = (FsNodeSizeCallback)filesystem_info_size;
+
+    return (FsNode *)info;
+}
+
+void filesystem_info_initialize()
+{
+    FsNode *filesystem_info_device = filesystem_info_create();
+
+    Path *filesystem_info_device_path = path_create("/System/filesystem");
+    filesystem_link_and_take_ref(filesystem_info_device_path, filesystem_info_device);
+    path_destroy(filesystem_info_device_path);
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include "kernel/node/Node.h"
+
+struct FsFilesystemInfo : public FsNode
+{
+};
+
+void filesystem_info_initialize();
@@ -5,8 +5,10 @@
 #include <libsystem/core/CString.h>
 #include <libsystem/math/MinMax.h>
 
+#include "kernel/memory/MemoryObject.h"
 #include "kernel/node/Connection.h"
 #include "kernel/node/Handle.h"
+#include "kernel/node/Pipe.h"
 #include "kernel/scheduling/Blocker.h"
 #include "kernel/scheduling/Scheduler.h"
 
@@ -120,7 +122,45 @@ void fshandle_release_lock(FsHandle *handle, int who_release)
     lock_release_by(handle->lock, who_release);
 }
 
-Result fshandle_read(FsHandle *handle, void *buffer, size_t size, size_t *read)
+// Take the lock of the node once it can be read or written, without going
+// through a blocker when that's already the case (like for regular files).
+static void fshandle_acquire_for_read(FsHandle *handle)
+{
+    FsNode *node = handle->node;
+    int who = scheduler_running_id();
+
+    if (fsnode_try_acquire_lock(node, who))
+    {
+        if (fsnode_can_read(node, handle))
+        {
+            return;
+        }
+
+        fsnode_release_lock(node, who);
+    }
+
+    task_block(scheduler_running(), blocker_read_create(handle), -1);
+}
+
+static void fshandle_acquire_for_write(FsHandle *handle)
+{
+    FsNode *node = handle->node;
+    int who = scheduler_running_id();
+
+    if (fsnode_try_acquire_lock(node, who))
+    {
+        if (fsnode_can_write(node, handle))
+        {
+            return;
+        }
+
+        fsnode_release_lock(node, who);
+    }
+
+    task_block(scheduler_running(), blocker_write_create(handle), -1);
+}
+
+static Result fshandle_check_readable(FsHandle *handle)
 {
     if (!fshandle_has_flag(handle, OPEN_READ) &&
         !fshandle_has_flag(handle, OPEN_MASTER) &&
@@ -130,31 +170,126 @@ Result fshandle_read(FsHandle *handle, void *buffer, size_t size, size_t *read)
         return ERR_WRITE_ONLY_STREAM;
     }
 
+    if (!handle->node->read)
+    {
+        return ERR_NOT_READABLE;
+    }
+
+    return SUCCESS;
+}
+
+static Result fshandle_check_writable(FsHandle *handle)
+{
+    if (!fshandle_has_flag(handle, OPEN_WRITE) &&
+        !fshandle_has_flag(handle, OPEN_MASTER) &&
+        !fshandle_has_flag(handle, OPEN_SERVER) &&
+        !fshandle_has_flag(handle, OPEN_CLIENT))
+    {
+        return ERR_READ_ONLY_STREAM;
+    }
+
+    if (!handle->node->write)
+    {
+        return ERR_NOT_WRITABLE;
+    }
+
+    return SUCCESS;
+}
+
+// Only nodes with a size can be accessed at a given offset.
+static Result fshandle_check_positional(FsHandle *handle)
+{
     FsNode *node = handle->node;
 
-    if (!node->read)
+    if ((node->type != FILE_TYPE_REGULAR && node->type != FILE_TYPE_DEVICE) || !node->size)
     {
-        return ERR_NOT_READABLE;
+        return ERR_OPERATION_NOT_SUPPORTED;
     }
 
-    task_block(scheduler_running(), blocker_read_create(handle), -1);
+    return SUCCESS;
+}
+
+// Fill the vectors one after the other while holding the lock, stopping at the first short read.
+static Result fshandle_read_internal(FsHandle *handle, const IOVector *vectors, size_t count, size_t *read)
+{
+    FsNode *node = handle->node;
+    Result result = SUCCESS;
 
     *read = 0;
 
-    Result result = node->read(node, handle, buffer, size, read);
+    fshandle_acquire_for_read(handle);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t read_this_time = 0;
+
+        result = node->read(node, handle, vectors[i].buffer, vectors[i].size, &read_this_time);
+
+        handle->offset += read_this_time;
+        *read += read_this_time;
 
-    handle->offset += *read;
+        if (result != SUCCESS || read_this_time < vectors[i].size)
+        {
+            break;
+        }
+    }
 
     fsnode_release_lock(node, scheduler_running_id());
 
     return result;
 }
 
+Result fshandle_read(FsHandle *handle, void *buffer, size_t size, size_t *read)
+{
+    IOVector vector = {buffer, size};
+
+    return fshandle_readv(handle, &vector, 1, read);
+}
+
+Result fshandle_readv(FsHandle *handle, const IOVector *vectors, size_t count, size_t *read)
+{
+    *read = 0;
+
+    Result result = fshandle_check_readable(handle);
+
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    return fshandle_read_internal(handle, vectors, count, read);
+}
+
+Result fshandle_pread(FsHandle *handle, void *buffer, size_t size, size_t offset, size_t *read)
+{
+    *read = 0;
+
+    Result result = fshandle_check_readable(handle);
+
+    if (result == SUCCESS)
+    {
+        result = fshandle_check_positional(handle);
+    }
+
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    // Work on a copy, the offset of the handle is left untouched.
+    FsHandle positioned = *handle;
+    positioned.offset = offset;
+
+    IOVector vector = {buffer, size};
+
+    return fshandle_read_internal(&positioned, &vector, 1, read);
+}
+
 static Result fshandle_write_internal(FsHandle *handle, const void *buffer, size_t size, size_t *written)
 {
     FsNode *node = handle->node;
 
-    task_block(scheduler_running(), blocker_write_create(handle), -1);
+    fshandle_acquire_for_write(handle);
 
     if (fshandle_has_flag(handle, OPEN_APPEND))
     {
@@ -175,39 +310,165 @@ static Result fshandle_write_internal(FsHandle *handle, const void *buffer, size
     return result;
 }
 
-Result fshandle_write(FsHandle *handle, const void *buffer, size_t size, size_t *written)
+// Keep writing until everything made it or something went wrong.
+static Result fshandle_write_all(FsHandle *handle, const void *buffer, size_t size, size_t *written)
 {
     int remaining = size;
     Result result = SUCCESS;
     size_t written_this_time = 0;
 
+    while (remaining > 0 && result == SUCCESS)
+    {
+        result = fshandle_write_internal(
+            handle,
+            (void *)((uintptr_t)buffer + (size - remaining)),
+            remaining,
+            &written_this_time);
+
+        remaining -= written_this_time;
+    }
+
+    *written = size - remaining;
+    return result;
+}
+
+Result fshandle_write(FsHandle *handle, const void *buffer, size_t size, size_t *written)
+{
     *written = 0;
 
-    if (!fshandle_has_flag(handle, OPEN_WRITE) &&
-        !fshandle_has_flag(handle, OPEN_MASTER) &&
-        !fshandle_has_flag(handle, OPEN_SERVER) &&
-        !fshandle_has_flag(handle, OPEN_CLIENT))
+    Result result = fshandle_check_writable(handle);
+
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    return fshandle_write_all(handle, buffer, size, written);
+}
+
+Result fshandle_writev(FsHandle *handle, const IOVector *vectors, size_t count, size_t *written)
+{
+    *written = 0;
+
+    Result result = fshandle_check_writable(handle);
+
+    for (size_t i = 0; i < count && result == SUCCESS; i++)
+    {
+        size_t written_this_time = 0;
+
+        result = fshandle_write_all(handle, vectors[i].buffer, vectors[i].size, &written_this_time);
+
+        *written += written_this_time;
+    }
+
+    return result;
+}
+
+Result fshandle_pwrite(FsHandle *handle, const void *buffer, size_t size, size_t offset, size_t *written)
+{
+    *written = 0;
+
+    Result result = fshandle_check_writable(handle);
+
+    if (result == SUCCESS)
+    {
+        result = fshandle_check_positional(handle);
+    }
+
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    FsHandle positioned = *handle;
+    positioned.offset = offset;
+    positioned.flags &= ~OPEN_APPEND;
+
+    return fshandle_write_all(&positioned, buffer, size, written);
+}
+
+// Wait until the source can be read and the destination written, without
+// holding the lock of one end while blocking on the other.
+static void fshandle_splice_lock(FsHandle *source, FsHandle *destination)
+{
+    int who = scheduler_running_id();
+
+    while (true)
+    {
+        task_block(scheduler_running(), blocker_read_create(source), -1);
+
+        if (fsnode_try_acquire_lock(destination->node, who))
+        {
+            if (fsnode_can_write(destination->node, destination))
+            {
+                return;
+            }
+
+            fsnode_release_lock(destination->node, who);
+        }
+
+        fsnode_release_lock(source->node, who);
+
+        task_block(scheduler_running(), blocker_write_create(destination), -1);
+        fsnode_release_lock(destination->node, who);
+    }
+}
+
+Result fshandle_splice(FsHandle *source, FsHandle *destination, size_t size, size_t *spliced)
+{
+    *spliced = 0;
+
+    if (!fshandle_has_flag(source, OPEN_READ))
+    {
+        return ERR_WRITE_ONLY_STREAM;
+    }
+
+    if (!fshandle_has_flag(destination, OPEN_WRITE))
     {
         return ERR_READ_ONLY_STREAM;
     }
 
-    if (!handle->node->write)
+    FsNode *source_node = source->node;
+    FsNode *destination_node = destination->node;
+
+    if (!source_node->read)
+    {
+        return ERR_NOT_READABLE;
+    }
+
+    if (!destination_node->write)
     {
         return ERR_NOT_WRITABLE;
     }
 
-    while (remaining > 0 && result == SUCCESS)
+    // One of the ends has to be a pipe, it is used as the buffer in between.
+    if (source_node == destination_node ||
+        (source_node->type != FILE_TYPE_PIPE && destination_node->type != FILE_TYPE_PIPE))
     {
-        result = fshandle_write_internal(
-            handle,
-            (void *)((uintptr_t)buffer + (size - remaining)),
-            remaining,
-            &written_this_time);
+        return ERR_INVALID_ARGUMENT;
+    }
 
-        remaining -= written_this_time;
+    fshandle_splice_lock(source, destination);
+
+    if (fshandle_has_flag(destination, OPEN_APPEND) && destination_node->size)
+    {
+        destination->offset = destination_node->size(destination_node, destination);
     }
 
-    *written = size - remaining;
+    Result result = SUCCESS;
+
+    if (source_node->type == FILE_TYPE_PIPE)
+    {
+        result = fspipe_splice_to((FsPipe *)source_node, destination_node, destination, size, spliced);
+    }
+    else
+    {
+        result = fspipe_splice_from((FsPipe *)destination_node, source_node, source, size, spliced);
+    }
+
+    fsnode_release_lock(destination_node, scheduler_running_id());
+    fsnode_release_lock(source_node, scheduler_running_id());
+
     return result;
 }
 
@@ -306,6 +567,41 @@ Result fshandle_call(FsHandle *handle, IOCall request, void *args)
     return result;
 }
 
+// The memory object is rounded up to whole pages, size is the part of it
+// holding the content of the node.
+Result fshandle_map(FsHandle *handle, MemoryObject **memory_object, size_t *size)
+{
+    if (!fshandle_has_flag(handle, OPEN_READ))
+    {
+        return ERR_WRITE_ONLY_STREAM;
+    }
+
+    FsNode *node = handle->node;
+
+    if (!node->map)
+    {
+        return ERR_OPERATION_NOT_SUPPORTED;
+    }
+
+    fsnode_acquire_lock(node, scheduler_running_id());
+
+    Result result = node->map(node, handle, memory_object);
+
+    if (result == SUCCESS)
+    {
+        *size = (*memory_object)->size;
+
+        if (node->size)
+        {
+            *size = MIN(node->size(node, handle), *size);
+        }
+    }
+
+    fsnode_release_lock(node, scheduler_running_id());
+
+    return result;
+}
+
 Result fshandle_stat(FsHandle *handle, FileState *stat)
 {
     Result result = SUCCESS;
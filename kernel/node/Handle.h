@@ -27,6 +27,11 @@ void fshandle_release_lock(FsHandle *handle, int who_release);
 
 Result fshandle_read(FsHandle *handle, void *buffer, size_t size, size_t *read);
 Result fshandle_write(FsHandle *handle, const void *buffer, size_t size, size_t *written);
+Result fshandle_readv(FsHandle *handle, const IOVector *vectors, size_t count, size_t *read);
+Result fshandle_writev(FsHandle *handle, const IOVector *vectors, size_t count, size_t *written);
+Result fshandle_pread(FsHandle *handle, void *buffer, size_t size, size_t offset, size_t *read);
+Result fshandle_pwrite(FsHandle *handle, const void *buffer, size_t size, size_t offset, size_t *written);
+Result fshandle_splice(FsHandle *source, FsHandle *destination, size_t size, size_t *spliced);
 
 Result fshandle_seek(FsHandle *handle, int offset, Whence whence);
 Result fshandle_tell(FsHandle *handle, Whence whence, int *offset);
@@ -34,5 +39,7 @@ Result fshandle_tell(FsHandle *handle, Whence whence, int *offset);
 Result fshandle_call(FsHandle *handle, IOCall request, void *args);
 Result fshandle_stat(FsHandle *handle, FileState *stat);
 
+Result fshandle_map(FsHandle *handle, MemoryObject **memory_object, size_t *size);
+
 Result fshandle_connect(FsNode *node, FsHandle **connection_handle);
 Result fshandle_accept(FsHandle *handle, FsHandle **connection_handle);
@@ -3,6 +3,7 @@
 #include <libsystem/Logger.h>
 
 #include "kernel/filesystem/Filesystem.h"
+#include "kernel/node/Poll.h"
 
 void fsnode_init(FsNode *node, FileType type)
 {
@@ -27,6 +28,13 @@ void fsnode_deref(FsNode *node)
             node->destroy(node);
         }
 
+        wait_queue_destroy(&node->waiters);
+
+        if (node->poll_watches)
+        {
+            list_destroy(node->poll_watches);
+        }
+
         free(node);
     }
 }
@@ -37,7 +45,10 @@ FsNode *fsnode_ref_handle(FsNode *node, OpenFlag flags)
         __atomic_add_fetch(&node->readers, 1, __ATOMIC_SEQ_CST);
 
     if (flags & OPEN_WRITE)
+    {
         __atomic_add_fetch(&node->writers, 1, __ATOMIC_SEQ_CST);
+        __atomic_add_fetch(&node->generation, 1, __ATOMIC_SEQ_CST);
+    }
 
     if (flags & OPEN_CLIENT)
         __atomic_add_fetch(&node->clients, 1, __ATOMIC_SEQ_CST);
@@ -48,6 +59,8 @@ FsNode *fsnode_ref_handle(FsNode *node, OpenFlag flags)
     if (flags & OPEN_MASTER)
         __atomic_add_fetch(&node->master, 1, __ATOMIC_SEQ_CST);
 
+    fsnode_wake(node);
+
     return fsnode_ref(node);
 }
 
@@ -68,6 +81,7 @@ void fsnode_deref_handle(FsNode *node, OpenFlag flags)
     if (flags & OPEN_MASTER)
         __atomic_sub_fetch(&node->master, 1, __ATOMIC_SEQ_CST);
 
+    fsnode_wake(node);
     fsnode_deref(node);
 }
 
@@ -129,7 +143,22 @@ void fsnode_acquire_lock(FsNode *node, int who_acquire)
     lock_acquire_by(node->lock, who_acquire);
 }
 
+bool fsnode_try_acquire_lock(FsNode *node, int who_acquire)
+{
+    return lock_try_acquire_by(node->lock, who_acquire);
+}
+
 void fsnode_release_lock(FsNode *node, int who_release)
 {
     lock_release_by(node->lock, who_release);
+
+    // Releasing the lock is the end of any operation on the node,
+    // so this is where the waiting tasks might be able to make progress.
+    fsnode_wake(node);
+}
+
+void fsnode_wake(FsNode *node)
+{
+    wait_queue_wake(&node->waiters);
+    fspoll_notify(node);
 }
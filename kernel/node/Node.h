@@ -4,8 +4,11 @@
 #include <libsystem/io/Stream.h>
 #include <libsystem/thread/Lock.h>
 
+#include "kernel/scheduling/WaitQueue.h"
+
 struct FsNode;
 struct FsHandle;
+struct MemoryObject;
 
 typedef Result (*FsNodeOpenCallback)(struct FsNode *node, struct FsHandle *handle);
 typedef void (*FsNodeCloseCallback)(struct FsNode *node, struct FsHandle *handle);
@@ -25,6 +28,8 @@ typedef Result (*FsNodeStatCallback)(struct FsNode *node, struct FsHandle *handl
 
 typedef size_t (*FsNodeSizeCallback)(struct FsNode *node, struct FsHandle *handle);
 
+typedef Result (*FsNodeMapCallback)(struct FsNode *node, struct FsHandle *handle, struct MemoryObject **memory_object);
+
 typedef struct FsNode *(*FsNodeOpenConnectionCallback)(struct FsNode *node);
 
 typedef void (*FsNodeAcceptCallback)(struct FsNode *node);
@@ -41,12 +46,20 @@ struct FsNode
     Lock lock;
     uint refcount;
 
+    WaitQueue waiters;
+
+    // Poll sets watching this node, see kernel/node/Poll.cpp.
+    List *poll_watches;
+
     uint readers;
     uint writers;
     uint clients;
     uint server;
     uint master;
 
+    // Incremented each time the node is opened for writing.
+    uint generation;
+
     FsNodeOpenCallback open;
     FsNodeCloseCallback close;
     FsNodeCanReadCallback can_read;
@@ -59,6 +72,7 @@ struct FsNode
     FsNodeCallCallback call;
     FsNodeStatCallback stat;
     FsNodeSizeCallback size;
+    FsNodeMapCallback map;
 
     FsNodeOpenConnectionCallback open_connection;
     FsNodeAcceptConnectionCallback accept_connection;
@@ -92,4 +106,8 @@ bool fsnode_is_acquire(FsNode *node);
 
 void fsnode_acquire_lock(FsNode *node, int who_acquire);
 
+bool fsnode_try_acquire_lock(FsNode *node, int who_acquire);
+
 void fsnode_release_lock(FsNode *node, int who_release);
+
+void fsnode_wake(FsNode *node);
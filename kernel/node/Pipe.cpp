@@ -1,10 +1,14 @@
 
 #include <libsystem/Result.h>
+#include <libsystem/math/MinMax.h>
 
+#include "kernel/memory/Paging.h"
 #include "kernel/node/Handle.h"
 #include "kernel/node/Pipe.h"
 
-#define PIPE_BUFFER_SIZE 4096
+// Pipe buffers are sized in pages.
+#define PIPE_DEFAULT_CAPACITY (16 * PAGE_SIZE)
+#define PIPE_MAX_CAPACITY (256 * PAGE_SIZE)
 
 static bool pipe_can_read(FsPipe *node, FsHandle *handle)
 {
@@ -26,7 +30,8 @@ static Result pipe_read(FsPipe *node, FsHandle *handle, void *buffer, size_t siz
 {
     __unused(handle);
 
-    if (!node->writers)
+    // What was written before the last writer went away can still be read.
+    if (!node->writers && ringbuffer_is_empty(node->buffer))
     {
         return ERR_STREAM_CLOSED;
     }
@@ -50,12 +55,65 @@ static Result pipe_write(FsPipe *node, FsHandle *handle, const void *buffer, siz
     return SUCCESS;
 }
 
+static Result pipe_set_capacity(FsPipe *node, size_t capacity)
+{
+    capacity = PAGE_ALIGN_UP(MAX(capacity, (size_t)PAGE_SIZE));
+
+    if (capacity > PIPE_MAX_CAPACITY || capacity < ringbuffer_used(node->buffer))
+    {
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    RingBuffer *buffer = ringbuffer_create(capacity);
+
+    const char *span = nullptr;
+    size_t span_size = 0;
+
+    while ((span_size = ringbuffer_readable_span(node->buffer, &span)) != 0)
+    {
+        ringbuffer_write(buffer, span, span_size);
+        ringbuffer_consume(node->buffer, span_size);
+    }
+
+    ringbuffer_destroy(node->buffer);
+
+    node->buffer = buffer;
+    node->capacity = capacity;
+
+    return SUCCESS;
+}
+
+static Result pipe_call(FsPipe *node, FsHandle *handle, IOCall request, void *args)
+{
+    __unused(handle);
+
+    IOCallPipeCapacityArgs *capacity_args = (IOCallPipeCapacityArgs *)args;
+
+    switch (request)
+    {
+    case IOCALL_PIPE_GET_CAPACITY:
+        capacity_args->capacity = node->capacity;
+
+        return SUCCESS;
+
+    case IOCALL_PIPE_SET_CAPACITY:
+    {
+        Result result = pipe_set_capacity(node, capacity_args->capacity);
+        capacity_args->capacity = node->capacity;
+
+        return result;
+    }
+
+    default:
+        return ERR_INAPPROPRIATE_CALL_FOR_DEVICE;
+    }
+}
+
 static size_t pipe_size(FsPipe *node, FsHandle *handle)
 {
-    __unused(node);
     __unused(handle);
 
-    return PIPE_BUFFER_SIZE;
+    return node->capacity;
 }
 
 static void pipe_destroy(FsPipe *node)
@@ -73,10 +131,90 @@ FsNode *fspipe_create()
     pipe->can_write = (FsNodeCanWriteCallback)pipe_can_write;
     pipe->read = (FsNodeReadCallback)pipe_read;
     pipe->write = (FsNodeWriteCallback)pipe_write;
+    pipe->call = (FsNodeCallCallback)pipe_call;
     pipe->size = (FsNodeSizeCallback)pipe_size;
     pipe->destroy = (FsNodeDestroyCallback)pipe_destroy;
 
-    pipe->buffer = ringbuffer_create(PIPE_BUFFER_SIZE);
+    pipe->buffer = ringbuffer_create(PIPE_DEFAULT_CAPACITY);
+    pipe->capacity = PIPE_DEFAULT_CAPACITY;
 
     return (FsNode *)pipe;
 }
+
+// Hand the content of the pipe straight to the write callback of another node.
+// Both nodes must be locked by the caller.
+Result fspipe_splice_to(FsPipe *pipe, FsNode *node, FsHandle *handle, size_t size, size_t *spliced)
+{
+    *spliced = 0;
+
+    if (!pipe->writers && ringbuffer_is_empty(pipe->buffer))
+    {
+        return ERR_STREAM_CLOSED;
+    }
+
+    Result result = SUCCESS;
+
+    while (*spliced < size && result == SUCCESS)
+    {
+        const char *span = nullptr;
+        size_t span_size = MIN(ringbuffer_readable_span(pipe->buffer, &span), size - *spliced);
+
+        if (span_size == 0)
+        {
+            break;
+        }
+
+        size_t written = 0;
+        result = node->write(node, handle, span, span_size, &written);
+
+        handle->offset += written;
+        ringbuffer_consume(pipe->buffer, written);
+        *spliced += written;
+
+        if (written < span_size)
+        {
+            break;
+        }
+    }
+
+    return result;
+}
+
+// Let the read callback of another node fill the pipe in place.
+// Both nodes must be locked by the caller.
+Result fspipe_splice_from(FsPipe *pipe, FsNode *node, FsHandle *handle, size_t size, size_t *spliced)
+{
+    *spliced = 0;
+
+    if (!pipe->readers)
+    {
+        return ERR_STREAM_CLOSED;
+    }
+
+    Result result = SUCCESS;
+
+    while (*spliced < size && result == SUCCESS)
+    {
+        char *span = nullptr;
+        size_t span_size = MIN(ringbuffer_writable_span(pipe->buffer, &span), size - *spliced);
+
+        if (span_size == 0)
+        {
+            break;
+        }
+
+        size_t read = 0;
+        result = node->read(node, handle, span, span_size, &read);
+
+        handle->offset += read;
+        ringbuffer_commit(pipe->buffer, read);
+        *spliced += read;
+
+        if (read < span_size)
+        {
+            break;
+        }
+    }
+
+    return result;
+}
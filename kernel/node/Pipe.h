@@ -7,6 +7,11 @@
 struct FsPipe : public FsNode
 {
     RingBuffer *buffer;
+    size_t capacity;
 };
 
 FsNode *fspipe_create();
+
+Result fspipe_splice_to(FsPipe *pipe, FsNode *node, FsHandle *handle, size_t size, size_t *spliced);
+
+Result fspipe_splice_from(FsPipe *pipe, FsNode *node, FsHandle *handle, size_t size, size_t *spliced);
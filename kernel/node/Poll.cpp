@@ -0,0 +1,208 @@
+#include <libsystem/Assert.h>
+#include <libsystem/Result.h>
+#include <libsystem/thread/Atomic.h>
+
+#include "kernel/node/Poll.h"
+
+static void poll_watch_set_pending(FsPollWatch *watch)
+{
+    ASSERT_ATOMIC;
+
+    if (!watch->pending)
+    {
+        watch->pending = true;
+        list_pushback(watch->poll->pending, watch);
+    }
+}
+
+static void poll_watch_destroy(FsPollWatch *watch)
+{
+    atomic_begin();
+
+    if (watch->pending)
+    {
+        list_remove(watch->poll->pending, watch);
+    }
+
+    list_remove(watch->node->poll_watches, watch);
+
+    atomic_end();
+
+    fsnode_deref(watch->node);
+    free(watch);
+}
+
+static bool poll_can_read(FsPoll *poll, FsHandle *handle)
+{
+    __unused(handle);
+
+    return !poll->pending->empty();
+}
+
+static void poll_destroy(FsPoll *poll)
+{
+    for (size_t i = 0; i < PROCESS_HANDLE_COUNT; i++)
+    {
+        if (poll->watches[i])
+        {
+            poll_watch_destroy(poll->watches[i]);
+        }
+    }
+
+    list_destroy(poll->pending);
+}
+
+FsNode *fspoll_create()
+{
+    FsPoll *poll = __create(FsPoll);
+
+    fsnode_init(poll, FILE_TYPE_POLL);
+
+    poll->can_read = (FsNodeCanReadCallback)poll_can_read;
+    poll->destroy = (FsNodeDestroyCallback)poll_destroy;
+
+    poll->pending = list_create();
+
+    return (FsNode *)poll;
+}
+
+Result fspoll_add(FsPoll *poll, int handle, FsNode *node, SelectEvent events)
+{
+    if (handle < 0 || handle >= PROCESS_HANDLE_COUNT)
+    {
+        return ERR_BAD_FILE_DESCRIPTOR;
+    }
+
+    // Polls watching each other would keep each other alive.
+    if (node->type == FILE_TYPE_POLL)
+    {
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    if (poll->watches[handle])
+    {
+        return ERR_FILE_EXISTS;
+    }
+
+    FsPollWatch *watch = __create(FsPollWatch);
+
+    watch->poll = poll;
+    watch->node = fsnode_ref(node);
+    watch->handle = handle;
+    watch->events = events;
+
+    poll->watches[handle] = watch;
+
+    atomic_begin();
+
+    if (node->poll_watches == nullptr)
+    {
+        node->poll_watches = list_create();
+    }
+
+    list_pushback(node->poll_watches, watch);
+
+    // The node might already be ready.
+    poll_watch_set_pending(watch);
+
+    atomic_end();
+
+    return SUCCESS;
+}
+
+Result fspoll_modify(FsPoll *poll, int handle, SelectEvent events)
+{
+    if (handle < 0 || handle >= PROCESS_HANDLE_COUNT || !poll->watches[handle])
+    {
+        return ERR_BAD_FILE_DESCRIPTOR;
+    }
+
+    FsPollWatch *watch = poll->watches[handle];
+
+    atomic_begin();
+
+    watch->events = events;
+    poll_watch_set_pending(watch);
+
+    atomic_end();
+
+    return SUCCESS;
+}
+
+Result fspoll_remove(FsPoll *poll, int handle)
+{
+    if (handle < 0 || handle >= PROCESS_HANDLE_COUNT || !poll->watches[handle])
+    {
+        return ERR_BAD_FILE_DESCRIPTOR;
+    }
+
+    poll_watch_destroy(poll->watches[handle]);
+    poll->watches[handle] = nullptr;
+
+    return SUCCESS;
+}
+
+// Check the pending watches and report the ones that are ready.
+// Watches stay pending as long as they are ready, like a level triggered select().
+// The poll lock must be held so watches are not removed under our feet.
+size_t fspoll_collect(FsPoll *poll, FsPollSelectCallback callback, void *target, HandlePollEvent *events, size_t count)
+{
+    size_t ready = 0;
+
+    atomic_begin();
+    size_t pending_count = poll->pending->count();
+    atomic_end();
+
+    for (size_t i = 0; i < pending_count && ready < count; i++)
+    {
+        atomic_begin();
+
+        FsPollWatch *watch = nullptr;
+        list_pop(poll->pending, (void **)&watch);
+        watch->pending = false;
+
+        atomic_end();
+
+        SelectEvent selected = 0;
+
+        if (callback(target, watch->handle, watch->node, watch->events, &selected) != SUCCESS)
+        {
+            // The handle was closed or now refers to something else.
+            poll->watches[watch->handle] = nullptr;
+            poll_watch_destroy(watch);
+
+            continue;
+        }
+
+        if (selected)
+        {
+            events[ready] = (HandlePollEvent){watch->handle, selected};
+            ready++;
+
+            atomic_begin();
+            poll_watch_set_pending(watch);
+            atomic_end();
+        }
+    }
+
+    return ready;
+}
+
+void fspoll_notify(FsNode *node)
+{
+    atomic_begin();
+
+    if (node->poll_watches)
+    {
+        list_foreach(FsPollWatch, watch, node->poll_watches)
+        {
+            if (!watch->pending)
+            {
+                poll_watch_set_pending(watch);
+                fsnode_wake(watch->poll);
+            }
+        }
+    }
+
+    atomic_end();
+}
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <abi/Process.h>
+
+#include <libsystem/utils/List.h>
+
+#include "kernel/node/Node.h"
+
+struct FsPoll;
+
+struct FsPollWatch
+{
+    FsPoll *poll;
+    FsNode *node;
+
+    int handle;
+    SelectEvent events;
+
+    // The watch is in the pending list of its poll.
+    bool pending;
+};
+
+// A persistent set of handles the kernel keeps an eye on.
+// Watches are moved to the pending list when their node wakes up,
+// so waiting on the set only has to check the ones that changed.
+struct FsPoll : public FsNode
+{
+    FsPollWatch *watches[PROCESS_HANDLE_COUNT];
+    List *pending;
+};
+
+typedef Result (*FsPollSelectCallback)(void *target, int handle, FsNode *node, SelectEvent events, SelectEvent *selected);
+
+FsNode *fspoll_create();
+
+Result fspoll_add(FsPoll *poll, int handle, FsNode *node, SelectEvent events);
+
+Result fspoll_modify(FsPoll *poll, int handle, SelectEvent events);
+
+Result fspoll_remove(FsPoll *poll, int handle);
+
+size_t fspoll_collect(FsPoll *poll, FsPollSelectCallback callback, void *target, HandlePollEvent *events, size_t count);
+
+void fspoll_notify(FsNode *node);
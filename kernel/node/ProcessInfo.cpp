@@ -23,8 +23,15 @@ static Iteration serialize_task(JsonValue *destination, Task *task)
     json_object_put(task_object, "name", json_create_string(task->name));
     json_object_put(task_object, "state", json_create_string(task_state_string(task->state)));
     json_object_put(task_object, "directory", json_create_string_adopt(path_as_string(task->directory)));
-    json_object_put(task_object, "cpu", json_create_integer(scheduler_get_usage(task->id)));
-    json_object_put(task_object, "ram", json_create_integer(task_memory_usage(task)));
+    json_object_put(task_object, "priority", json_create_integer(task->priority));
+    json_object_put(task_object, "dynamic_priority", json_create_integer(task->dynamic_priority));
+    json_object_put(task_object, "cpu", json_create_integer(scheduler_get_usage(task)));
+    json_object_put(task_object, "user_time", json_create_integer(scheduler_cycles_to_ms(task->user_cycles)));
+    json_object_put(task_object, "kernel_time", json_create_integer(scheduler_cycles_to_ms(task->kernel_cycles)));
+    json_object_put(task_object, "context_switches", json_create_integer(task->context_switches));
+    json_object_put(task_object, "wakeups", json_create_integer(task->wakeups));
+    json_object_put(task_object, "ram", json_create_integer(task_memory_resident_usage(task)));
+    json_object_put(task_object, "virtual", json_create_integer(task_memory_virtual_usage(task)));
     json_object_put(task_object, "user", json_create_boolean(task->user));
 
     json_array_append(destination, task_object);
@@ -27,6 +27,7 @@ static FsNode *socket_FsNodeAcceptConnectionCallback(FsSocket *socket)
     if (connection->accept)
     {
         connection->accept(connection);
+        fsnode_wake(connection);
     }
 
     return connection;
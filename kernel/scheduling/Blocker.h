@@ -7,6 +7,7 @@
 struct Task;
 struct Blocker;
 
+typedef void (*BlockerBlockCallback)(struct Blocker *blocker, struct Task *task);
 typedef bool (*BlockerCanUnblockCallback)(struct Blocker *blocker, struct Task *task);
 typedef void (*BlockerUnblockCallback)(struct Blocker *blocker, struct Task *task);
 typedef void (*BlockerTimeoutCallback)(struct Blocker *blocker, struct Task *task);
@@ -21,7 +22,10 @@ struct Blocker
 {
     BlockerResult result;
     TimeStamp timeout;
+    size_t timer_index;
 
+    // Register the task in the wait queues that can make the blocker unblock.
+    BlockerBlockCallback on_block;
     BlockerCanUnblockCallback can_unblock;
     BlockerUnblockCallback on_unblock;
     BlockerTimeoutCallback on_timeout;
@@ -7,6 +7,11 @@ struct BlockerAccept : public Blocker
     FsNode *node;
 };
 
+static void blocker_accept_on_block(BlockerAccept *blocker, Task *task)
+{
+    wait_queue_wait(&blocker->node->waiters, task);
+}
+
 static bool blocker_accept_can_unblock(BlockerAccept *blocker, Task *task)
 {
     __unused(task);
@@ -23,6 +28,7 @@ Blocker *blocker_accept_create(FsNode *node)
 {
     BlockerAccept *accept_blocker = __create(BlockerAccept);
 
+    TASK_BLOCKER(accept_blocker)->on_block = (BlockerBlockCallback)blocker_accept_on_block;
     TASK_BLOCKER(accept_blocker)->can_unblock = (BlockerCanUnblockCallback)blocker_accept_can_unblock;
     TASK_BLOCKER(accept_blocker)->on_unblock = (BlockerUnblockCallback)blocker_accept_on_unblock;
 
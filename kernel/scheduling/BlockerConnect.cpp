@@ -7,6 +7,11 @@ struct BlockerConnect : public Blocker
     FsNode *connection;
 };
 
+static void blocker_connect_on_block(BlockerConnect *blocker, Task *task)
+{
+    wait_queue_wait(&blocker->connection->waiters, task);
+}
+
 static bool blocker_connect_can_unblock(BlockerConnect *blocker, Task *task)
 {
     __unused(task);
@@ -24,6 +29,7 @@ Blocker *blocker_connect_create(FsNode *connection)
 {
     BlockerConnect *connect_blocker = __create(BlockerConnect);
 
+    TASK_BLOCKER(connect_blocker)->on_block = (BlockerBlockCallback)blocker_connect_on_block;
     TASK_BLOCKER(connect_blocker)->can_unblock = (BlockerCanUnblockCallback)blocker_connect_can_unblock;
     TASK_BLOCKER(connect_blocker)->on_unblock = (BlockerUnblockCallback)blocker_connect_unblock;
 
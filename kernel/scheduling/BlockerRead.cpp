@@ -7,6 +7,11 @@ struct BlockerRead : public Blocker
     FsHandle *handle;
 };
 
+static void blocker_read_on_block(BlockerRead *blocker, Task *task)
+{
+    wait_queue_wait(&blocker->handle->node->waiters, task);
+}
+
 static bool blocker_read_can_unblock(BlockerRead *blocker, Task *task)
 {
     __unused(task);
@@ -23,6 +28,7 @@ Blocker *blocker_read_create(FsHandle *handle)
 {
     BlockerRead *read_blocker = __create(BlockerRead);
 
+    TASK_BLOCKER(read_blocker)->on_block = (BlockerBlockCallback)blocker_read_on_block;
     TASK_BLOCKER(read_blocker)->can_unblock = (BlockerCanUnblockCallback)blocker_read_can_unblock;
     TASK_BLOCKER(read_blocker)->on_unblock = (BlockerUnblockCallback)blocker_read_unblock;
 
@@ -12,6 +12,14 @@ struct BlockerSelect : public Blocker
     SelectEvent *selected_events;
 };
 
+static void blocker_select_on_block(BlockerSelect *blocker, Task *task)
+{
+    for (size_t i = 0; i < blocker->count; i++)
+    {
+        wait_queue_wait(&blocker->handles[i]->node->waiters, task);
+    }
+}
+
 static bool blocker_select_can_unblock(BlockerSelect *blocker, Task *task)
 {
     __unused(task);
@@ -50,6 +58,7 @@ Blocker *blocker_select_create(FsHandle **handles, SelectEvent *events, size_t c
 {
     BlockerSelect *select_blocker = __create(BlockerSelect);
 
+    TASK_BLOCKER(select_blocker)->on_block = (BlockerBlockCallback)blocker_select_on_block;
     TASK_BLOCKER(select_blocker)->can_unblock = (BlockerCanUnblockCallback)blocker_select_can_unblock;
     TASK_BLOCKER(select_blocker)->on_unblock = (BlockerUnblockCallback)blocker_select_unblock;
 
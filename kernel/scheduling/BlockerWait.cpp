@@ -7,6 +7,11 @@ struct BlockerWait : public Blocker
     int *exit_value;
 };
 
+static void blocker_wait_on_block(BlockerWait *blocker, Task *task)
+{
+    wait_queue_wait(&blocker->task->exit_waiters, task);
+}
+
 static bool blocker_wait_can_unblock(BlockerWait *blocker, Task *task)
 {
     __unused(task);
@@ -24,6 +29,7 @@ Blocker *blocker_wait_create(Task *task, int *exit_value)
 {
     BlockerWait *wait_blocker = __create(BlockerWait);
 
+    TASK_BLOCKER(wait_blocker)->on_block = (BlockerBlockCallback)blocker_wait_on_block;
     TASK_BLOCKER(wait_blocker)->can_unblock = (BlockerCanUnblockCallback)blocker_wait_can_unblock;
     TASK_BLOCKER(wait_blocker)->on_unblock = (BlockerUnblockCallback)blocker_wait_unblock;
 
@@ -7,6 +7,11 @@ struct BlockerWrite : public Blocker
     FsHandle *handle;
 };
 
+void blocker_write_on_block(BlockerWrite *blocker, Task *task)
+{
+    wait_queue_wait(&blocker->handle->node->waiters, task);
+}
+
 bool blocker_write_can_unblock(BlockerWrite *blocker, Task *task)
 {
     __unused(task);
@@ -23,6 +28,7 @@ Blocker *blocker_write_create(FsHandle *handle)
 {
     BlockerWrite *write_blocker = __create(BlockerWrite);
 
+    TASK_BLOCKER(write_blocker)->on_block = (BlockerBlockCallback)blocker_write_on_block;
     TASK_BLOCKER(write_blocker)->can_unblock = (BlockerCanUnblockCallback)blocker_write_can_unblock;
     TASK_BLOCKER(write_blocker)->on_unblock = (BlockerUnblockCallback)blocker_write_unblock;
 
@@ -1,3 +1,5 @@
+#include <libsystem/Assert.h>
+#include <libsystem/math/MinMax.h>
 #include <libsystem/thread/Atomic.h>
 
 #include "arch/Arch.h"
@@ -6,18 +8,379 @@
 #include "kernel/system/System.h"
 
 static bool scheduler_context_switch = false;
-static int scheduler_record[SCHEDULER_RECORD_COUNT] = {};
 
 static Task *running = nullptr;
 static Task *idle = nullptr;
 
-static List *blocked_tasks;
-static List *running_tasks;
+static bool scheduler_yielding = false;
+
+// One queue of running tasks per priority level, the bitmap tells which
+// levels have tasks in them so the next task is found in constant time.
+static Task *_run_queues_head[PROCESS_PRIORITY_COUNT] = {};
+static Task *_run_queues_tail[PROCESS_PRIORITY_COUNT] = {};
+static uint32_t _run_queues_bitmap = 0;
+
+// Blocked tasks that have been woken up by a wait queue, their blocker
+// is checked on the next schedule.
+static Task *_pending_wakeups = nullptr;
+
+// Min-heap of the blocked tasks with a timeout, ordered by deadline.
+static Task **_timers = nullptr;
+static size_t _timers_count = 0;
+static size_t _timers_allocated = 0;
+
+// Start of the current slice of cpu time and of the current usage period.
+static uint64_t _accounting_checkpoint = 0;
+static uint32_t _usage_period = 0;
+static uint64_t _usage_period_start = 0;
+static uint64_t _usage_last_period_cycles = 0;
+
+static uint64_t _boot_cycles = 0;
+static uint32_t _boot_tick = 0;
 
 void scheduler_initialize()
 {
-    blocked_tasks = list_create();
-    running_tasks = list_create();
+    _boot_cycles = arch_get_cycles();
+    _boot_tick = system_get_tick();
+
+    _accounting_checkpoint = _boot_cycles;
+    _usage_period_start = _boot_cycles;
+}
+
+/* --- Accounting ----------------------------------------------------------- */
+
+// Charge the cycles elapsed since the last checkpoint to the running task.
+static void scheduler_account()
+{
+    uint64_t now = arch_get_cycles();
+    uint64_t elapsed = now - _accounting_checkpoint;
+    _accounting_checkpoint = now;
+
+    uint32_t period = system_get_tick() / SCHEDULER_USAGE_PERIOD;
+
+    if (period != _usage_period)
+    {
+        _usage_last_period_cycles = now - _usage_period_start;
+        _usage_period_start = now;
+        _usage_period = period;
+    }
+
+    if (running->user && !running->in_syscall)
+    {
+        running->user_cycles += elapsed;
+    }
+    else
+    {
+        running->kernel_cycles += elapsed;
+    }
+
+    if (running->usage_period != period)
+    {
+        if (running->usage_period + 1 == period)
+        {
+            running->usage_last_period_cycles = running->usage_period_cycles;
+        }
+        else
+        {
+            running->usage_last_period_cycles = 0;
+        }
+
+        running->usage_period_cycles = 0;
+        running->usage_period = period;
+    }
+
+    running->usage_period_cycles += elapsed;
+}
+
+void scheduler_did_enter_syscall()
+{
+    atomic_begin();
+    scheduler_account();
+    running->in_syscall = true;
+    atomic_end();
+}
+
+void scheduler_did_leave_syscall()
+{
+    atomic_begin();
+    scheduler_account();
+    running->in_syscall = false;
+    atomic_end();
+}
+
+int scheduler_get_usage(Task *task)
+{
+    atomic_begin();
+
+    uint32_t period = system_get_tick() / SCHEDULER_USAGE_PERIOD;
+
+    uint64_t task_cycles = 0;
+
+    // Usage is reported for the last complete period.
+    if (task->usage_period == period)
+    {
+        task_cycles = task->usage_last_period_cycles;
+    }
+    else if (task->usage_period + 1 == period)
+    {
+        task_cycles = task->usage_period_cycles;
+    }
+
+    uint64_t period_cycles = _usage_last_period_cycles;
+
+    atomic_end();
+
+    if (period_cycles == 0)
+    {
+        return 0;
+    }
+
+    return MIN(100, (int)(task_cycles * 100 / period_cycles));
+}
+
+static uint64_t scheduler_cycles_per_tick()
+{
+    uint32_t elapsed_ticks = system_get_tick() - _boot_tick;
+
+    if (elapsed_ticks == 0)
+    {
+        return 0;
+    }
+
+    return (arch_get_cycles() - _boot_cycles) / elapsed_ticks;
+}
+
+uint32_t scheduler_cycles_to_ms(uint64_t cycles)
+{
+    // The PIT is running at 1000Hz, so one tick is one millisecond.
+    uint64_t cycles_per_tick = scheduler_cycles_per_tick();
+
+    if (cycles_per_tick == 0)
+    {
+        return 0;
+    }
+
+    return cycles / cycles_per_tick;
+}
+
+uint32_t scheduler_cycles_to_us(uint64_t cycles)
+{
+    uint64_t cycles_per_tick = scheduler_cycles_per_tick();
+
+    if (cycles_per_tick == 0)
+    {
+        return 0;
+    }
+
+    return cycles * 1000 / cycles_per_tick;
+}
+
+/* --- Run queues ----------------------------------------------------------- */
+
+static void run_queue_push(Task *task)
+{
+    int level = task->dynamic_priority;
+
+    task->run_next = nullptr;
+    task->run_prev = _run_queues_tail[level];
+
+    if (_run_queues_tail[level])
+    {
+        _run_queues_tail[level]->run_next = task;
+    }
+    else
+    {
+        _run_queues_head[level] = task;
+    }
+
+    _run_queues_tail[level] = task;
+    _run_queues_bitmap |= 1 << level;
+}
+
+static void run_queue_remove(Task *task)
+{
+    int level = task->dynamic_priority;
+
+    if (task->run_prev)
+    {
+        task->run_prev->run_next = task->run_next;
+    }
+    else
+    {
+        _run_queues_head[level] = task->run_next;
+    }
+
+    if (task->run_next)
+    {
+        task->run_next->run_prev = task->run_prev;
+    }
+    else
+    {
+        _run_queues_tail[level] = task->run_prev;
+    }
+
+    task->run_next = nullptr;
+    task->run_prev = nullptr;
+
+    if (_run_queues_head[level] == nullptr)
+    {
+        _run_queues_bitmap &= ~(1 << level);
+    }
+}
+
+static Task *run_queue_peek()
+{
+    if (_run_queues_bitmap == 0)
+    {
+        return nullptr;
+    }
+
+    return _run_queues_head[__builtin_ctz(_run_queues_bitmap)];
+}
+
+static void run_queue_set_dynamic_priority(Task *task, int priority)
+{
+    if (task->state == TASK_STATE_RUNNING)
+    {
+        run_queue_remove(task);
+        task->dynamic_priority = priority;
+        run_queue_push(task);
+    }
+    else
+    {
+        task->dynamic_priority = priority;
+    }
+}
+
+// Give back their priority to the tasks that used up their time slices,
+// so they don't starve behind interactive ones.
+static void run_queue_age()
+{
+    for (int level = PROCESS_PRIORITY_HIGHEST; level <= PROCESS_PRIORITY_LOWEST; level++)
+    {
+        Task *task = _run_queues_head[level];
+
+        while (task)
+        {
+            Task *next = task->run_next;
+
+            if (task->dynamic_priority > task->priority)
+            {
+                run_queue_set_dynamic_priority(task, task->priority);
+            }
+
+            task = next;
+        }
+    }
+}
+
+/* --- Timers --------------------------------------------------------------- */
+
+static TimeStamp timer_deadline(size_t index)
+{
+    return _timers[index]->blocker->timeout;
+}
+
+static void timer_swap(size_t left, size_t right)
+{
+    __swap(Task *, _timers[left], _timers[right]);
+
+    _timers[left]->blocker->timer_index = left;
+    _timers[right]->blocker->timer_index = right;
+}
+
+static void timer_sift_up(size_t index)
+{
+    while (index > 0 && timer_deadline((index - 1) / 2) > timer_deadline(index))
+    {
+        timer_swap(index, (index - 1) / 2);
+        index = (index - 1) / 2;
+    }
+}
+
+static void timer_sift_down(size_t index)
+{
+    while (true)
+    {
+        size_t smallest = index;
+        size_t left = index * 2 + 1;
+        size_t right = index * 2 + 2;
+
+        if (left < _timers_count && timer_deadline(left) < timer_deadline(smallest))
+        {
+            smallest = left;
+        }
+
+        if (right < _timers_count && timer_deadline(right) < timer_deadline(smallest))
+        {
+            smallest = right;
+        }
+
+        if (smallest == index)
+        {
+            return;
+        }
+
+        timer_swap(index, smallest);
+        index = smallest;
+    }
+}
+
+static void timer_insert(Task *task)
+{
+    if (_timers_count == _timers_allocated)
+    {
+        _timers_allocated = MAX(16, _timers_allocated * 2);
+        _timers = (Task **)realloc(_timers, sizeof(Task *) * _timers_allocated);
+    }
+
+    _timers[_timers_count] = task;
+    task->blocker->timer_index = _timers_count;
+    _timers_count++;
+
+    timer_sift_up(_timers_count - 1);
+}
+
+static void timer_remove(Task *task)
+{
+    size_t index = task->blocker->timer_index;
+
+    _timers_count--;
+
+    if (index != _timers_count)
+    {
+        timer_swap(index, _timers_count);
+        timer_sift_down(index);
+        timer_sift_up(index);
+    }
+}
+
+/* --- Wakeups -------------------------------------------------------------- */
+
+static void wakeup_remove_pending(Task *task)
+{
+    Task **current = &_pending_wakeups;
+
+    while (*current != task)
+    {
+        current = &(*current)->next_wakeup;
+    }
+
+    *current = task->next_wakeup;
+    task->next_wakeup = nullptr;
+    task->wakeup_pending = false;
+}
+
+void scheduler_wakeup(Task *task)
+{
+    ASSERT_ATOMIC;
+
+    if (task->state == TASK_STATE_BLOCKED && !task->wakeup_pending)
+    {
+        task->wakeup_pending = true;
+        task->next_wakeup = _pending_wakeups;
+        _pending_wakeups = task;
+    }
 }
 
 void scheduler_did_create_idle_task(Task *task)
@@ -36,26 +399,59 @@ void scheduler_did_change_task_state(Task *task, TaskState oldstate, TaskState n
     {
         if (oldstate == TASK_STATE_RUNNING)
         {
-            list_remove(running_tasks, task);
+            run_queue_remove(task);
         }
 
         if (oldstate == TASK_STATE_BLOCKED)
         {
-            list_remove(blocked_tasks, task);
+            wait_queue_leave_all(task);
+
+            if (task->wakeup_pending)
+            {
+                wakeup_remove_pending(task);
+            }
+
+            if (task->blocker->timeout != (Timeout)-1)
+            {
+                timer_remove(task);
+            }
         }
 
         if (newstate == TASK_STATE_BLOCKED)
         {
-            list_push(blocked_tasks, task);
+            if (task->blocker->timeout != (Timeout)-1)
+            {
+                timer_insert(task);
+            }
         }
 
         if (newstate == TASK_STATE_RUNNING)
         {
-            list_push(running_tasks, task);
+            if (oldstate == TASK_STATE_BLOCKED)
+            {
+                task->wakeups++;
+                task->dynamic_priority = MAX(PROCESS_PRIORITY_HIGHEST, task->priority - SCHEDULER_WAKEUP_BOOST);
+            }
+            else
+            {
+                task->dynamic_priority = task->priority;
+            }
+
+            task->time_slice = SCHEDULER_TIME_SLICE;
+
+            run_queue_push(task);
         }
     }
 }
 
+void scheduler_did_change_task_priority(Task *task, int priority)
+{
+    ASSERT_ATOMIC;
+
+    task->priority = priority;
+    run_queue_set_dynamic_priority(task, priority);
+}
+
 bool scheduler_is_context_switch()
 {
     return scheduler_context_switch;
@@ -78,30 +474,15 @@ int scheduler_running_id()
 
 void scheduler_yield()
 {
-    arch_yield();
-}
-
-int scheduler_get_usage(int task_id)
-{
-    int count = 0;
-
     atomic_begin();
-    for (int i = 0; i < SCHEDULER_RECORD_COUNT; i++)
-    {
-        if (scheduler_record[i] == task_id)
-        {
-            count++;
-        }
-    }
+    scheduler_yielding = true;
     atomic_end();
 
-    return (count * 100) / SCHEDULER_RECORD_COUNT;
+    arch_yield();
 }
 
-static Iteration wakeup_task_if_unblocked(void *target, Task *task)
+static void wakeup_task_if_unblocked(Task *task)
 {
-    __unused(target);
-
     Blocker *blocker = task->blocker;
 
     if (blocker->can_unblock(blocker, task))
@@ -127,8 +508,25 @@ static Iteration wakeup_task_if_unblocked(void *target, Task *task)
 
         task_set_state(task, TASK_STATE_RUNNING);
     }
+}
+
+static void wakeup_tasks()
+{
+    while (_timers_count > 0 && timer_deadline(0) <= system_get_tick())
+    {
+        wakeup_task_if_unblocked(_timers[0]);
+    }
+
+    while (_pending_wakeups)
+    {
+        Task *task = _pending_wakeups;
+
+        _pending_wakeups = task->next_wakeup;
+        task->next_wakeup = nullptr;
+        task->wakeup_pending = false;
 
-    return Iteration::CONTINUE;
+        wakeup_task_if_unblocked(task);
+    }
 }
 
 uintptr_t schedule(uintptr_t current_stack_pointer)
@@ -138,17 +536,58 @@ uintptr_t schedule(uintptr_t current_stack_pointer)
     running->stack_pointer = current_stack_pointer;
     arch_save_context(running);
 
-    scheduler_record[system_get_tick() % SCHEDULER_RECORD_COUNT] = running->id;
+    scheduler_account();
+
+    Task *previous = running;
+
+    wakeup_tasks();
+
+    if (!scheduler_yielding && system_get_tick() % SCHEDULER_AGING_PERIOD == 0)
+    {
+        run_queue_age();
+    }
+
+    if (running->state == TASK_STATE_RUNNING)
+    {
+        if (!scheduler_yielding)
+        {
+            running->time_slice--;
+        }
+
+        if (scheduler_yielding || running->time_slice <= 0)
+        {
+            // The task used its whole time slice, so it is probably not an interactive one.
+            int priority = running->dynamic_priority;
+
+            if (!scheduler_yielding)
+            {
+                priority = MIN(PROCESS_PRIORITY_LOWEST, priority + 1);
+            }
+
+            run_queue_remove(running);
+            running->dynamic_priority = priority;
+            running->time_slice = SCHEDULER_TIME_SLICE;
+            run_queue_push(running);
+        }
+    }
+
+    scheduler_yielding = false;
 
-    list_iterate(blocked_tasks, nullptr, (ListIterationCallback)wakeup_task_if_unblocked);
+    // Get the next task, the current one is still at the head of its queue
+    // unless it was preempted by a task with a higher priority.
+    running = run_queue_peek();
 
-    // Get the next task
-    if (!list_peek_and_pushback(running_tasks, (void **)&running))
+    if (running == nullptr)
     {
         // Or the idle task if there are no running tasks.
         running = idle;
     }
 
+    if (running != previous)
+    {
+        running->context_switches++;
+    }
+
     memory_pdir_switch(running->pdir);
     arch_load_context(running);
 
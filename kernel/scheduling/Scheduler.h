@@ -2,7 +2,13 @@
 
 #include "kernel/tasking/Task.h"
 
-#define SCHEDULER_RECORD_COUNT 1000
+// In ticks
+#define SCHEDULER_USAGE_PERIOD 1000
+#define SCHEDULER_TIME_SLICE 10
+#define SCHEDULER_AGING_PERIOD 1000
+
+// How many levels a task waking up from I/O is boosted.
+#define SCHEDULER_WAKEUP_BOOST 1
 
 void scheduler_initialize();
 
@@ -12,9 +18,21 @@ void scheduler_did_create_running_task(Task *task);
 
 void scheduler_did_change_task_state(Task *task, TaskState oldstate, TaskState newstate);
 
+void scheduler_did_change_task_priority(Task *task, int priority);
+
+void scheduler_wakeup(Task *task);
+
 bool scheduler_is_context_switch();
 
-int scheduler_get_usage(int task_id);
+void scheduler_did_enter_syscall();
+
+void scheduler_did_leave_syscall();
+
+int scheduler_get_usage(Task *task);
+
+uint32_t scheduler_cycles_to_ms(uint64_t cycles);
+
+uint32_t scheduler_cycles_to_us(uint64_t cycles);
 
 Task *scheduler_running();
 
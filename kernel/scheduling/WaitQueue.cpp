@@ -0,0 +1,55 @@
+#include <libsystem/Assert.h>
+#include <libsystem/thread/Atomic.h>
+
+#include "kernel/scheduling/Scheduler.h"
+#include "kernel/scheduling/WaitQueue.h"
+
+void wait_queue_wait(WaitQueue *queue, Task *task)
+{
+    ASSERT_ATOMIC;
+
+    if (queue->waiters == nullptr)
+    {
+        queue->waiters = list_create();
+    }
+
+    list_pushback(queue->waiters, task);
+    list_pushback(task->wait_queues, queue);
+}
+
+void wait_queue_wake(WaitQueue *queue)
+{
+    atomic_begin();
+
+    if (queue->waiters)
+    {
+        list_foreach(Task, task, queue->waiters)
+        {
+            scheduler_wakeup(task);
+        }
+    }
+
+    atomic_end();
+}
+
+void wait_queue_leave_all(Task *task)
+{
+    ASSERT_ATOMIC;
+
+    list_foreach(WaitQueue, queue, task->wait_queues)
+    {
+        list_remove(queue->waiters, task);
+    }
+
+    list_clear(task->wait_queues);
+}
+
+void wait_queue_destroy(WaitQueue *queue)
+{
+    if (queue->waiters)
+    {
+        assert(queue->waiters->empty());
+        list_destroy(queue->waiters);
+        queue->waiters = nullptr;
+    }
+}
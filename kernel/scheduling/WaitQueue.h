@@ -0,0 +1,22 @@
+#pragma once
+
+#include <libsystem/utils/List.h>
+
+struct Task;
+
+// A list of blocked tasks waiting for something to happen.
+// Waking up a wait queue only ask the scheduler to check the blocker
+// of the waiting tasks, the tasks are removed from every wait queue they
+// are in as soon as they leave the blocked state.
+struct WaitQueue
+{
+    List *waiters;
+};
+
+void wait_queue_wait(WaitQueue *queue, struct Task *task);
+
+void wait_queue_wake(WaitQueue *queue);
+
+void wait_queue_leave_all(struct Task *task);
+
+void wait_queue_destroy(WaitQueue *queue);
@@ -0,0 +1,235 @@
+#include <libsystem/Logger.h>
+#include <libsystem/thread/Lock.h>
+#include <libsystem/utils/List.h>
+
+#include "kernel/filesystem/Filesystem.h"
+#include "kernel/node/Handle.h"
+#include "kernel/tasking/Executable.h"
+#include "kernel/tasking/Task-Directory.h"
+
+// Most recently launched executables first.
+static List *_executables = nullptr;
+static Lock _executables_lock;
+
+void executable_cache_initialize()
+{
+    lock_init(_executables_lock);
+    _executables = list_create();
+}
+
+static Executable *executable_ref(Executable *executable)
+{
+    __atomic_add_fetch(&executable->refcount, 1, __ATOMIC_SEQ_CST);
+
+    return executable;
+}
+
+void executable_deref(Executable *executable)
+{
+    if (__atomic_sub_fetch(&executable->refcount, 1, __ATOMIC_SEQ_CST) == 0)
+    {
+        for (size_t i = 0; i < executable->segments_count; i++)
+        {
+            if (executable->segments[i].object)
+            {
+                memory_object_deref(executable->segments[i].object);
+            }
+        }
+
+        free(executable->segments);
+        fsnode_deref(executable->node);
+        free(executable);
+    }
+}
+
+static Result executable_read(FsHandle *elf_file, void *buffer, size_t size, size_t offset)
+{
+    size_t read = 0;
+    Result result = fshandle_pread(elf_file, buffer, size, offset, &read);
+
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    if (read != size)
+    {
+        return ERR_EXEC_FORMAT_ERROR;
+    }
+
+    return SUCCESS;
+}
+
+static Result executable_load_segment(FsHandle *elf_file, ExecutableSegment *segment)
+{
+    ELFProgram *program_header = &segment->header;
+
+    if (program_header->vaddr <= 0x100000)
+    {
+        logger_error("ELF program no in user memory (0x%08x)!", program_header->vaddr);
+        return ERR_EXEC_FORMAT_ERROR;
+    }
+
+    MemoryRange range = memory_range_around_non_aligned_address(program_header->vaddr, program_header->memsz);
+
+    segment->object = memory_object_create(range.size);
+
+    uint8_t *segment_data = (uint8_t *)memory_object_kernel_map(segment->object);
+
+    Result result = executable_read(elf_file, segment_data + (program_header->vaddr - range.base), program_header->filesz, program_header->offset);
+
+    memory_object_kernel_unmap(segment->object, segment_data);
+
+    if (result != SUCCESS)
+    {
+        logger_error("Didn't read the right amount from the ELF file!");
+    }
+
+    return result;
+}
+
+// Read from the node that was resolved (and looked up in the cache) by
+// executable_load(), the path could point to another file by now.
+static Result executable_load_from_node(Executable *executable, const char *path)
+{
+    FsHandle *elf_file = fshandle_create(executable->node, OPEN_READ);
+
+    Result result = executable_read(elf_file, &executable->header, sizeof(ELFHeader), 0);
+
+    if (result != SUCCESS || !elf_valid(&executable->header))
+    {
+        logger_error("Failled to load ELF file %s: bad exec format!", path);
+        fshandle_destroy(elf_file);
+        return ERR_EXEC_FORMAT_ERROR;
+    }
+
+    executable->segments = (ExecutableSegment *)calloc(executable->header.phnum, sizeof(ExecutableSegment));
+    executable->segments_count = executable->header.phnum;
+
+    for (size_t i = 0; i < executable->segments_count; i++)
+    {
+        ExecutableSegment *segment = &executable->segments[i];
+
+        result = executable_read(elf_file, &segment->header, sizeof(ELFProgram), executable->header.phoff + executable->header.phentsize * i);
+
+        if (result == SUCCESS)
+        {
+            result = executable_load_segment(elf_file, segment);
+        }
+
+        if (result != SUCCESS)
+        {
+            break;
+        }
+    }
+
+    fshandle_destroy(elf_file);
+
+    return result;
+}
+
+// A cached executable is stale if its file was opened for writing since it was loaded.
+static bool executable_is_up_to_date(Executable *executable)
+{
+    return executable->node->writers == 0 &&
+           executable->node->generation == executable->generation;
+}
+
+static Executable *executable_cache_lookup(FsNode *node)
+{
+    Executable *found = nullptr;
+
+    lock_acquire(_executables_lock);
+
+    list_foreach(Executable, executable, _executables)
+    {
+        if (executable->node == node)
+        {
+            found = executable;
+        }
+    }
+
+    if (found)
+    {
+        list_remove(_executables, found);
+
+        if (executable_is_up_to_date(found))
+        {
+            list_push(_executables, executable_ref(found));
+        }
+        else
+        {
+            executable_deref(found);
+            found = nullptr;
+        }
+    }
+
+    lock_release(_executables_lock);
+
+    return found;
+}
+
+static void executable_cache_insert(Executable *executable)
+{
+    lock_acquire(_executables_lock);
+
+    list_push(_executables, executable_ref(executable));
+
+    if (_executables->count() > EXECUTABLE_CACHE_SIZE)
+    {
+        Executable *least_recently_used = nullptr;
+        list_popback(_executables, (void **)&least_recently_used);
+        executable_deref(least_recently_used);
+    }
+
+    lock_release(_executables_lock);
+}
+
+Result executable_load(Task *task, const char *path, Executable **out_executable, bool *out_cached)
+{
+    *out_executable = nullptr;
+    *out_cached = false;
+
+    Path *resolved_path = task_resolve_directory(task, path);
+    FsNode *node = filesystem_find_and_ref(resolved_path);
+    path_destroy(resolved_path);
+
+    if (node == nullptr)
+    {
+        return ERR_NO_SUCH_FILE_OR_DIRECTORY;
+    }
+
+    Executable *executable = executable_cache_lookup(node);
+
+    if (executable)
+    {
+        fsnode_deref(node);
+
+        *out_executable = executable;
+        *out_cached = true;
+
+        return SUCCESS;
+    }
+
+    executable = __create(Executable);
+    executable->refcount = 1;
+    executable->node = node;
+    executable->generation = node->generation;
+
+    Result result = executable_load_from_node(executable, path);
+
+    if (result != SUCCESS)
+    {
+        executable_deref(executable);
+        return result;
+    }
+
+    if (executable_is_up_to_date(executable))
+    {
+        executable_cache_insert(executable);
+    }
+
+    *out_executable = executable;
+
+    return SUCCESS;
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <libfile/elf.h>
+
+#include "kernel/memory/MemoryObject.h"
+#include "kernel/node/Node.h"
+#include "kernel/tasking/Task.h"
+
+// Number of executables kept in memory after their last launch.
+#define EXECUTABLE_CACHE_SIZE 16
+
+struct ExecutableSegment
+{
+    ELFProgram header;
+    MemoryObject *object;
+};
+
+struct Executable
+{
+    int refcount;
+
+    FsNode *node;
+    uint generation;
+
+    ELFHeader header;
+
+    ExecutableSegment *segments;
+    size_t segments_count;
+};
+
+void executable_cache_initialize();
+
+Result executable_load(Task *task, const char *path, Executable **out_executable, bool *out_cached);
+
+void executable_deref(Executable *executable);
@@ -6,6 +6,7 @@
 #include <libsystem/Logger.h>
 #include <libsystem/Result.h>
 #include <libsystem/core/CString.h>
+#include <libsystem/math/MinMax.h>
 #include <libsystem/thread/Atomic.h>
 
 #include "arch/Arch.h"
@@ -89,6 +90,34 @@ Result sys_process_set_directory(const char *path)
     return task_set_directory(scheduler_running(), path);
 }
 
+Result sys_process_set_priority(int pid, int priority)
+{
+    Result result = SUCCESS;
+
+    ATOMIC({
+        Task *task = task_by_id(pid);
+
+        Task *running = scheduler_running();
+
+        if (task == nullptr)
+        {
+            result = ERR_NO_SUCH_TASK;
+        }
+        else if (!task->user || (task != running && task->parent_id != running->id))
+        {
+            // Kernel tasks, the idle task included, are out of reach, and
+            // a process only gets to change itself or the processes it spawned.
+            result = ERR_PERMISSION_DENIED;
+        }
+        else
+        {
+            result = task_set_priority(task, priority);
+        }
+    });
+
+    return result;
+}
+
 Result sys_process_sleep(int time)
 {
     return task_sleep(scheduler_running(), time);
@@ -233,9 +262,26 @@ Result sys_system_get_status(SystemStatus *status)
 
     status->total_ram = memory_get_total();
     status->used_ram = memory_get_used();
+    status->largest_free_ram = memory_get_largest_free();
+    status->free_ram_blocks = memory_get_free_blocks();
 
     status->running_tasks = task_count();
-    status->cpu_usage = 100 - scheduler_get_usage(0);
+
+    int idle_usage = 0;
+
+    ATOMIC({
+        idle_usage = scheduler_get_usage(task_by_id(0));
+    });
+
+    status->cpu_usage = 100 - idle_usage;
+
+    LaunchStatistics launch = task_launch_statistics();
+    size_t cold_launches = launch.count - launch.cache_hits;
+
+    status->launch_count = launch.count;
+    status->launch_cache_hits = launch.cache_hits;
+    status->launch_cold_average_time = cold_launches ? scheduler_cycles_to_us(launch.cold_cycles / cold_launches) : 0;
+    status->launch_cached_average_time = launch.cache_hits ? scheduler_cycles_to_us(launch.cached_cycles / launch.cache_hits) : 0;
 
     return SUCCESS;
 }
@@ -292,6 +338,16 @@ Result sys_create_term(int *master_handle, int *slave_handle)
     return task_create_term(scheduler_running(), master_handle, slave_handle);
 }
 
+Result sys_create_poll(int *poll_handle)
+{
+    if (!syscall_validate_ptr((uintptr_t)poll_handle, sizeof(int)))
+    {
+        return ERR_BAD_ADDRESS;
+    }
+
+    return task_create_poll(scheduler_running(), poll_handle);
+}
+
 /* --- Handles -------------------------------------------------------------- */
 
 Result sys_handle_open(int *handle, const char *path, OpenFlag flags)
@@ -356,6 +412,24 @@ Result sys_handle_select(
     return result;
 }
 
+Result sys_handle_poll_control(int poll_handle, HandlePollOperation operation, int handle, SelectEvent events)
+{
+    return task_fshandle_poll_control(scheduler_running(), poll_handle, operation, handle, events);
+}
+
+Result sys_handle_poll_wait(int poll_handle, HandlePollEvent *events, size_t count, size_t *ready, Timeout timeout)
+{
+    count = MIN(count, PROCESS_HANDLE_COUNT);
+
+    if (!syscall_validate_ptr((uintptr_t)events, sizeof(HandlePollEvent) * count) ||
+        !syscall_validate_ptr((uintptr_t)ready, sizeof(size_t)))
+    {
+        return ERR_BAD_ADDRESS;
+    }
+
+    return task_fshandle_poll_wait(scheduler_running(), poll_handle, events, count, ready, timeout);
+}
+
 Result sys_handle_read(int handle, char *buffer, size_t size, size_t *read)
 {
     if (!syscall_validate_ptr((uintptr_t)buffer, size) ||
@@ -378,6 +452,100 @@ Result sys_handle_write(int handle, const char *buffer, size_t size, size_t *wri
     return task_fshandle_write(scheduler_running(), handle, buffer, size, written);
 }
 
+// Copy the vectors out of userspace so they can't change under our feet.
+static Result syscall_copy_vectors(const IOVector *vectors, size_t count, IOVector *copy)
+{
+    if (count > HANDLE_IO_VECTOR_MAX)
+    {
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    if (!syscall_validate_ptr((uintptr_t)vectors, sizeof(IOVector) * count))
+    {
+        return ERR_BAD_ADDRESS;
+    }
+
+    memcpy(copy, vectors, sizeof(IOVector) * count);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        if (!syscall_validate_ptr((uintptr_t)copy[i].buffer, copy[i].size))
+        {
+            return ERR_BAD_ADDRESS;
+        }
+    }
+
+    return SUCCESS;
+}
+
+Result sys_handle_readv(int handle, const IOVector *vectors, size_t count, size_t *read)
+{
+    if (!syscall_validate_ptr((uintptr_t)read, sizeof(size_t)))
+    {
+        return ERR_BAD_ADDRESS;
+    }
+
+    IOVector copy[HANDLE_IO_VECTOR_MAX];
+    Result result = syscall_copy_vectors(vectors, count, copy);
+
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    return task_fshandle_readv(scheduler_running(), handle, copy, count, read);
+}
+
+Result sys_handle_writev(int handle, const IOVector *vectors, size_t count, size_t *written)
+{
+    if (!syscall_validate_ptr((uintptr_t)written, sizeof(size_t)))
+    {
+        return ERR_BAD_ADDRESS;
+    }
+
+    IOVector copy[HANDLE_IO_VECTOR_MAX];
+    Result result = syscall_copy_vectors(vectors, count, copy);
+
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    return task_fshandle_writev(scheduler_running(), handle, copy, count, written);
+}
+
+Result sys_handle_pread(int handle, char *buffer, size_t size, size_t offset, size_t *read)
+{
+    if (!syscall_validate_ptr((uintptr_t)buffer, size) ||
+        !syscall_validate_ptr((uintptr_t)read, sizeof(size_t)))
+    {
+        return ERR_BAD_ADDRESS;
+    }
+
+    return task_fshandle_pread(scheduler_running(), handle, buffer, size, offset, read);
+}
+
+Result sys_handle_pwrite(int handle, const char *buffer, size_t size, size_t offset, size_t *written)
+{
+    if (!syscall_validate_ptr((uintptr_t)buffer, size) ||
+        !syscall_validate_ptr((uintptr_t)written, sizeof(size_t)))
+    {
+        return ERR_BAD_ADDRESS;
+    }
+
+    return task_fshandle_pwrite(scheduler_running(), handle, buffer, size, offset, written);
+}
+
+Result sys_handle_splice(int source, int destination, size_t size, size_t *spliced)
+{
+    if (!syscall_validate_ptr((uintptr_t)spliced, sizeof(size_t)))
+    {
+        return ERR_BAD_ADDRESS;
+    }
+
+    return task_fshandle_splice(scheduler_running(), source, destination, size, spliced);
+}
+
 Result sys_handle_call(int handle, IOCall request, void *args)
 {
     return task_fshandle_call(scheduler_running(), handle, request, args);
@@ -398,6 +566,17 @@ Result sys_handle_tell(int handle, Whence whence, int *offset)
     return task_fshandle_tell(scheduler_running(), handle, whence, offset);
 }
 
+Result sys_handle_map(int handle, uintptr_t *address, size_t *size)
+{
+    if (!syscall_validate_ptr((uintptr_t)address, sizeof(uintptr_t)) ||
+        !syscall_validate_ptr((uintptr_t)size, sizeof(size_t)))
+    {
+        return ERR_BAD_ADDRESS;
+    }
+
+    return task_fshandle_map(scheduler_running(), handle, address, size);
+}
+
 Result sys_handle_stat(int handle, FileState *state)
 {
     if (!syscall_validate_ptr((uintptr_t)state, sizeof(FileState)))
@@ -430,6 +609,7 @@ static SyscallHandler syscalls[__SYSCALL_COUNT] = {
     [SYS_PROCESS_WAIT] = reinterpret_cast<SyscallHandler>(sys_process_wait),
     [SYS_PROCESS_GET_DIRECTORY] = reinterpret_cast<SyscallHandler>(sys_process_get_directory),
     [SYS_PROCESS_SET_DIRECTORY] = reinterpret_cast<SyscallHandler>(sys_process_set_directory),
+    [SYS_PROCESS_SET_PRIORITY] = reinterpret_cast<SyscallHandler>(sys_process_set_priority),
     [SYS_MEMORY_ALLOC] = reinterpret_cast<SyscallHandler>(sys_memory_alloc),
     [SYS_MEMORY_FREE] = reinterpret_cast<SyscallHandler>(sys_memory_free),
     [SYS_MEMORY_INCLUDE] = reinterpret_cast<SyscallHandler>(sys_memory_include),
@@ -447,16 +627,25 @@ static SyscallHandler syscalls[__SYSCALL_COUNT] = {
     [SYS_HANDLE_OPEN] = reinterpret_cast<SyscallHandler>(sys_handle_open),
     [SYS_HANDLE_CLOSE] = reinterpret_cast<SyscallHandler>(sys_handle_close),
     [SYS_HANDLE_SELECT] = reinterpret_cast<SyscallHandler>(sys_handle_select),
+    [SYS_HANDLE_POLL_CONTROL] = reinterpret_cast<SyscallHandler>(sys_handle_poll_control),
+    [SYS_HANDLE_POLL_WAIT] = reinterpret_cast<SyscallHandler>(sys_handle_poll_wait),
     [SYS_HANDLE_READ] = reinterpret_cast<SyscallHandler>(sys_handle_read),
     [SYS_HANDLE_WRITE] = reinterpret_cast<SyscallHandler>(sys_handle_write),
+    [SYS_HANDLE_READV] = reinterpret_cast<SyscallHandler>(sys_handle_readv),
+    [SYS_HANDLE_WRITEV] = reinterpret_cast<SyscallHandler>(sys_handle_writev),
+    [SYS_HANDLE_PREAD] = reinterpret_cast<SyscallHandler>(sys_handle_pread),
+    [SYS_HANDLE_PWRITE] = reinterpret_cast<SyscallHandler>(sys_handle_pwrite),
+    [SYS_HANDLE_SPLICE] = reinterpret_cast<SyscallHandler>(sys_handle_splice),
     [SYS_HANDLE_CALL] = reinterpret_cast<SyscallHandler>(sys_handle_call),
     [SYS_HANDLE_SEEK] = reinterpret_cast<SyscallHandler>(sys_handle_seek),
     [SYS_HANDLE_TELL] = reinterpret_cast<SyscallHandler>(sys_handle_tell),
     [SYS_HANDLE_STAT] = reinterpret_cast<SyscallHandler>(sys_handle_stat),
+    [SYS_HANDLE_MAP] = reinterpret_cast<SyscallHandler>(sys_handle_map),
     [SYS_HANDLE_CONNECT] = reinterpret_cast<SyscallHandler>(sys_handle_connect),
     [SYS_HANDLE_ACCEPT] = reinterpret_cast<SyscallHandler>(sys_handle_accept),
     [SYS_CREATE_PIPE] = reinterpret_cast<SyscallHandler>(sys_create_pipe),
     [SYS_CREATE_TERM] = reinterpret_cast<SyscallHandler>(sys_create_term),
+    [SYS_CREATE_POLL] = reinterpret_cast<SyscallHandler>(sys_create_poll),
 };
 
 #pragma GCC diagnostic pop
@@ -495,8 +684,12 @@ int task_do_syscall(Syscall syscall, int arg0, int arg1, int arg2, int arg3, int
         return ERR_FUNCTION_NOT_IMPLEMENTED;
     }
 
+    scheduler_did_enter_syscall();
+
     result = handler(arg0, arg1, arg2, arg3, arg4);
 
+    scheduler_did_leave_syscall();
+
     if (result != SUCCESS && result != TIMEOUT)
     {
         logger_trace("%s(%08x, %08x, %08x, %08x, %08x) returned %s", syscall_names[syscall], arg0, arg1, arg2, arg3, arg4, result_to_string((Result)result));
@@ -2,12 +2,16 @@
 #include <libsystem/Logger.h>
 
 #include "kernel/filesystem/Filesystem.h"
+#include "kernel/memory/MemoryObject.h"
 #include "kernel/node/Pipe.h"
+#include "kernel/node/Poll.h"
 #include "kernel/node/Terminal.h"
 #include "kernel/scheduling/Blocker.h"
 #include "kernel/scheduling/Scheduler.h"
+#include "kernel/system/System.h"
 #include "kernel/tasking/Task-Directory.h"
 #include "kernel/tasking/Task-Handles.h"
+#include "kernel/tasking/Task-Memory.h"
 
 Result task_fshandle_add(Task *task, int *handle_index, FsHandle *handle)
 {
@@ -227,6 +231,155 @@ cleanup_and_return:
     return result;
 }
 
+Result task_fshandle_poll_control(Task *task, int poll_index, HandlePollOperation operation, int handle_index, SelectEvent events)
+{
+    if (poll_index == handle_index)
+    {
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    FsHandle *poll_handle = task_fshandle_acquire(task, poll_index);
+
+    if (poll_handle == nullptr)
+    {
+        return ERR_BAD_FILE_DESCRIPTOR;
+    }
+
+    Result result = SUCCESS;
+    FsPoll *poll = (FsPoll *)poll_handle->node;
+
+    if (poll->type != FILE_TYPE_POLL)
+    {
+        result = ERR_INVALID_ARGUMENT;
+        goto cleanup_and_return;
+    }
+
+    if (operation == HANDLE_POLL_ADD)
+    {
+        FsHandle *handle = task_fshandle_acquire(task, handle_index);
+
+        if (handle == nullptr)
+        {
+            result = ERR_BAD_FILE_DESCRIPTOR;
+            goto cleanup_and_return;
+        }
+
+        fsnode_acquire_lock(poll, task->id);
+        result = fspoll_add(poll, handle_index, handle->node, events);
+        fsnode_release_lock(poll, task->id);
+
+        task_fshandle_release(task, handle_index);
+    }
+    else if (operation == HANDLE_POLL_MODIFY)
+    {
+        fsnode_acquire_lock(poll, task->id);
+        result = fspoll_modify(poll, handle_index, events);
+        fsnode_release_lock(poll, task->id);
+    }
+    else if (operation == HANDLE_POLL_REMOVE)
+    {
+        fsnode_acquire_lock(poll, task->id);
+        result = fspoll_remove(poll, handle_index);
+        fsnode_release_lock(poll, task->id);
+    }
+    else
+    {
+        result = ERR_INVALID_ARGUMENT;
+    }
+
+cleanup_and_return:
+    task_fshandle_release(task, poll_index);
+
+    return result;
+}
+
+static Result task_fshandle_poll_select(Task *task, int handle_index, FsNode *node, SelectEvent events, SelectEvent *selected)
+{
+    FsHandle *handle = task_fshandle_acquire(task, handle_index);
+
+    if (handle == nullptr)
+    {
+        return ERR_BAD_FILE_DESCRIPTOR;
+    }
+
+    Result result = SUCCESS;
+
+    if (handle->node == node)
+    {
+        *selected = fshandle_select(handle, events);
+    }
+    else
+    {
+        result = ERR_BAD_FILE_DESCRIPTOR;
+    }
+
+    task_fshandle_release(task, handle_index);
+
+    return result;
+}
+
+Result task_fshandle_poll_wait(Task *task, int poll_index, HandlePollEvent *events, size_t count, size_t *ready, Timeout timeout)
+{
+    *ready = 0;
+
+    FsHandle *poll_handle = task_fshandle_acquire(task, poll_index);
+
+    if (poll_handle == nullptr)
+    {
+        return ERR_BAD_FILE_DESCRIPTOR;
+    }
+
+    Result result = SUCCESS;
+    FsPoll *poll = (FsPoll *)poll_handle->node;
+    TimeStamp deadline = system_get_tick() + timeout;
+
+    if (poll->type != FILE_TYPE_POLL)
+    {
+        result = ERR_INVALID_ARGUMENT;
+        goto cleanup_and_return;
+    }
+
+    while (true)
+    {
+        // Unblocks with the poll lock held once a watch is pending.
+        BlockerResult blocker_result = task_block(task, blocker_read_create(poll_handle), timeout);
+
+        if (blocker_result == BLOCKER_TIMEOUT)
+        {
+            result = TIMEOUT;
+            break;
+        }
+
+        *ready = fspoll_collect(poll, (FsPollSelectCallback)task_fshandle_poll_select, task, events, count);
+
+        fsnode_release_lock(poll, task->id);
+
+        if (*ready > 0 || timeout == 0)
+        {
+            break;
+        }
+
+        // None of the pending watches was actually ready, wait for the next change.
+        if (timeout != (Timeout)-1)
+        {
+            TimeStamp now = system_get_tick();
+
+            if (now >= deadline)
+            {
+                result = TIMEOUT;
+                break;
+            }
+
+            timeout = deadline - now;
+        }
+    }
+
+cleanup_and_return:
+    task_fshandle_release(task, poll_index);
+
+    return result;
+}
+
 Result task_fshandle_write(Task *task, int handle_index, const void *buffer, size_t size, size_t *written)
 {
     FsHandle *handle = task_fshandle_acquire(task, handle_index);
@@ -243,6 +396,74 @@ Result task_fshandle_write(Task *task, int handle_index, const void *buffer, siz
     return result;
 }
 
+Result task_fshandle_readv(Task *task, int handle_index, const IOVector *vectors, size_t count, size_t *read)
+{
+    FsHandle *handle = task_fshandle_acquire(task, handle_index);
+
+    if (handle == nullptr)
+    {
+        *read = 0;
+        return ERR_BAD_FILE_DESCRIPTOR;
+    }
+
+    Result result = fshandle_readv(handle, vectors, count, read);
+
+    task_fshandle_release(task, handle_index);
+
+    return result;
+}
+
+Result task_fshandle_writev(Task *task, int handle_index, const IOVector *vectors, size_t count, size_t *written)
+{
+    FsHandle *handle = task_fshandle_acquire(task, handle_index);
+
+    if (handle == nullptr)
+    {
+        *written = 0;
+        return ERR_BAD_FILE_DESCRIPTOR;
+    }
+
+    Result result = fshandle_writev(handle, vectors, count, written);
+
+    task_fshandle_release(task, handle_index);
+
+    return result;
+}
+
+Result task_fshandle_pread(Task *task, int handle_index, void *buffer, size_t size, size_t offset, size_t *read)
+{
+    FsHandle *handle = task_fshandle_acquire(task, handle_index);
+
+    if (handle == nullptr)
+    {
+        *read = 0;
+        return ERR_BAD_FILE_DESCRIPTOR;
+    }
+
+    Result result = fshandle_pread(handle, buffer, size, offset, read);
+
+    task_fshandle_release(task, handle_index);
+
+    return result;
+}
+
+Result task_fshandle_pwrite(Task *task, int handle_index, const void *buffer, size_t size, size_t offset, size_t *written)
+{
+    FsHandle *handle = task_fshandle_acquire(task, handle_index);
+
+    if (handle == nullptr)
+    {
+        *written = 0;
+        return ERR_BAD_FILE_DESCRIPTOR;
+    }
+
+    Result result = fshandle_pwrite(handle, buffer, size, offset, written);
+
+    task_fshandle_release(task, handle_index);
+
+    return result;
+}
+
 Result task_fshandle_call(Task *task, int handle_index, IOCall request, void *args)
 {
     FsHandle *handle = task_fshandle_acquire(task, handle_index);
@@ -259,6 +480,38 @@ Result task_fshandle_call(Task *task, int handle_index, IOCall request, void *ar
     return result;
 }
 
+Result task_fshandle_splice(Task *task, int source_index, int destination_index, size_t size, size_t *spliced)
+{
+    *spliced = 0;
+
+    if (source_index == destination_index)
+    {
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    FsHandle *source = task_fshandle_acquire(task, source_index);
+
+    if (source == nullptr)
+    {
+        return ERR_BAD_FILE_DESCRIPTOR;
+    }
+
+    FsHandle *destination = task_fshandle_acquire(task, destination_index);
+
+    if (destination == nullptr)
+    {
+        task_fshandle_release(task, source_index);
+        return ERR_BAD_FILE_DESCRIPTOR;
+    }
+
+    Result result = fshandle_splice(source, destination, size, spliced);
+
+    task_fshandle_release(task, destination_index);
+    task_fshandle_release(task, source_index);
+
+    return result;
+}
+
 Result task_fshandle_seek(Task *task, int handle_index, int offset, Whence whence)
 {
     FsHandle *handle = task_fshandle_acquire(task, handle_index);
@@ -307,6 +560,41 @@ Result task_fshandle_stat(Task *task, int handle_index, FileState *stat)
     return result;
 }
 
+Result task_fshandle_map(Task *task, int handle_index, uintptr_t *address, size_t *size)
+{
+    FsHandle *handle = task_fshandle_acquire(task, handle_index);
+
+    if (handle == nullptr)
+    {
+        return ERR_BAD_FILE_DESCRIPTOR;
+    }
+
+    MemoryObject *memory_object = nullptr;
+    size_t content_size = 0;
+    Result result = fshandle_map(handle, &memory_object, &content_size);
+
+    task_fshandle_release(task, handle_index);
+
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    MemoryMapping *memory_mapping = task_memory_mapping_create(task, memory_object);
+
+    memory_object_deref(memory_object);
+
+    if (!memory_mapping)
+    {
+        return ERR_OUT_OF_MEMORY;
+    }
+
+    *address = memory_mapping->address;
+    *size = content_size;
+
+    return SUCCESS;
+}
+
 Result task_fshandle_connect(Task *task, int *connection_handle_index, const char *socket_path)
 {
     Path *resolved_path = task_resolve_directory(task, socket_path);
@@ -457,3 +745,22 @@ cleanup_and_return:
 
     return result;
 }
+
+Result task_create_poll(Task *task, int *poll_handle_index)
+{
+    *poll_handle_index = HANDLE_INVALID_ID;
+
+    FsNode *poll = fspoll_create();
+    FsHandle *poll_handle = fshandle_create(poll, OPEN_READ);
+
+    Result result = task_fshandle_add(task, poll_handle_index, poll_handle);
+
+    if (result != SUCCESS)
+    {
+        fshandle_destroy(poll_handle);
+    }
+
+    fsnode_deref(poll);
+
+    return result;
+}
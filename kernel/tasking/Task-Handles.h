@@ -15,10 +15,24 @@ Result task_fshandle_select(
     SelectEvent *selected_events,
     Timeout timeout);
 
+Result task_fshandle_poll_control(Task *task, int poll_index, HandlePollOperation operation, int handle_index, SelectEvent events);
+
+Result task_fshandle_poll_wait(Task *task, int poll_index, HandlePollEvent *events, size_t count, size_t *ready, Timeout timeout);
+
 Result task_fshandle_read(Task *task, int handle_index, void *buffer, size_t size, size_t *read);
 
 Result task_fshandle_write(Task *task, int handle_index, const void *buffer, size_t size, size_t *written);
 
+Result task_fshandle_readv(Task *task, int handle_index, const IOVector *vectors, size_t count, size_t *read);
+
+Result task_fshandle_writev(Task *task, int handle_index, const IOVector *vectors, size_t count, size_t *written);
+
+Result task_fshandle_pread(Task *task, int handle_index, void *buffer, size_t size, size_t offset, size_t *read);
+
+Result task_fshandle_pwrite(Task *task, int handle_index, const void *buffer, size_t size, size_t offset, size_t *written);
+
+Result task_fshandle_splice(Task *task, int source_index, int destination_index, size_t size, size_t *spliced);
+
 Result task_fshandle_seek(Task *task, int handle_index, int offset, Whence whence);
 
 Result task_fshandle_tell(Task *task, int handle_index, Whence whence, int *offset);
@@ -27,6 +41,8 @@ Result task_fshandle_call(Task *task, int handle_index, IOCall request, void *ar
 
 Result task_fshandle_stat(Task *task, int handle_index, FileState *stat);
 
+Result task_fshandle_map(Task *task, int handle_index, uintptr_t *address, size_t *size);
+
 Result task_fshandle_connect(Task *task, int *handle_index, const char *path);
 
 Result task_fshandle_accept(Task *task, int handle_index, int *connection_handle_index);
@@ -38,3 +54,5 @@ Result task_fshandle_receive(Task *task, int handle_index, void *buffer, size_t
 Result task_create_pipe(Task *task, int *reader_handle_index, int *writer_handle_index);
 
 Result task_create_term(Task *task, int *master_handle_index, int *slave_handle_index);
+
+Result task_create_poll(Task *task, int *poll_handle_index);
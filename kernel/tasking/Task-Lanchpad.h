@@ -4,4 +4,16 @@
 
 #include "kernel/tasking/Task.h"
 
+struct LaunchStatistics
+{
+    size_t count;
+    size_t cache_hits;
+
+    // Total time spent in task_launch(), in cycles
+    uint64_t cold_cycles;
+    uint64_t cached_cycles;
+};
+
 Result task_launch(Task *parent_task, Launchpad *launchpad, int *pid);
+
+LaunchStatistics task_launch_statistics();
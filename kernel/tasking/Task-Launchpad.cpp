@@ -2,41 +2,33 @@
 #include <libsystem/Assert.h>
 #include <libsystem/Logger.h>
 #include <libsystem/core/CString.h>
+#include <libsystem/thread/Atomic.h>
 
+#include "arch/Arch.h"
 #include "kernel/scheduling/Scheduler.h"
+#include "kernel/tasking/Executable.h"
+#include "kernel/tasking/Task-Lanchpad.h"
 #include "kernel/tasking/Task-Memory.h"
 #include "kernel/tasking/Task.h"
 
-Result task_launch_load_elf(Task *parent_task, Task *child_task, Stream *elf_file, ELFProgram *program_header)
-{
-    if (program_header->vaddr <= 0x100000)
-    {
-        logger_error("ELF program no in user memory (0x%08x)!", program_header->vaddr);
-        return ERR_EXEC_FORMAT_ERROR;
-    }
-
-    PageDirectory *parent_page_directory = task_switch_pdir(parent_task, child_task->pdir);
+static LaunchStatistics _launch_statistics = {};
 
+Result task_launch_map_segment(Task *child_task, ELFProgram *program_header, MemoryObject *segment)
+{
     MemoryRange range = memory_range_around_non_aligned_address(program_header->vaddr, program_header->memsz);
 
-    task_memory_map(child_task, range.base, range.size, MEMORY_CLEAR);
-
-    stream_seek(elf_file, program_header->offset, WHENCE_START);
-    size_t read = stream_read(elf_file, (void *)program_header->vaddr, program_header->filesz);
-
-    if (read != program_header->filesz)
+    if (program_header->flags & ELF_PROGRAM_WRITE)
     {
-        logger_error("Didn't read the right amount from the ELF file!");
+        // Writable segments get their own copy of a page the first time they write to it.
+        MemoryObject *copy = memory_object_create_copy_on_write(segment);
+        Result result = task_memory_map_object(child_task, range.base, copy, MEMORY_NONE);
+        memory_object_deref(copy);
 
-        task_switch_pdir(parent_task, parent_page_directory);
-
-        return ERR_EXEC_FORMAT_ERROR;
+        return result;
     }
     else
     {
-        task_switch_pdir(parent_task, parent_page_directory);
-
-        return SUCCESS;
+        return task_memory_map_object(child_task, range.base, segment, MEMORY_READONLY);
     }
 }
 
@@ -68,53 +60,67 @@ Result task_launch(Task *parent_task, Launchpad *launchpad, int *pid)
 
     *pid = -1;
 
-    __cleanup(stream_cleanup) Stream *elf_file = stream_open(launchpad->executable, OPEN_READ);
+    uint64_t launch_start = arch_get_cycles();
+
+    Executable *executable = nullptr;
+    bool cached = false;
+
+    Result result = executable_load(parent_task, launchpad->executable, &executable, &cached);
 
-    if (handle_has_error(elf_file))
+    if (result != SUCCESS)
     {
-        logger_error("Failled to open ELF file %s: %s!", launchpad->executable, handle_error_string(elf_file));
-        return handle_get_error(elf_file);
+        return result;
     }
 
-    ELFHeader elf_header;
+    Task *child_task = task_spawn_with_argv(parent_task, launchpad->name, (TaskEntry)executable->header.entry, (const char **)launchpad->argv, true);
+
+    for (size_t i = 0; i < executable->segments_count; i++)
     {
-        size_t elf_header_size = stream_read(elf_file, &elf_header, sizeof(ELFHeader));
+        ExecutableSegment *segment = &executable->segments[i];
+
+        result = task_launch_map_segment(child_task, &segment->header, segment->object);
 
-        if (elf_header_size != sizeof(ELFHeader) || !elf_valid(&elf_header))
+        if (result != SUCCESS)
         {
-            logger_error("Failled to load ELF file %s: bad exec format!", launchpad->executable);
-            return ERR_EXEC_FORMAT_ERROR;
+            task_destroy(child_task);
+            executable_deref(executable);
+            return result;
         }
     }
 
-    {
-        Task *child_task = task_spawn_with_argv(parent_task, launchpad->name, (TaskEntry)elf_header.entry, (const char **)launchpad->argv, true);
+    executable_deref(executable);
 
-        for (int i = 0; i < elf_header.phnum; i++)
-        {
-            ELFProgram elf_program_header;
-            stream_seek(elf_file, elf_header.phoff + (elf_header.phentsize) * i, WHENCE_START);
-
-            if (stream_read(elf_file, &elf_program_header, sizeof(ELFProgram)) != sizeof(ELFProgram))
-            {
-                task_destroy(child_task);
-                return ERR_EXEC_FORMAT_ERROR;
-            }
-
-            Result result = task_launch_load_elf(parent_task, child_task, elf_file, &elf_program_header);
-
-            if (result != SUCCESS)
-            {
-                task_destroy(child_task);
-                return result;
-            }
-        }
+    task_launch_passhandle(parent_task, child_task, launchpad);
+
+    *pid = child_task->id;
+    task_go(child_task);
+
+    uint64_t launch_cycles = arch_get_cycles() - launch_start;
 
-        task_launch_passhandle(parent_task, child_task, launchpad);
+    atomic_begin();
 
-        *pid = child_task->id;
-        task_go(child_task);
+    _launch_statistics.count++;
+
+    if (cached)
+    {
+        _launch_statistics.cache_hits++;
+        _launch_statistics.cached_cycles += launch_cycles;
+    }
+    else
+    {
+        _launch_statistics.cold_cycles += launch_cycles;
     }
 
+    atomic_end();
+
     return SUCCESS;
 }
+
+LaunchStatistics task_launch_statistics()
+{
+    atomic_begin();
+    LaunchStatistics statistics = _launch_statistics;
+    atomic_end();
+
+    return statistics;
+}
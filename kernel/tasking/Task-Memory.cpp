@@ -1,30 +1,201 @@
+#include <libsystem/Assert.h>
 #include <libsystem/core/CString.h>
+#include <libsystem/math/MinMax.h>
+#include <libsystem/thread/Atomic.h>
 
 #include "kernel/memory/Virtual.h"
 #include "kernel/tasking/Task-Memory.h"
 
+static void task_memory_mapping_map_page(Task *task, MemoryMapping *memory_mapping, size_t index, bool write)
+{
+    MemoryObject *memory_object = memory_mapping->object;
+    uintptr_t page_address = memory_mapping->address + index * PAGE_SIZE;
+
+    if (!write && memory_object_page_shared(memory_object, index))
+    {
+        // Reads go to the source page until the task writes to it.
+        uintptr_t physical_address = memory_object_page(memory_object->source, index);
+        virtual_map(task->pdir, (MemoryRange){physical_address, PAGE_SIZE}, page_address, memory_mapping->flags | MEMORY_READONLY);
+    }
+    else
+    {
+        uintptr_t physical_address = memory_object_page(memory_object, index);
+        virtual_map(task->pdir, (MemoryRange){physical_address, PAGE_SIZE}, page_address, memory_mapping->flags);
+    }
+}
+
+/* --- Address space -------------------------------------------------------- */
+
+// The mappings of a task are kept sorted by address and never overlap, the
+// free ranges of the user address space are the gaps in between.
+
+#define TASK_MEMORY_USER_START (0x40000000)
+#define TASK_MEMORY_USER_END (0xfffff000)
+
+static uintptr_t task_memory_mapping_end(MemoryMapping *memory_mapping)
+{
+    return memory_mapping->address + memory_mapping->size;
+}
+
+// Index of the first mapping ending after the address.
+static size_t task_memory_mapping_lower_bound(Task *task, uintptr_t address)
+{
+    size_t low = 0;
+    size_t high = task->memory_mappings_count;
+
+    while (low < high)
+    {
+        size_t middle = low + (high - low) / 2;
+
+        if (task_memory_mapping_end(task->memory_mappings[middle]) <= address)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return low;
+}
+
+static void task_memory_mapping_insert(Task *task, MemoryMapping *memory_mapping)
+{
+    if (task->memory_mappings_count == task->memory_mappings_allocated)
+    {
+        task->memory_mappings_allocated = MAX(16, task->memory_mappings_allocated * 2);
+        task->memory_mappings = (MemoryMapping **)realloc(task->memory_mappings, sizeof(MemoryMapping *) * task->memory_mappings_allocated);
+    }
+
+    size_t index = task_memory_mapping_lower_bound(task, memory_mapping->address);
+
+    memmove(
+        &task->memory_mappings[index + 1],
+        &task->memory_mappings[index],
+        sizeof(MemoryMapping *) * (task->memory_mappings_count - index));
+
+    task->memory_mappings[index] = memory_mapping;
+    task->memory_mappings_count++;
+}
+
+static void task_memory_mapping_remove(Task *task, MemoryMapping *memory_mapping)
+{
+    size_t index = task_memory_mapping_lower_bound(task, memory_mapping->address);
+
+    assert(task->memory_mappings[index] == memory_mapping);
+
+    task->memory_mappings_count--;
+
+    memmove(
+        &task->memory_mappings[index],
+        &task->memory_mappings[index + 1],
+        sizeof(MemoryMapping *) * (task->memory_mappings_count - index));
+}
+
+static bool task_memory_find_free_from(Task *task, uintptr_t from, size_t size, uintptr_t *out_address)
+{
+    uintptr_t gap_start = from;
+    size_t index = task_memory_mapping_lower_bound(task, from);
+
+    while (true)
+    {
+        if (index < task->memory_mappings_count &&
+            task->memory_mappings[index]->address <= gap_start)
+        {
+            gap_start = task_memory_mapping_end(task->memory_mappings[index]);
+            index++;
+            continue;
+        }
+
+        uintptr_t gap_end = TASK_MEMORY_USER_END;
+
+        if (index < task->memory_mappings_count)
+        {
+            gap_end = task->memory_mappings[index]->address;
+        }
+
+        if (gap_start < gap_end && gap_end - gap_start >= size)
+        {
+            *out_address = gap_start;
+            return true;
+        }
+
+        if (index == task->memory_mappings_count)
+        {
+            return false;
+        }
+
+        gap_start = task_memory_mapping_end(task->memory_mappings[index]);
+        index++;
+    }
+}
+
+// Next fit: start looking where the last allocation ended so growing address
+// spaces don't walk over all of their mappings every time.
+static Result task_memory_find_free(Task *task, size_t size, uintptr_t *out_address)
+{
+    uintptr_t hint = MAX(task->memory_mappings_hint, TASK_MEMORY_USER_START);
+
+    if (hint >= TASK_MEMORY_USER_END ||
+        !task_memory_find_free_from(task, hint, size, out_address))
+    {
+        if (!task_memory_find_free_from(task, TASK_MEMORY_USER_START, size, out_address))
+        {
+            return ERR_OUT_OF_MEMORY;
+        }
+    }
+
+    task->memory_mappings_hint = *out_address + size;
+
+    return SUCCESS;
+}
+
+/* --- Memory mappings ------------------------------------------------------ */
+
 MemoryMapping *task_memory_mapping_create(Task *task, MemoryObject *memory_object)
 {
+    uintptr_t address = 0;
+
+    if (task_memory_find_free(task, memory_object->size, &address) != SUCCESS)
+    {
+        return nullptr;
+    }
+
+    if (virtual_reserve_at(task->pdir, (MemoryRange){address, memory_object->size}, MEMORY_USER) != SUCCESS)
+    {
+        virtual_free(task->pdir, (MemoryRange){address, memory_object->size});
+        return nullptr;
+    }
+
     MemoryMapping *memory_mapping = __create(MemoryMapping);
 
     memory_mapping->object = memory_object_ref(memory_object);
-    memory_mapping->address = virtual_alloc(task->pdir, (MemoryRange){memory_object->address, memory_object->size}, MEMORY_USER).base;
+    memory_mapping->address = address;
     memory_mapping->size = memory_object->size;
+    memory_mapping->flags = MEMORY_USER | (memory_object->read_only ? MEMORY_READONLY : 0);
 
-    list_pushback(task->memory_mapping, memory_mapping);
+    task_memory_mapping_insert(task, memory_mapping);
 
     return memory_mapping;
 }
 
-MemoryMapping *task_memory_mapping_create_at(Task *task, MemoryObject *memory_object, uintptr_t address)
+MemoryMapping *task_memory_mapping_create_at(Task *task, MemoryObject *memory_object, uintptr_t address, MemoryFlags flags)
 {
+    if (virtual_reserve_at(task->pdir, (MemoryRange){address, memory_object->size}, MEMORY_USER) != SUCCESS)
+    {
+        virtual_free(task->pdir, (MemoryRange){address, memory_object->size});
+        return nullptr;
+    }
+
     MemoryMapping *memory_mapping = __create(MemoryMapping);
 
     memory_mapping->object = memory_object_ref(memory_object);
-    memory_mapping->address = virtual_map(task->pdir, memory_object->range(), address, MEMORY_USER);
+    memory_mapping->address = address;
     memory_mapping->size = memory_object->size;
+    memory_mapping->flags = MEMORY_USER | flags | (memory_object->read_only ? MEMORY_READONLY : 0);
 
-    list_pushback(task->memory_mapping, memory_mapping);
+    task_memory_mapping_insert(task, memory_mapping);
 
     return memory_mapping;
 }
@@ -34,35 +205,41 @@ void task_memory_mapping_destroy(Task *task, MemoryMapping *memory_mapping)
     virtual_free(task->pdir, (MemoryRange){memory_mapping->address, memory_mapping->size});
     memory_object_deref(memory_mapping->object);
 
-    list_remove(task->memory_mapping, memory_mapping);
+    task_memory_mapping_remove(task, memory_mapping);
     free(memory_mapping);
 }
 
 MemoryMapping *task_memory_mapping_by_address(Task *task, uintptr_t address)
 {
-    list_foreach(MemoryMapping, memory_mapping, task->memory_mapping)
+    MemoryMapping *memory_mapping = task_memory_mapping_containing(task, address);
+
+    if (memory_mapping && memory_mapping->address == address)
     {
-        if (memory_mapping->address == address)
-        {
-            return memory_mapping;
-        }
+        return memory_mapping;
     }
 
     return nullptr;
 }
 
-bool task_memory_mapping_colides(Task *task, uintptr_t address, size_t size)
+MemoryMapping *task_memory_mapping_containing(Task *task, uintptr_t address)
 {
-    list_foreach(MemoryMapping, memory_mapping, task->memory_mapping)
+    size_t index = task_memory_mapping_lower_bound(task, address);
+
+    if (index < task->memory_mappings_count &&
+        task->memory_mappings[index]->address <= address)
     {
-        if (address < memory_mapping->address + memory_mapping->size &&
-            address + size > memory_mapping->address)
-        {
-            return true;
-        }
+        return task->memory_mappings[index];
     }
 
-    return false;
+    return nullptr;
+}
+
+bool task_memory_mapping_colides(Task *task, uintptr_t address, size_t size)
+{
+    size_t index = task_memory_mapping_lower_bound(task, address);
+
+    return index < task->memory_mappings_count &&
+           task->memory_mappings[index]->address < address + size;
 }
 
 /* --- User facing API ------------------------------------------------------ */
@@ -75,27 +252,26 @@ Result task_memory_alloc(Task *task, size_t size, uintptr_t *out_address)
 
     memory_object_deref(memory_object);
 
+    if (!memory_mapping)
+    {
+        return ERR_OUT_OF_MEMORY;
+    }
+
     *out_address = memory_mapping->address;
 
     return SUCCESS;
 }
 
-Result task_memory_map(Task *task, uintptr_t address, size_t size, MemoryFlags flags)
+Result task_memory_map_object(Task *task, uintptr_t address, MemoryObject *memory_object, MemoryFlags flags)
 {
-    if (task_memory_mapping_colides(task, address, size))
+    if (task_memory_mapping_colides(task, address, memory_object->size))
     {
         return ERR_BAD_ADDRESS;
     }
 
-    MemoryObject *memory_object = memory_object_create(size);
-
-    task_memory_mapping_create_at(task, memory_object, address);
-
-    memory_object_deref(memory_object);
-
-    if (flags & MEMORY_CLEAR)
+    if (!task_memory_mapping_create_at(task, memory_object, address, flags))
     {
-        memset((void *)address, 0, size);
+        return ERR_OUT_OF_MEMORY;
     }
 
     return SUCCESS;
@@ -128,6 +304,11 @@ Result task_memory_include(Task *task, int handle, uintptr_t *out_address, size_
 
     memory_object_deref(memory_object);
 
+    if (!memory_mapping)
+    {
+        return ERR_OUT_OF_MEMORY;
+    }
+
     *out_address = memory_mapping->address;
     *out_size = memory_mapping->size;
 
@@ -147,6 +328,39 @@ Result task_memory_get_handle(Task *task, uintptr_t address, int *out_handle)
     return SUCCESS;
 }
 
+Result task_memory_page_fault(Task *task, uintptr_t address, bool write)
+{
+    MemoryMapping *memory_mapping = task_memory_mapping_containing(task, address);
+
+    if (!memory_mapping)
+    {
+        return ERR_BAD_ADDRESS;
+    }
+
+    if (write && (memory_mapping->flags & MEMORY_READONLY))
+    {
+        return ERR_BAD_ADDRESS;
+    }
+
+    atomic_begin();
+
+    size_t index = (PAGE_ALIGN_DOWN(address) - memory_mapping->address) / PAGE_SIZE;
+
+    // A present page can only fault because it is shared with the source of a copy-on-write object.
+    if (virtual_present(task->pdir, address) &&
+        !(write && memory_object_page_shared(memory_mapping->object, index)))
+    {
+        atomic_end();
+        return ERR_BAD_ADDRESS;
+    }
+
+    task_memory_mapping_map_page(task, memory_mapping, index, write);
+
+    atomic_end();
+
+    return SUCCESS;
+}
+
 PageDirectory *task_switch_pdir(Task *task, PageDirectory *pdir)
 {
     PageDirectory *oldpdir = task->pdir;
@@ -158,13 +372,25 @@ PageDirectory *task_switch_pdir(Task *task, PageDirectory *pdir)
     return oldpdir;
 }
 
-size_t task_memory_usage(Task *task)
+size_t task_memory_virtual_usage(Task *task)
+{
+    size_t total = 0;
+
+    for (size_t i = 0; i < task->memory_mappings_count; i++)
+    {
+        total += task->memory_mappings[i]->size;
+    }
+
+    return total;
+}
+
+size_t task_memory_resident_usage(Task *task)
 {
     size_t total = 0;
 
-    list_foreach(MemoryMapping, memory_mapping, task->memory_mapping)
+    for (size_t i = 0; i < task->memory_mappings_count; i++)
     {
-        total += memory_mapping->size;
+        total += task->memory_mappings[i]->object->resident * PAGE_SIZE;
     }
 
     return total;
@@ -9,6 +9,7 @@ struct MemoryMapping
 
     uintptr_t address;
     size_t size;
+    MemoryFlags flags;
 };
 
 MemoryMapping *task_memory_mapping_create(Task *task, MemoryObject *memory_object);
@@ -17,9 +18,11 @@ void task_memory_mapping_destroy(Task *task, MemoryMapping *memory_mapping);
 
 MemoryMapping *task_memory_mapping_by_address(Task *task, uintptr_t address);
 
+MemoryMapping *task_memory_mapping_containing(Task *task, uintptr_t address);
+
 Result task_memory_alloc(Task *task, size_t size, uintptr_t *out_address);
 
-Result task_memory_map(Task *task, uintptr_t address, size_t size, MemoryFlags flags);
+Result task_memory_map_object(Task *task, uintptr_t address, MemoryObject *memory_object, MemoryFlags flags);
 
 Result task_memory_free(Task *task, uintptr_t address);
 
@@ -27,6 +30,10 @@ Result task_memory_include(Task *task, int handle, uintptr_t *out_address, size_
 
 Result task_memory_get_handle(Task *task, uintptr_t address, int *out_handle);
 
+Result task_memory_page_fault(Task *task, uintptr_t address, bool write);
+
 PageDirectory *task_switch_pdir(Task *task, PageDirectory *pdir);
 
-size_t task_memory_usage(Task *task);
\ No newline at end of file
+size_t task_memory_virtual_usage(Task *task);
+
+size_t task_memory_resident_usage(Task *task);
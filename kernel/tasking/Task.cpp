@@ -28,6 +28,20 @@ Task *task_create(Task *parent, const char *name, bool user)
     task->id = _task_ids++;
     strlcpy(task->name, name, PROCESS_NAME_SIZE);
     task->state = TASK_STATE_NONE;
+    task->wait_queues = list_create();
+
+    if (parent != nullptr)
+    {
+        task->parent_id = parent->id;
+        task->priority = parent->priority;
+    }
+    else
+    {
+        task->parent_id = -1;
+        task->priority = PROCESS_PRIORITY_DEFAULT;
+    }
+
+    task->dynamic_priority = task->priority;
 
     // Setup memory space
     if (user)
@@ -40,7 +54,10 @@ Task *task_create(Task *parent, const char *name, bool user)
     }
 
     // Setup shms
-    task->memory_mapping = list_create();
+    task->memory_mappings = nullptr;
+    task->memory_mappings_count = 0;
+    task->memory_mappings_allocated = 0;
+    task->memory_mappings_hint = 0;
 
     // Setup current working directory.
     lock_init(task->directory_lock);
@@ -83,12 +100,15 @@ void task_destroy(Task *task)
     list_remove(_tasks, task);
     atomic_end();
 
-    list_foreach(MemoryMapping, memory_mapping, task->memory_mapping)
+    wait_queue_destroy(&task->exit_waiters);
+    list_destroy(task->wait_queues);
+
+    while (task->memory_mappings_count > 0)
     {
-        task_memory_mapping_destroy(task, memory_mapping);
+        task_memory_mapping_destroy(task, task->memory_mappings[task->memory_mappings_count - 1]);
     }
 
-    list_destroy(task->memory_mapping);
+    free(task->memory_mappings);
 
     task_fshandle_close_all(task);
 
@@ -190,6 +210,20 @@ void task_set_state(Task *task, TaskState state)
     task->state = state;
 }
 
+Result task_set_priority(Task *task, int priority)
+{
+    if (priority < PROCESS_PRIORITY_HIGHEST || priority > PROCESS_PRIORITY_LOWEST)
+    {
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    atomic_begin();
+    scheduler_did_change_task_priority(task, priority);
+    atomic_end();
+
+    return SUCCESS;
+}
+
 void task_set_entry(Task *task, TaskEntry entry, bool user)
 {
     task->entry = entry;
@@ -228,7 +262,7 @@ void task_go(Task *task)
 
 Result task_sleep(Task *task, int timeout)
 {
-    task_block(task, blocker_time_create(system_get_tick() + timeout), -1);
+    task_block(task, blocker_time_create(system_get_tick() + timeout), timeout);
 
     return TIMEOUT;
 }
@@ -286,6 +320,11 @@ BlockerResult task_block(Task *task, Blocker *blocker, Timeout timeout)
         blocker->timeout = system_get_tick() + timeout;
     }
 
+    if (blocker->on_block)
+    {
+        blocker->on_block(blocker, task);
+    }
+
     task_set_state(task, TASK_STATE_BLOCKED);
     atomic_end();
 
@@ -308,6 +347,8 @@ Result task_cancel(Task *task, int exit_value)
     task->exit_value = exit_value;
     task_set_state(task, TASK_STATE_CANCELED);
 
+    wait_queue_wake(&task->exit_waiters);
+
     atomic_end();
 
     return SUCCESS;
@@ -10,15 +10,40 @@
 
 typedef void (*TaskEntry)();
 
+struct MemoryMapping;
+
 struct Task
 {
     int id;
+    int parent_id; // -1 for tasks spawned by the kernel
     bool user;
     char name[PROCESS_NAME_SIZE]; // Friendly name of the process
 
     TaskState state;
     Blocker *blocker;
 
+    int priority;         // Priority set by the user
+    int dynamic_priority; // Priority used by the scheduler (boosted on wakeup, decay with cpu usage)
+    int time_slice;       // Ticks left before the task is preempted
+    Task *run_next;
+    Task *run_prev;
+
+    // CPU accounting, in cycles (see arch_get_cycles())
+    bool in_syscall;
+    uint64_t user_cycles;
+    uint64_t kernel_cycles;
+    uint32_t usage_period;
+    uint64_t usage_period_cycles;
+    uint64_t usage_last_period_cycles;
+    size_t context_switches;
+    size_t wakeups;
+
+    List *wait_queues;   // Wait queues we are registered in while blocked
+    bool wakeup_pending; // Our blocker needs to be checked by the scheduler
+    Task *next_wakeup;
+
+    WaitQueue exit_waiters;
+
     uintptr_t stack_pointer;
     void *stack;     // Kernel stack
     TaskEntry entry; // Our entry point
@@ -30,7 +55,11 @@ struct Task
     Lock directory_lock;
     Path *directory;
 
-    List *memory_mapping;
+    // Sorted by address, see Task-Memory.cpp.
+    MemoryMapping **memory_mappings;
+    size_t memory_mappings_count;
+    size_t memory_mappings_allocated;
+    uintptr_t memory_mappings_hint;
     PageDirectory *pdir; // Page directory
 
     int exit_value;
@@ -53,6 +82,8 @@ Task *task_spawn_with_argv(Task *parent, const char *name, TaskEntry entry, cons
 
 void task_set_state(Task *task, TaskState state);
 
+Result task_set_priority(Task *task, int priority);
+
 void task_set_entry(Task *task, TaskEntry entry, bool user);
 
 uintptr_t task_stack_push(Task *task, const void *value, uint size);
@@ -1,6 +1,7 @@
 #include "kernel/tasking/Tasking.h"
 #include "kernel/scheduling/Scheduler.h"
 #include "kernel/system/System.h"
+#include "kernel/tasking/Executable.h"
 #include "kernel/tasking/Task.h"
 
 static Iteration destroy_task_if_canceled(void *target, Task *task)
@@ -26,6 +27,8 @@ void garbage_collector()
 
 void tasking_initialize()
 {
+    executable_cache_initialize();
+
     Task *idle_task = task_spawn(nullptr, "Idle", system_hang, nullptr, false);
     task_go(idle_task);
     task_set_state(idle_task, TASK_STATE_HANG);
@@ -1,4 +1,203 @@
-#include <kernel/virtio/Block.h>
+#include <libsystem/Logger.h>
+#include <libsystem/math/MinMax.h>
+#include <libsystem/thread/Atomic.h>
+
+#include "arch/x86/x86.h"
+#include "kernel/bus/PCI.h"
+#include "kernel/devices/Disk.h"
+#include "kernel/interrupts/Dispatcher.h"
+#include "kernel/memory/Memory.h"
+#include "kernel/memory/Virtual.h"
+#include "kernel/scheduling/Blocker.h"
+#include "kernel/scheduling/Scheduler.h"
+#include "kernel/tasking/Task.h"
+#include "kernel/virtio/Block.h"
+#include "kernel/virtio/VirtQueue.h"
+
+// 5.2 Block Device
+
+#define VIRTIO_BLOCK_MAX_DEVICES (4)
+
+#define VIRTIO_BLOCK_REQUEST_IN (0)
+#define VIRTIO_BLOCK_REQUEST_OUT (1)
+
+#define VIRTIO_BLOCK_STATUS_OK (0)
+
+#define VIRTIO_BLOCK_CONFIG_CAPACITY (VIRTIO_REGISTER_DEVICE_CONFIG)
+
+struct __packed VirtioBlockRequestHeader
+{
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t sector;
+};
+
+struct VirtioBlock
+{
+    uint16_t iobase;
+    int interrupt;
+
+    VirtQueue *queue;
+
+    // Headers and statuses of the requests, indexed by their head descriptor.
+    uintptr_t dma;
+    size_t dma_size;
+    VirtioBlockRequestHeader *headers;
+    uint8_t *statuses;
+    DiskRequest **requests;
+
+    Disk *disk;
+};
+
+static VirtioBlock _devices[VIRTIO_BLOCK_MAX_DEVICES] = {};
+static int _devices_count = 0;
+
+/* --- Requests ------------------------------------------------------------- */
+
+struct BlockerVirtioBlock : public Blocker
+{
+    VirtioBlock *device;
+    size_t descriptors;
+};
+
+static void blocker_virtio_block_on_block(BlockerVirtioBlock *blocker, Task *task)
+{
+    wait_queue_wait(&blocker->device->disk->waiters, task);
+}
+
+static bool blocker_virtio_block_can_unblock(BlockerVirtioBlock *blocker, Task *task)
+{
+    __unused(task);
+
+    return blocker->device->queue->free_count >= blocker->descriptors;
+}
+
+static Result virtio_block_submit(Disk *disk, DiskRequest *request)
+{
+    VirtioBlock *device = (VirtioBlock *)disk->driver;
+
+    VirtQueueBuffer buffers[DISK_REQUEST_MAX_PAGES + 2];
+    size_t count = 1; // The header is filled once we know the head descriptor.
+
+    for (size_t i = 0; i < request->page_count && i * PAGE_SIZE < request->size; i++)
+    {
+        buffers[count].address = virtual_to_physical(memory_kpdir(), request->pages[i]);
+        buffers[count].length = MIN(PAGE_SIZE, request->size - i * PAGE_SIZE);
+        buffers[count].device_writable = !request->write;
+        count++;
+    }
+
+    count++; // The status
+
+    if (count > device->queue->size)
+    {
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    while (true)
+    {
+        atomic_begin();
+
+        if (device->queue->free_count >= count)
+        {
+            break;
+        }
+
+        atomic_end();
+
+        // Wait for some requests to complete.
+        BlockerVirtioBlock *blocker = __create(BlockerVirtioBlock);
+
+        TASK_BLOCKER(blocker)->on_block = (BlockerBlockCallback)blocker_virtio_block_on_block;
+        TASK_BLOCKER(blocker)->can_unblock = (BlockerCanUnblockCallback)blocker_virtio_block_can_unblock;
+
+        blocker->device = device;
+        blocker->descriptors = count;
+
+        task_block(scheduler_running(), blocker, -1);
+    }
+
+    // The chain start at the first free descriptor.
+    uint16_t head = device->queue->free_head;
+
+    VirtioBlockRequestHeader *header = &device->headers[head];
+    header->type = request->write ? VIRTIO_BLOCK_REQUEST_OUT : VIRTIO_BLOCK_REQUEST_IN;
+    header->reserved = 0;
+    header->sector = request->sector;
+
+    device->statuses[head] = 0xff;
+    device->requests[head] = request;
+
+    buffers[0].address = virtual_to_physical(memory_kpdir(), (uintptr_t)header);
+    buffers[0].length = sizeof(VirtioBlockRequestHeader);
+    buffers[0].device_writable = false;
+
+    buffers[count - 1].address = virtual_to_physical(memory_kpdir(), (uintptr_t)&device->statuses[head]);
+    buffers[count - 1].length = 1;
+    buffers[count - 1].device_writable = true;
+
+    virtqueue_push(device->queue, buffers, count);
+    virtqueue_notify(device->queue);
+
+    atomic_end();
+
+    return SUCCESS;
+}
+
+/* --- Interrupts ----------------------------------------------------------- */
+
+static void virtio_block_interrupt_acknowledge()
+{
+    // Reading the ISR status deassert the interrupt line.
+    for (int i = 0; i < _devices_count; i++)
+    {
+        in8(_devices[i].iobase + VIRTIO_REGISTER_ISR_STATUS);
+    }
+}
+
+static void virtio_block_interrupt_handler()
+{
+    for (int i = 0; i < _devices_count; i++)
+    {
+        VirtioBlock *device = &_devices[i];
+
+        while (true)
+        {
+            atomic_begin();
+
+            uint16_t head;
+            uint32_t length;
+            bool completed = virtqueue_pop(device->queue, &head, &length);
+
+            DiskRequest *request = nullptr;
+            uint8_t status = 0;
+
+            if (completed)
+            {
+                request = device->requests[head];
+                status = device->statuses[head];
+                device->requests[head] = nullptr;
+            }
+
+            atomic_end();
+
+            if (!completed)
+            {
+                break;
+            }
+
+            if (request)
+            {
+                disk_request_complete(
+                    device->disk,
+                    request,
+                    status == VIRTIO_BLOCK_STATUS_OK ? SUCCESS : ERR_INPUT_OUTPUT_ERROR);
+            }
+        }
+    }
+}
+
+/* --- Device --------------------------------------------------------------- */
 
 bool virtio_block_match(DeviceInfo info)
 {
@@ -7,5 +206,62 @@ bool virtio_block_match(DeviceInfo info)
 
 void virtio_block_initialize(DeviceInfo info)
 {
-    __unused(info);
+    if (_devices_count >= VIRTIO_BLOCK_MAX_DEVICES)
+    {
+        logger_warn("Too many virtio block devices!");
+        return;
+    }
+
+    VirtioBlock *device = &_devices[_devices_count];
+
+    device->iobase = virtio_device_iobase(info);
+    virtio_device_negotiate(device->iobase, 0);
+
+    device->queue = virtqueue_create(device->iobase, 0);
+
+    if (!device->queue)
+    {
+        virtio_device_failed(device->iobase);
+        return;
+    }
+
+    size_t size = device->queue->size;
+    device->dma_size = PAGE_ALIGN_UP(size * sizeof(VirtioBlockRequestHeader) + size);
+
+    if (memory_alloc(memory_kpdir(), device->dma_size, MEMORY_CLEAR, &device->dma) != SUCCESS)
+    {
+        virtqueue_destroy(device->queue);
+        virtio_device_failed(device->iobase);
+        return;
+    }
+
+    device->headers = (VirtioBlockRequestHeader *)device->dma;
+    device->statuses = (uint8_t *)(device->dma + size * sizeof(VirtioBlockRequestHeader));
+    device->requests = (DiskRequest **)calloc(size, sizeof(DiskRequest *));
+
+    uint64_t capacity = in32(device->iobase + VIRTIO_BLOCK_CONFIG_CAPACITY) |
+                        ((uint64_t)in32(device->iobase + VIRTIO_BLOCK_CONFIG_CAPACITY + 4) << 32);
+
+    device->interrupt = pci_get_interrupt(info.pci_device);
+
+    bool interrupt_registered = false;
+
+    for (int i = 0; i < _devices_count; i++)
+    {
+        interrupt_registered |= _devices[i].interrupt == device->interrupt;
+    }
+
+    if (!interrupt_registered)
+    {
+        dispatcher_register_acknowledge(device->interrupt, virtio_block_interrupt_acknowledge);
+        dispatcher_register_handler(device->interrupt, virtio_block_interrupt_handler);
+    }
+
+    device->disk = disk_create(capacity, virtio_block_submit, device);
+
+    atomic_begin();
+    _devices_count++;
+    atomic_end();
+
+    virtio_device_ready(device->iobase);
 }
@@ -0,0 +1,149 @@
+#include <libsystem/Logger.h>
+
+#include "arch/x86/x86.h"
+#include "kernel/memory/Memory.h"
+#include "kernel/memory/Paging.h"
+#include "kernel/memory/Virtual.h"
+#include "kernel/virtio/Virtio.h"
+#include "kernel/virtio/VirtQueue.h"
+
+// 2.4.2 Legacy Interfaces: A Note on Virtqueue Layout
+static size_t virtqueue_available_offset(uint16_t size)
+{
+    return sizeof(VirtQueueDescriptor) * size;
+}
+
+static size_t virtqueue_used_offset(uint16_t size)
+{
+    return PAGE_ALIGN_UP(virtqueue_available_offset(size) + sizeof(VirtQueueAvailable) + sizeof(uint16_t) * (size + 1));
+}
+
+static size_t virtqueue_memory_size(uint16_t size)
+{
+    return virtqueue_used_offset(size) + PAGE_ALIGN_UP(sizeof(VirtQueueUsed) + sizeof(VirtQueueUsedElement) * size + sizeof(uint16_t));
+}
+
+VirtQueue *virtqueue_create(uint16_t iobase, uint16_t index)
+{
+    out16(iobase + VIRTIO_REGISTER_QUEUE_SELECT, index);
+    uint16_t size = in16(iobase + VIRTIO_REGISTER_QUEUE_SIZE);
+
+    if (size == 0)
+    {
+        logger_error("Virtqueue %d is not available!", index);
+        return nullptr;
+    }
+
+    VirtQueue *queue = __create(VirtQueue);
+
+    queue->iobase = iobase;
+    queue->index = index;
+    queue->size = size;
+    queue->memory_size = virtqueue_memory_size(size);
+
+    // The legacy interface expect the queue to be physically contiguous.
+    if (memory_alloc(memory_kpdir(), queue->memory_size, MEMORY_CLEAR, &queue->memory) != SUCCESS)
+    {
+        free(queue);
+        return nullptr;
+    }
+
+    queue->descriptors = (VirtQueueDescriptor *)queue->memory;
+    queue->available = (VirtQueueAvailable *)(queue->memory + virtqueue_available_offset(size));
+    queue->used = (VirtQueueUsed *)(queue->memory + virtqueue_used_offset(size));
+
+    for (uint16_t i = 0; i < size; i++)
+    {
+        queue->descriptors[i].next = i + 1 < size ? i + 1 : VIRTQUEUE_NO_DESCRIPTOR;
+    }
+
+    queue->free_head = 0;
+    queue->free_count = size;
+    queue->last_used = 0;
+
+    uintptr_t physical = virtual_to_physical(memory_kpdir(), queue->memory);
+    out32(iobase + VIRTIO_REGISTER_QUEUE_ADDRESS, physical / PAGE_SIZE);
+
+    return queue;
+}
+
+void virtqueue_destroy(VirtQueue *queue)
+{
+    out16(queue->iobase + VIRTIO_REGISTER_QUEUE_SELECT, queue->index);
+    out32(queue->iobase + VIRTIO_REGISTER_QUEUE_ADDRESS, 0);
+
+    memory_free(memory_kpdir(), (MemoryRange){queue->memory, queue->memory_size});
+    free(queue);
+}
+
+uint16_t virtqueue_push(VirtQueue *queue, VirtQueueBuffer *buffers, size_t count)
+{
+    if (count == 0 || count > queue->free_count)
+    {
+        return VIRTQUEUE_NO_DESCRIPTOR;
+    }
+
+    uint16_t head = queue->free_head;
+    uint16_t current = head;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        VirtQueueDescriptor &descriptor = queue->descriptors[current];
+
+        descriptor.address = buffers[i].address;
+        descriptor.length = buffers[i].length;
+        descriptor.flags = buffers[i].device_writable ? VIRTQUEUE_DESCRIPTOR_WRITE : 0;
+
+        if (i + 1 < count)
+        {
+            descriptor.flags |= VIRTQUEUE_DESCRIPTOR_NEXT;
+            current = descriptor.next;
+        }
+    }
+
+    queue->free_head = queue->descriptors[current].next;
+    queue->free_count -= count;
+
+    queue->available->ring[queue->available->index % queue->size] = head;
+
+    // The device must see the descriptors before the new index.
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    queue->available->index++;
+
+    return head;
+}
+
+void virtqueue_notify(VirtQueue *queue)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    out16(queue->iobase + VIRTIO_REGISTER_QUEUE_NOTIFY, queue->index);
+}
+
+bool virtqueue_pop(VirtQueue *queue, uint16_t *head, uint32_t *length)
+{
+    if (queue->last_used == __atomic_load_n(&queue->used->index, __ATOMIC_ACQUIRE))
+    {
+        return false;
+    }
+
+    VirtQueueUsedElement &element = queue->used->ring[queue->last_used % queue->size];
+    queue->last_used++;
+
+    *head = element.id;
+    *length = element.length;
+
+    // Give the chain back to the free list.
+    uint16_t current = element.id;
+    queue->free_count++;
+
+    while (queue->descriptors[current].flags & VIRTQUEUE_DESCRIPTOR_NEXT)
+    {
+        current = queue->descriptors[current].next;
+        queue->free_count++;
+    }
+
+    queue->descriptors[current].next = queue->free_head;
+    queue->free_head = element.id;
+
+    return true;
+}
@@ -0,0 +1,76 @@
+#pragma once
+
+#include <libsystem/Common.h>
+
+// 2.4 Virtqueues (legacy interface)
+
+#define VIRTQUEUE_DESCRIPTOR_NEXT (1)
+#define VIRTQUEUE_DESCRIPTOR_WRITE (2)
+
+#define VIRTQUEUE_NO_DESCRIPTOR (0xffff)
+
+struct __packed VirtQueueDescriptor
+{
+    uint64_t address;
+    uint32_t length;
+    uint16_t flags;
+    uint16_t next;
+};
+
+struct __packed VirtQueueAvailable
+{
+    uint16_t flags;
+    uint16_t index;
+    uint16_t ring[];
+};
+
+struct __packed VirtQueueUsedElement
+{
+    uint32_t id;
+    uint32_t length;
+};
+
+struct __packed VirtQueueUsed
+{
+    uint16_t flags;
+    uint16_t index;
+    VirtQueueUsedElement ring[];
+};
+
+struct VirtQueue
+{
+    uint16_t iobase;
+    uint16_t index;
+    uint16_t size;
+
+    uintptr_t memory;
+    size_t memory_size;
+
+    VirtQueueDescriptor *descriptors;
+    VirtQueueAvailable *available;
+    VirtQueueUsed *used;
+
+    uint16_t free_head;
+    uint16_t free_count;
+    uint16_t last_used;
+};
+
+struct VirtQueueBuffer
+{
+    uintptr_t address; // Physical address
+    uint32_t length;
+    bool device_writable;
+};
+
+VirtQueue *virtqueue_create(uint16_t iobase, uint16_t index);
+
+void virtqueue_destroy(VirtQueue *queue);
+
+// Chain the buffers, and return the head descriptor or VIRTQUEUE_NO_DESCRIPTOR
+// if there is not enough free descriptors.
+uint16_t virtqueue_push(VirtQueue *queue, VirtQueueBuffer *buffers, size_t count);
+
+void virtqueue_notify(VirtQueue *queue);
+
+// Return true and give back the descriptors if the device is done with a chain.
+bool virtqueue_pop(VirtQueue *queue, uint16_t *head, uint32_t *length);
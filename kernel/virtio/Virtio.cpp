@@ -1,5 +1,6 @@
 #include <libsystem/Logger.h>
 
+#include "arch/x86/x86.h"
 #include "kernel/bus/PCI.h"
 #include "kernel/virtio/Virtio.h"
 
@@ -8,6 +9,38 @@ void virtio_device_initialize(DeviceInfo info)
     logger_info("Initializing virtIO device %s", device_to_static_string(info));
 }
 
+uint16_t virtio_device_iobase(DeviceInfo info)
+{
+    // Let the device do I/O and DMA.
+    uint32_t command = pci_device_read(info.pci_device, PCI_COMMAND, 2);
+    pci_device_write(info.pci_device, PCI_COMMAND, 2, command | PCI_COMMAND_IO | PCI_COMMAND_BUS_MASTER);
+
+    return pci_device_read_bar(info.pci_device, 0) & 0xFFFC;
+}
+
+uint32_t virtio_device_negotiate(uint16_t iobase, uint32_t supported_features)
+{
+    out8(iobase + VIRTIO_REGISTER_DEVICE_STATUS, 0);
+    out8(iobase + VIRTIO_REGISTER_DEVICE_STATUS, VIRTIO_STATUS_ACKNOWLEDGE);
+    out8(iobase + VIRTIO_REGISTER_DEVICE_STATUS, VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER);
+
+    uint32_t features = in32(iobase + VIRTIO_REGISTER_DEVICE_FEATURES) & supported_features;
+    out32(iobase + VIRTIO_REGISTER_GUEST_FEATURES, features);
+
+    return features;
+}
+
+void virtio_device_ready(uint16_t iobase)
+{
+    out8(iobase + VIRTIO_REGISTER_DEVICE_STATUS,
+         VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER | VIRTIO_STATUS_DRIVER_OK);
+}
+
+void virtio_device_failed(uint16_t iobase)
+{
+    out8(iobase + VIRTIO_REGISTER_DEVICE_STATUS, VIRTIO_STATUS_FAILED);
+}
+
 bool virtio_is_virtio_device(DeviceInfo info)
 {
     return info.bus == BUS_PCI &&
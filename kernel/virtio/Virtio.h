@@ -19,6 +19,9 @@
 #define VIRTIO_REGISTER_QUEUE_NOTIFY (0x10)
 #define VIRTIO_REGISTER_DEVICE_STATUS (0x12)
 #define VIRTIO_REGISTER_ISR_STATUS (0x13)
+#define VIRTIO_REGISTER_DEVICE_CONFIG (0x14)
+
+#define VIRTIO_ISR_QUEUE (1 << 0)
 
 #define VIRTIO_DEVICE_NETWORK (1)
 #define VIRTIO_DEVICE_BLOCK (2)
@@ -28,6 +31,16 @@
 
 void virtio_device_initialize(DeviceInfo info);
 
+// Legacy devices are driven through the I/O ports of BAR0.
+uint16_t virtio_device_iobase(DeviceInfo info);
+
+// Reset the device, and negotiate features, return the accepted ones.
+uint32_t virtio_device_negotiate(uint16_t iobase, uint32_t supported_features);
+
+void virtio_device_ready(uint16_t iobase);
+
+void virtio_device_failed(uint16_t iobase);
+
 bool virtio_is_virtio_device(DeviceInfo info);
 
 bool virtio_is_specific_virtio_device(DeviceInfo info, int specific);
@@ -25,6 +25,7 @@ enum FileType
     FILE_TYPE_SOCKET,
     FILE_TYPE_CONNECTION,
     FILE_TYPE_TERMINAL,
+    FILE_TYPE_POLL,
 };
 
 #define OPEN_READ (1 << 0)
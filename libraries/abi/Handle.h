@@ -26,6 +26,28 @@ struct HandleSet
     size_t count;
 };
 
+enum HandlePollOperation
+{
+    HANDLE_POLL_ADD,
+    HANDLE_POLL_MODIFY,
+    HANDLE_POLL_REMOVE,
+};
+
+struct HandlePollEvent
+{
+    int handle;
+    SelectEvent events;
+};
+
+// One of the buffers of a vectored read or write.
+struct IOVector
+{
+    void *buffer;
+    size_t size;
+};
+
+#define HANDLE_IO_VECTOR_MAX (16)
+
 #define HANDLE_INVALID_ID (-1)
 
 #define HANDLE(__subclass) ((Handle *)(__subclass))
@@ -14,16 +14,42 @@ struct IOCallDisplayModeArgs
     int height;
 };
 
+struct IOCallDisplayBlitRectangle
+{
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+#define IOCALL_DISPLAY_BLIT_MAX_RECTANGLES (16)
+
+// Only the pixels inside of the rectangles are copied to the screen.
 struct IOCallDisplayBlitArgs
 {
     uint32_t *buffer;
     int buffer_width;
     int buffer_height;
 
-    int blit_x;
-    int blit_y;
-    int blit_width;
-    int blit_height;
+    int blit_count;
+    IOCallDisplayBlitRectangle blit_rectangles[IOCALL_DISPLAY_BLIT_MAX_RECTANGLES];
+};
+
+// The pixels of the display as a memory object to pass to memory_include(),
+// in the BGRA layout. When there is more than one page the display can flip
+// between them, page n starts at n * height * pitch.
+struct IOCallDisplayMapArgs
+{
+    int handle;
+    int width;
+    int height;
+    int pitch;
+    int pages;
+};
+
+struct IOCallDisplayFlipArgs
+{
+    int page;
 };
 
 struct IOCallKeyboardSetKeymapArgs
@@ -32,6 +58,11 @@ struct IOCallKeyboardSetKeymapArgs
     size_t size;
 };
 
+struct IOCallPipeCapacityArgs
+{
+    size_t capacity;
+};
+
 struct IOCallTextModeStateArgs
 {
     int width;
@@ -48,6 +79,8 @@ enum IOCall
     IOCALL_DISPLAY_GET_MODE,
     IOCALL_DISPLAY_SET_MODE,
     IOCALL_DISPLAY_BLIT,
+    IOCALL_DISPLAY_MAP,
+    IOCALL_DISPLAY_FLIP,
 
     IOCALL_KEYBOARD_SET_KEYMAP,
     IOCALL_KEYBOARD_GET_KEYMAP,
@@ -55,5 +88,8 @@ enum IOCall
     IOCALL_TEXTMODE_GET_STATE,
     IOCALL_TEXTMODE_SET_STATE,
 
+    IOCALL_PIPE_GET_CAPACITY,
+    IOCALL_PIPE_SET_CAPACITY,
+
     __IOCALL_COUNT,
 };
@@ -15,3 +15,5 @@
 #define SERIAL_DEVICE_PATH DEVICE_PATH "/serial"
 
 #define UNIX_DEVICE_PATH(__device) DEVICE_PATH "/" __device
+
+#define VOLUMES_PATH "/Volumes"
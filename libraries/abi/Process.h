@@ -4,3 +4,11 @@
 #define PROCESS_STACK_SIZE 16384
 #define PROCESS_ARG_COUNT 128
 #define PROCESS_HANDLE_COUNT 128
+
+// Lower values are scheduled first.
+#define PROCESS_PRIORITY_HIGHEST 0
+#define PROCESS_PRIORITY_HIGH 2
+#define PROCESS_PRIORITY_DEFAULT 4
+#define PROCESS_PRIORITY_LOW 6
+#define PROCESS_PRIORITY_LOWEST 7
+#define PROCESS_PRIORITY_COUNT 8
@@ -9,6 +9,7 @@
     __ENTRY(SYS_PROCESS_WAIT)          \
     __ENTRY(SYS_PROCESS_GET_DIRECTORY) \
     __ENTRY(SYS_PROCESS_SET_DIRECTORY) \
+    __ENTRY(SYS_PROCESS_SET_PRIORITY)  \
                                        \
     __ENTRY(SYS_MEMORY_ALLOC)          \
     __ENTRY(SYS_MEMORY_FREE)           \
@@ -30,17 +31,26 @@
     __ENTRY(SYS_HANDLE_OPEN)           \
     __ENTRY(SYS_HANDLE_CLOSE)          \
     __ENTRY(SYS_HANDLE_SELECT)         \
+    __ENTRY(SYS_HANDLE_POLL_CONTROL)   \
+    __ENTRY(SYS_HANDLE_POLL_WAIT)      \
     __ENTRY(SYS_HANDLE_READ)           \
     __ENTRY(SYS_HANDLE_WRITE)          \
+    __ENTRY(SYS_HANDLE_READV)          \
+    __ENTRY(SYS_HANDLE_WRITEV)         \
+    __ENTRY(SYS_HANDLE_PREAD)          \
+    __ENTRY(SYS_HANDLE_PWRITE)         \
+    __ENTRY(SYS_HANDLE_SPLICE)         \
     __ENTRY(SYS_HANDLE_CALL)           \
     __ENTRY(SYS_HANDLE_SEEK)           \
     __ENTRY(SYS_HANDLE_TELL)           \
     __ENTRY(SYS_HANDLE_STAT)           \
+    __ENTRY(SYS_HANDLE_MAP)            \
     __ENTRY(SYS_HANDLE_CONNECT)        \
     __ENTRY(SYS_HANDLE_ACCEPT)         \
                                        \
     __ENTRY(SYS_CREATE_PIPE)           \
-    __ENTRY(SYS_CREATE_TERM)
+    __ENTRY(SYS_CREATE_TERM)           \
+    __ENTRY(SYS_CREATE_POLL)
 
 #define SYSCALL_ENUM_ENTRY(__entry) __entry,
 
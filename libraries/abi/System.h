@@ -18,6 +18,13 @@ struct SystemStatus
     ElapsedTime uptime;
     size_t total_ram;
     size_t used_ram;
+    size_t largest_free_ram; // The biggest contiguous block of free physical memory
+    size_t free_ram_blocks;  // The number of free blocks, the higher the more fragmented
     int running_tasks;
     int cpu_usage;
+
+    size_t launch_count;             // Processes launched since boot
+    size_t launch_cache_hits;        // Launches that reused an already loaded executable
+    size_t launch_cold_average_time; // In microseconds
+    size_t launch_cached_average_time;
 };
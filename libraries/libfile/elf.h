@@ -13,6 +13,10 @@
 #define ELF_REL 1
 #define ELF_EXEC 2
 
+#define ELF_PROGRAM_EXECUTE (1 << 0)
+#define ELF_PROGRAM_WRITE (1 << 1)
+#define ELF_PROGRAM_READ (1 << 2)
+
 typedef unsigned int elf_type_t;
 
 struct __packed ELFHeader
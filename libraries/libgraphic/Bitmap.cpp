@@ -31,7 +31,7 @@ ResultOr<RefPtr<Bitmap>> Bitmap::create_shared(int width, int height)
     int handle = -1;
     memory_get_handle(reinterpret_cast<uintptr_t>(pixels), &handle);
 
-    return make<Bitmap>(handle, BITMAP_SHARED, width, height, pixels);
+    return make<Bitmap>(handle, BITMAP_SHARED, width, height, pixels, BITMAP_ALPHA_PREMULTIPLIED);
 }
 
 ResultOr<RefPtr<Bitmap>> Bitmap::create_shared_from_handle(int handle, Vec2i width_and_height)
@@ -51,19 +51,19 @@ ResultOr<RefPtr<Bitmap>> Bitmap::create_shared_from_handle(int handle, Vec2i wid
 
     memory_get_handle(reinterpret_cast<uintptr_t>(pixels), &handle);
 
-    return make<Bitmap>(handle, BITMAP_SHARED, width_and_height.x(), width_and_height.y(), pixels);
+    return make<Bitmap>(handle, BITMAP_SHARED, width_and_height.x(), width_and_height.y(), pixels, BITMAP_ALPHA_PREMULTIPLIED);
 }
 
-RefPtr<Bitmap> Bitmap::create_static(int width, int height, Color *pixels)
+RefPtr<Bitmap> Bitmap::create_static(int width, int height, Color *pixels, BitmapAlpha alpha)
 {
-    return make<Bitmap>(-1, BITMAP_STATIC, width, height, pixels);
+    return make<Bitmap>(-1, BITMAP_STATIC, width, height, pixels, alpha);
 }
 
 ResultOr<RefPtr<Bitmap>> Bitmap::load_from(const char *path)
 {
-    void *rawdata;
+    const void *rawdata;
     size_t rawdata_size;
-    Result result = file_read_all(path, &rawdata, &rawdata_size);
+    Result result = file_map_all(path, &rawdata, &rawdata_size);
 
     if (result != SUCCESS)
     {
@@ -81,6 +81,8 @@ ResultOr<RefPtr<Bitmap>> Bitmap::load_from(const char *path)
         (const unsigned char *)rawdata,
         rawdata_size);
 
+    memory_free((uintptr_t)rawdata);
+
     if (decode_result != 0)
     {
         return ERR_BAD_IMAGE_FILE_FORMAT;
@@ -91,7 +93,7 @@ ResultOr<RefPtr<Bitmap>> Bitmap::load_from(const char *path)
     if (bitmap_or_result.success())
     {
         auto bitmap = bitmap_or_result.take_value();
-        memcpy(bitmap->pixels(), decoded_data, sizeof(Color) * decoded_width * decoded_height);
+        pixels_premultiply(bitmap->pixels(), (const Color *)decoded_data, decoded_width * decoded_height);
         free(decoded_data);
         return bitmap;
     }
@@ -117,13 +119,23 @@ RefPtr<Bitmap> Bitmap::load_from_or_placeholder(const char *path)
 Result Bitmap::save_to(const char *path)
 {
     void *outbuffer __cleanup_malloc = nullptr;
+    Color *straight_pixels __cleanup_malloc = nullptr;
+
+    const Color *pixels = _pixels;
+
+    if (premultiplied())
+    {
+        straight_pixels = (Color *)malloc(sizeof(Color) * _width * _height);
+        pixels_unpremultiply(straight_pixels, _pixels, _width * _height);
+        pixels = straight_pixels;
+    }
 
     size_t outbuffer_size = 0;
 
     int err = lodepng_encode_memory(
         (unsigned char **)&outbuffer,
         &outbuffer_size,
-        (const unsigned char *)_pixels,
+        (const unsigned char *)pixels,
         _width,
         _height,
         LCT_RGBA, 8);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <libgraphic/Color.h>
+#include <libgraphic/Pixels.h>
 #include <libgraphic/Shape.h>
 #include <libsystem/Result.h>
 #include <libsystem/math/Math.h>
@@ -21,6 +22,14 @@ enum BitmapFiltering
     BITMAP_FILTERING_LINEAR,
 };
 
+// Shared and loaded bitmaps store premultiplied pixels, conversions only
+// happen when loading or saving them.
+enum BitmapAlpha
+{
+    BITMAP_ALPHA_STRAIGHT,
+    BITMAP_ALPHA_PREMULTIPLIED,
+};
+
 class Bitmap : public RefCounted<Bitmap>
 {
 private:
@@ -29,18 +38,20 @@ private:
     int _width;
     int _height;
     BitmapFiltering _filtering;
+    BitmapAlpha _alpha;
     Color *_pixels;
 
     __noncopyable(Bitmap);
     __nonmovable(Bitmap);
 
 public:
-    Bitmap(int handle, BitmapStorage storage, int width, int height, Color *pixels)
+    Bitmap(int handle, BitmapStorage storage, int width, int height, Color *pixels, BitmapAlpha alpha)
         : _handle(handle),
           _storage(storage),
           _width(width),
           _height(height),
           _filtering(BITMAP_FILTERING_LINEAR),
+          _alpha(alpha),
           _pixels(pixels)
     {
     }
@@ -57,12 +68,14 @@ public:
     int height() const { return _height; }
     Vec2i size() const { return Vec2i(_width, _height); }
     Rectangle bound() const { return Rectangle(_width, _height); }
+    BitmapAlpha alpha() const { return _alpha; }
+    bool premultiplied() const { return _alpha == BITMAP_ALPHA_PREMULTIPLIED; }
 
     static ResultOr<RefPtr<Bitmap>> create_shared(int width, int height);
 
     static ResultOr<RefPtr<Bitmap>> create_shared_from_handle(int handle, Vec2i width_and_height);
 
-    static RefPtr<Bitmap> create_static(int width, int height, Color *pixels);
+    static RefPtr<Bitmap> create_static(int width, int height, Color *pixels, BitmapAlpha alpha = BITMAP_ALPHA_STRAIGHT);
 
     static ResultOr<RefPtr<Bitmap>> load_from(const char *path);
 
@@ -70,6 +83,18 @@ public:
 
     Result save_to(const char *path);
 
+    // Colors are straight everywhere else, get_pixel() and set_pixel()
+    // work with pixels as they are stored.
+    Color color_to_storage(Color color)
+    {
+        return premultiplied() ? color_premultiply(color) : color;
+    }
+
+    Color color_from_storage(Color color)
+    {
+        return premultiplied() ? color_unpremultiply(color) : color;
+    }
+
     void set_pixel(Vec2i position, Color color)
     {
         if (bound().containe(position))
@@ -83,14 +108,24 @@ public:
 
     void blend_pixel(Vec2i position, Color color)
     {
-        Color background = get_pixel(position);
-        set_pixel(position, color_blend(color, background));
+        if (bound().containe(position))
+        {
+            blend_pixel_no_check(position, color);
+        }
     }
 
     void blend_pixel_no_check(Vec2i position, Color color)
     {
         Color background = get_pixel_no_check(position);
-        set_pixel_no_check(position, color_blend(color, background));
+
+        if (premultiplied())
+        {
+            set_pixel_no_check(position, color_blend_premultiplied(color_premultiply(color), background));
+        }
+        else
+        {
+            set_pixel_no_check(position, color_blend(color, background));
+        }
     }
 
     Color get_pixel(Vec2i position)
@@ -141,10 +176,10 @@ public:
 
         for (int y = region.y(); y < region.y() + region.height(); y++)
         {
-            for (int x = region.x(); x < region.x() + region.width(); x++)
-            {
-                set_pixel_no_check(Vec2i(x, y), source.get_pixel_no_check(Vec2i(x, y)));
-            }
+            pixels_copy(
+                _pixels + y * width() + region.x(),
+                source._pixels + y * source.width() + region.x(),
+                region.width());
         }
     }
 };
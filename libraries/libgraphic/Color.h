@@ -1,6 +1,7 @@
 #pragma once
 
 #include <libsystem/Common.h>
+#include <libsystem/math/MinMax.h>
 
 union Color
 {
@@ -56,6 +57,51 @@ static __always_inline Color color_blend(Color fg, Color bg)
     return RGBA(r01, g01, b01, a01);
 }
 
+// Premultiplied colors have R, G and B already scaled by A, blending them
+// is exact integer math without any division by the resulting alpha.
+
+static __always_inline uint8_t color_multiply(uint8_t a, uint8_t b)
+{
+    return (a * b + 127) / 255;
+}
+
+static __always_inline Color color_premultiply(Color color)
+{
+    return (Color){{
+        color_multiply(color.R, color.A),
+        color_multiply(color.G, color.A),
+        color_multiply(color.B, color.A),
+        color.A,
+    }};
+}
+
+static __always_inline Color color_unpremultiply(Color color)
+{
+    if (color.A == 0)
+    {
+        return (Color){{0, 0, 0, 0}};
+    }
+
+    return (Color){{
+        (uint8_t)MIN(255, (color.R * 255 + color.A / 2) / color.A),
+        (uint8_t)MIN(255, (color.G * 255 + color.A / 2) / color.A),
+        (uint8_t)MIN(255, (color.B * 255 + color.A / 2) / color.A),
+        color.A,
+    }};
+}
+
+static __always_inline Color color_blend_premultiplied(Color fg, Color bg)
+{
+    uint8_t remaining = 255 - fg.A;
+
+    return (Color){{
+        (uint8_t)(fg.R + color_multiply(bg.R, remaining)),
+        (uint8_t)(fg.G + color_multiply(bg.G, remaining)),
+        (uint8_t)(fg.B + color_multiply(bg.B, remaining)),
+        (uint8_t)(fg.A + color_multiply(bg.A, remaining)),
+    }};
+}
+
 #define COLOR(__value) ((Color){{(uint8_t)((__value) >> 16), (uint8_t)((__value) >> 8), (uint8_t)((__value)), 255}})
 
 #define COLOR_RGBA(__R, __G, __B, __A) ((Color){{(uint8_t)(__R), (uint8_t)(__G), (uint8_t)(__B), (uint8_t)(__A)}})
@@ -3,9 +3,11 @@
 #include <abi/Paths.h>
 
 #include <libgraphic/Framebuffer.h>
+#include <libgraphic/Pixels.h>
 #include <libsystem/Logger.h>
 #include <libsystem/Result.h>
 #include <libsystem/core/Plugs.h>
+#include <libsystem/system/Memory.h>
 
 ResultOr<OwnPtr<Framebuffer>> Framebuffer::open()
 {
@@ -40,13 +42,69 @@ Framebuffer::Framebuffer(Handle handle, RefPtr<Bitmap> bitmap)
       _bitmap(bitmap),
       _painter(bitmap)
 {
+    remap();
 }
 
 Framebuffer::~Framebuffer()
 {
+    unmap();
     __plug_handle_close(&_handle);
 }
 
+Result Framebuffer::map()
+{
+    IOCallDisplayMapArgs map_info = {};
+    __plug_handle_call(&_handle, IOCALL_DISPLAY_MAP, &map_info);
+
+    if (handle_has_error(&_handle))
+    {
+        return handle_get_error(&_handle);
+    }
+
+    if (map_info.width != _bitmap->width() || map_info.height != _bitmap->height())
+    {
+        return ERR_INVALID_ARGUMENT;
+    }
+
+    uintptr_t address = 0;
+    size_t size = 0;
+
+    Result result = memory_include(map_info.handle, &address, &size);
+
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    _mapping = reinterpret_cast<uint8_t *>(address);
+    _mapping_pitch = map_info.pitch;
+    _mapping_pages = map_info.pages;
+    _mapping_page = 0;
+
+    _previous_dirty_region = _bitmap->bound();
+
+    return SUCCESS;
+}
+
+void Framebuffer::unmap()
+{
+    if (_mapping)
+    {
+        memory_free(reinterpret_cast<uintptr_t>(_mapping));
+        _mapping = nullptr;
+    }
+}
+
+void Framebuffer::remap()
+{
+    unmap();
+
+    if (map() != SUCCESS)
+    {
+        logger_warn("Failled to map " FRAMEBUFFER_DEVICE_PATH ", falling back to IOCALL_DISPLAY_BLIT");
+    }
+}
+
 Result Framebuffer::set_resolution(Vec2i size)
 {
     auto bitmap_or_result = Bitmap::create_shared(size.x(), size.y());
@@ -68,55 +126,105 @@ Result Framebuffer::set_resolution(Vec2i size)
     _bitmap = bitmap_or_result.take_value();
     _painter = Painter(_bitmap);
 
+    remap();
+
     return SUCCESS;
 }
 
-void Framebuffer::mark_dirty(Rectangle bound)
+void Framebuffer::mark_dirty(Region region)
+{
+    _dirty_region = _dirty_region.unite(region.intersect(_bitmap->bound()));
+}
+
+void Framebuffer::mark_dirty_all()
 {
-    bound = _bitmap->bound().clipped_with(bound);
+    _dirty_region = _bitmap->bound();
+}
 
-    if (bound.is_empty())
+void Framebuffer::blit()
+{
+    if (_dirty_region.is_empty())
     {
         return;
     }
 
-    if (_bitmap->bound().colide_with(bound))
+    if (_mapping)
+    {
+        blit_mapped();
+    }
+    else
+    {
+        blit_iocall();
+    }
+
+    _dirty_region = Region::empty();
+}
+
+void Framebuffer::blit_mapped()
+{
+    int page = (_mapping_page + 1) % _mapping_pages;
+
+    Region region = _dirty_region;
+
+    if (_mapping_pages > 1)
     {
-        if (_is_dirty)
+        region = region.unite(_previous_dirty_region);
+    }
+
+    uint8_t *destination = _mapping + page * _bitmap->height() * _mapping_pitch;
+
+    region.foreach ([&](Rectangle rectangle) {
+        for (int y = rectangle.y(); y < rectangle.y() + rectangle.height(); y++)
         {
-            _dirty_bound = _dirty_bound.merged_with(bound);
+            pixels_copy_bgra(
+                reinterpret_cast<uint32_t *>(destination + y * _mapping_pitch) + rectangle.x(),
+                _bitmap->pixels() + y * _bitmap->width() + rectangle.x(),
+                rectangle.width());
+        }
+
+        return Iteration::CONTINUE;
+    });
+
+    if (_mapping_pages > 1)
+    {
+        IOCallDisplayFlipArgs flip = {page};
+        __plug_handle_call(&_handle, IOCALL_DISPLAY_FLIP, &flip);
+
+        if (handle_has_error(&_handle))
+        {
+            handle_printf_error(&_handle, "Failled to iocall device " FRAMEBUFFER_DEVICE_PATH);
         }
         else
         {
-            _is_dirty = true;
-            _dirty_bound = _bitmap->bound().clipped_with(bound);
+            _mapping_page = page;
         }
     }
-}
 
-void Framebuffer::mark_dirty_all()
-{
-    _is_dirty = true;
-    _dirty_bound = _bitmap->bound();
+    _previous_dirty_region = _dirty_region;
 }
 
-void Framebuffer::blit()
+void Framebuffer::blit_iocall()
 {
-    if (_dirty_bound.is_empty())
-    {
-        return;
-    }
-
     IOCallDisplayBlitArgs args;
 
     args.buffer = (uint32_t *)_bitmap->pixels();
     args.buffer_width = _bitmap->width();
     args.buffer_height = _bitmap->height();
 
-    args.blit_x = _dirty_bound.x();
-    args.blit_y = _dirty_bound.y();
-    args.blit_width = _dirty_bound.width();
-    args.blit_height = _dirty_bound.height();
+    args.blit_count = 0;
+
+    _dirty_region.foreach ([&](Rectangle rectangle) {
+        args.blit_rectangles[args.blit_count] = {
+            rectangle.x(),
+            rectangle.y(),
+            rectangle.width(),
+            rectangle.height(),
+        };
+
+        args.blit_count++;
+
+        return Iteration::CONTINUE;
+    });
 
     __plug_handle_call(&_handle, IOCALL_DISPLAY_BLIT, &args);
 
@@ -124,6 +232,4 @@ void Framebuffer::blit()
     {
         handle_printf_error(&_handle, "Failled to iocall device " FRAMEBUFFER_DEVICE_PATH);
     }
-
-    _is_dirty = false;
 }
@@ -13,8 +13,29 @@ private:
     RefPtr<Bitmap> _bitmap;
     Painter _painter;
 
-    bool _is_dirty = false;
-    Rectangle _dirty_bound = Rectangle::empty();
+    // Set when the display memory could be mapped, the dirty pixels are then
+    // copied here instead of going through IOCALL_DISPLAY_BLIT.
+    uint8_t *_mapping = nullptr;
+    int _mapping_pitch = 0;
+    int _mapping_pages = 1;
+    int _mapping_page = 0;
+
+    Region _dirty_region = Region::empty();
+
+    // The page we draw to is one frame behind the screen, it misses what
+    // changed during the last frame.
+    Region _previous_dirty_region = Region::empty();
+
+    Result map();
+
+    void unmap();
+
+    // Map the display again after a mode switch, the blit iocall is used if it fails.
+    void remap();
+
+    void blit_mapped();
+
+    void blit_iocall();
 
 public:
     Painter &painter() { return _painter; }
@@ -29,7 +50,7 @@ public:
 
     Result set_resolution(Vec2i size);
 
-    void mark_dirty(Rectangle rectangle);
+    void mark_dirty(Region region);
 
     void mark_dirty_all();
 
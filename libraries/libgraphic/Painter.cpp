@@ -1,5 +1,6 @@
 #include <libgraphic/Font.h>
 #include <libgraphic/Painter.h>
+#include <libgraphic/Pixels.h>
 #include <libgraphic/StackBlur.h>
 #include <libsystem/Assert.h>
 #include <libsystem/math/Math.h>
@@ -72,26 +73,67 @@ void Painter::plot_pixel(Vec2i position, Color color)
     }
 }
 
-void Painter::blit_bitmap_fast(Bitmap &bitmap, Rectangle source, Rectangle destination)
+bool Painter::apply_blit_clip(Bitmap &bitmap, Rectangle &source, Rectangle &destination)
 {
-    Rectangle clipped_destination = apply_transform(destination);
-    clipped_destination = apply_clip(clipped_destination);
+    Rectangle transformed_destination = apply_transform(destination);
+    Rectangle clipped_destination = apply_clip(transformed_destination);
+
+    if (clipped_destination.is_empty())
+    {
+        return false;
+    }
 
     Rectangle clipped_source = Rectangle(clipped_destination.width(), clipped_destination.height());
-    clipped_source = clipped_source.moved(source.position() + clipped_destination.position() - destination.position());
+    clipped_source = clipped_source.moved(source.position() + clipped_destination.position() - transformed_destination.position());
 
-    if (clipped_destination.is_empty())
+    // The pixels outside of the source bitmap are left alone.
+    if (!clipped_source.colide_with(bitmap.bound()))
+    {
+        return false;
+    }
+
+    Rectangle visible_source = clipped_source.clipped_with(bitmap.bound());
+
+    source = visible_source;
+    destination = visible_source.offset(clipped_destination.position() - clipped_source.position());
+
+    return true;
+}
+
+void Painter::blit_bitmap_fast(Bitmap &bitmap, Rectangle source, Rectangle destination)
+{
+    if (!apply_blit_clip(bitmap, source, destination))
+    {
         return;
+    }
 
-    for (int x = 0; x < clipped_destination.width(); x++)
+    if (bitmap.alpha() != _bitmap->alpha())
     {
-        for (int y = 0; y < clipped_destination.height(); y++)
+        for (int y = 0; y < destination.height(); y++)
         {
-            Vec2i position(x, y);
+            for (int x = 0; x < destination.width(); x++)
+            {
+                Color sample = bitmap.get_pixel_no_check(source.position() + Vec2i(x, y));
+
+                _bitmap->blend_pixel_no_check(destination.position() + Vec2i(x, y), bitmap.color_from_storage(sample));
+            }
+        }
 
-            Color sample = bitmap.get_pixel(clipped_source.position() + position);
+        return;
+    }
+
+    for (int y = 0; y < destination.height(); y++)
+    {
+        Color *destination_row = _bitmap->pixels() + (destination.y() + y) * _bitmap->width() + destination.x();
+        Color *source_row = bitmap.pixels() + (source.y() + y) * bitmap.width() + source.x();
 
-            _bitmap->blend_pixel(clipped_destination.position() + position, sample);
+        if (_bitmap->premultiplied())
+        {
+            pixels_blend_premultiplied(destination_row, source_row, destination.width());
+        }
+        else
+        {
+            pixels_blend(destination_row, source_row, destination.width());
         }
     }
 }
@@ -109,7 +151,7 @@ void Painter::blit_bitmap_scaled(Bitmap &bitmap, Rectangle source, Rectangle des
             float yy = y / (float)destination.height();
 
             Color sample = bitmap.sample(source, Vec2f(xx, yy));
-            plot_pixel(destination.position() + Vec2i(x, y), sample);
+            plot_pixel(destination.position() + Vec2i(x, y), bitmap.color_from_storage(sample));
         }
     }
 }
@@ -132,27 +174,17 @@ __flatten void Painter::blit_bitmap(Bitmap &bitmap, Rectangle source, Rectangle
 
 void Painter::blit_bitmap_fast_no_alpha(Bitmap &bitmap, Rectangle source, Rectangle destination)
 {
-    Rectangle clipped_destination = apply_transform(destination);
-    clipped_destination = apply_clip(clipped_destination);
-
-    Rectangle clipped_source = Rectangle(clipped_destination.width(), clipped_destination.height());
-    clipped_source = clipped_source.moved(source.position() + clipped_destination.position() - destination.position());
-
-    if (clipped_destination.is_empty())
+    if (!apply_blit_clip(bitmap, source, destination))
+    {
         return;
+    }
 
-    for (int x = 0; x < clipped_destination.width(); x++)
+    for (int y = 0; y < destination.height(); y++)
     {
-        for (int y = 0; y < clipped_destination.height(); y++)
-        {
-            Vec2i position(x, y);
-
-            Color sample = bitmap.get_pixel(clipped_source.position() + position);
-
-            sample.A = 255;
-
-            _bitmap->set_pixel_no_check(clipped_destination.position() + position, sample);
-        }
+        pixels_copy_opaque(
+            _bitmap->pixels() + (destination.y() + y) * _bitmap->width() + destination.x(),
+            bitmap.pixels() + (source.y() + y) * bitmap.width() + source.x(),
+            destination.width());
     }
 }
 
@@ -166,7 +198,7 @@ void Painter::blit_bitmap_scaled_no_alpha(Bitmap &bitmap, Rectangle source, Rect
             float yy = y / (float)destination.height();
 
             Color sample = bitmap.sample(source, Vec2f(xx, yy));
-            plot_pixel(destination.position() + Vec2i(x, y), sample);
+            plot_pixel(destination.position() + Vec2i(x, y), bitmap.color_from_storage(sample));
         }
     }
 }
@@ -199,12 +231,12 @@ __flatten void Painter::clear_rectangle(Rectangle rectangle, Color color)
         return;
     }
 
-    for (int x = 0; x < rectangle.width(); x++)
+    for (int y = 0; y < rectangle.height(); y++)
     {
-        for (int y = 0; y < rectangle.height(); y++)
-        {
-            _bitmap->set_pixel_no_check(Vec2i(rectangle.x() + x, rectangle.y() + y), color);
-        }
+        pixels_fill(
+            _bitmap->pixels() + (rectangle.y() + y) * _bitmap->width() + rectangle.x(),
+            _bitmap->color_to_storage(color),
+            rectangle.width());
     }
 }
 
@@ -218,12 +250,17 @@ __flatten void Painter::fill_rectangle(Rectangle rectangle, Color color)
         return;
     }
 
-    for (int x = 0; x < rectangle.width(); x++)
+    for (int y = 0; y < rectangle.height(); y++)
     {
-        for (int y = 0; y < rectangle.height(); y++)
+        Color *row = _bitmap->pixels() + (rectangle.y() + y) * _bitmap->width() + rectangle.x();
+
+        if (_bitmap->premultiplied())
+        {
+            pixels_blend_color_premultiplied(row, color_premultiply(color), rectangle.width());
+        }
+        else
         {
-            _bitmap->blend_pixel_no_check(Vec2i(rectangle.x() + x, rectangle.y() + y),
-                                          color);
+            pixels_blend_color(row, color, rectangle.width());
         }
     }
 }
@@ -595,10 +632,40 @@ __flatten void Painter::draw_rounded_rectangle(Rectangle bound, int radius, int
     fill_rectangle(bound.cutoff_left_and_right(radius, radius).take_bottom(thickness), color);
 }
 
+bool Painter::blit_coverage(Bitmap &mask, int channel, Rectangle source, Rectangle destination, Color color)
+{
+    if (!_bitmap->premultiplied() || source.size() != destination.size())
+    {
+        return false;
+    }
+
+    if (!apply_blit_clip(mask, source, destination))
+    {
+        return true;
+    }
+
+    for (int y = 0; y < destination.height(); y++)
+    {
+        pixels_blend_coverage(
+            _bitmap->pixels() + (destination.y() + y) * _bitmap->width() + destination.x(),
+            mask.pixels() + (source.y() + y) * mask.width() + source.x(),
+            channel,
+            color,
+            destination.width());
+    }
+
+    return true;
+}
+
 __flatten void Painter::blit_icon(Icon &icon, IconSize size, Rectangle destination, Color color)
 {
     Bitmap &bitmap = *icon.bitmap(size);
 
+    if (blit_coverage(bitmap, 3, bitmap.bound(), destination, color))
+    {
+        return;
+    }
+
     for (int x = 0; x < destination.width(); x++)
     {
         for (int y = 0; y < destination.height(); y++)
@@ -632,6 +699,12 @@ __flatten void Painter::blur_rectangle(Rectangle rectangle, int radius)
 
 __flatten void Painter::blit_bitmap_colored(Bitmap &bitmap, Rectangle source, Rectangle destination, Color color)
 {
+    // Glyphs store their coverage in the red channel.
+    if (blit_coverage(bitmap, 0, source, destination, color))
+    {
+        return;
+    }
+
     for (int x = 0; x < destination.width(); x++)
     {
         for (int y = 0; y < destination.height(); y++)
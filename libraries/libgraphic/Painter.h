@@ -86,6 +86,12 @@ private:
 
     Rectangle apply_transform(Rectangle rectangle);
 
+    // Clip both sides of a 1:1 blit, false if there is nothing left to draw.
+    bool apply_blit_clip(Bitmap &bitmap, Rectangle &source, Rectangle &destination);
+
+    // 1:1 blit of a color through one channel of a mask, false if the slow path has to be taken.
+    bool blit_coverage(Bitmap &mask, int channel, Rectangle source, Rectangle destination, Color color);
+
     void blit_bitmap_fast(Bitmap &bitmap, Rectangle source, Rectangle destination);
 
     void blit_bitmap_scaled(Bitmap &bitmap, Rectangle source, Rectangle destination);
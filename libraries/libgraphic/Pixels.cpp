@@ -0,0 +1,566 @@
+#include <emmintrin.h>
+
+#include <libgraphic/Pixels.h>
+#include <libsystem/core/CString.h>
+
+/* --- Scalar kernels ------------------------------------------------------- */
+
+static void pixels_copy_scalar(Color *destination, const Color *source, size_t count)
+{
+    memcpy(destination, source, count * sizeof(Color));
+}
+
+static void pixels_copy_opaque_scalar(Color *destination, const Color *source, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        destination[i].packed = source[i].packed | 0xff000000;
+    }
+}
+
+static void pixels_fill_scalar(Color *destination, Color color, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        destination[i] = color;
+    }
+}
+
+static void pixels_blend_scalar(Color *destination, const Color *source, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (source[i].A == 255)
+        {
+            destination[i] = source[i];
+        }
+        else if (source[i].A != 0)
+        {
+            destination[i] = color_blend(source[i], destination[i]);
+        }
+    }
+}
+
+static void pixels_blend_color_scalar(Color *destination, Color color, size_t count)
+{
+    if (color.A == 255)
+    {
+        pixels_fill_scalar(destination, color, count);
+    }
+    else if (color.A != 0)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            destination[i] = color_blend(color, destination[i]);
+        }
+    }
+}
+
+static void pixels_blend_premultiplied_scalar(Color *destination, const Color *source, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        if (source[i].A == 255)
+        {
+            destination[i] = source[i];
+        }
+        else if (source[i].packed != 0)
+        {
+            destination[i] = color_blend_premultiplied(source[i], destination[i]);
+        }
+    }
+}
+
+static void pixels_blend_color_premultiplied_scalar(Color *destination, Color color, size_t count)
+{
+    if (color.A == 255)
+    {
+        pixels_fill_scalar(destination, color, count);
+    }
+    else if (color.packed != 0)
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            destination[i] = color_blend_premultiplied(color, destination[i]);
+        }
+    }
+}
+
+static void pixels_premultiply_scalar(Color *destination, const Color *source, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        destination[i] = color_premultiply(source[i]);
+    }
+}
+
+static void pixels_copy_bgra_scalar(uint32_t *destination, const Color *source, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        uint32_t pixel = source[i].packed;
+
+        destination[i] = ((pixel >> 16) & 0x000000ff) |
+                         ((pixel)&0xff00ff00) |
+                         ((pixel << 16) & 0x00ff0000);
+    }
+}
+
+/* --- SSE2 kernels --------------------------------------------------------- */
+
+// The toolchain targets plain i686, so the SSE2 kernels are compiled for SSE2
+// on their own and only picked at runtime once CPUID reports support for it.
+#define PIXELS_SSE2 __attribute__((target("sse2")))
+
+// (pixels * factors + 127) / 255 on 16 bits lanes, exact for 8 bits inputs.
+static __always_inline PIXELS_SSE2 __m128i pixels_multiply8(__m128i pixels, __m128i factors)
+{
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i half = _mm_set1_epi16(127);
+
+    __m128i product = _mm_add_epi16(_mm_mullo_epi16(pixels, factors), half);
+
+    return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(product, one), _mm_srli_epi16(product, 8)), 8);
+}
+
+static __always_inline PIXELS_SSE2 __m128i pixels_broadcast_alpha8(__m128i pixels)
+{
+    return _mm_shufflehi_epi16(_mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+}
+
+// source + destination * (255 - source alpha) / 255, on premultiplied pixels.
+static __always_inline PIXELS_SSE2 __m128i pixels_blend4_premultiplied(__m128i source, __m128i destination)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i max = _mm_set1_epi16(255);
+
+    __m128i remaining_low = _mm_sub_epi16(max, pixels_broadcast_alpha8(_mm_unpacklo_epi8(source, zero)));
+    __m128i remaining_high = _mm_sub_epi16(max, pixels_broadcast_alpha8(_mm_unpackhi_epi8(source, zero)));
+
+    __m128i low = pixels_multiply8(_mm_unpacklo_epi8(destination, zero), remaining_low);
+    __m128i high = pixels_multiply8(_mm_unpackhi_epi8(destination, zero), remaining_high);
+
+    return _mm_adds_epu8(source, _mm_packus_epi16(low, high));
+}
+
+// Blend four pixels over an opaque background:
+//     result = (source * alpha + destination * (255 - alpha)) / 255
+// The channels are widened to 16 bits, the division by 255 is exact for
+// the range of values we get here.
+static __always_inline PIXELS_SSE2 __m128i pixels_blend4_over_opaque(__m128i source, __m128i destination)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i one = _mm_set1_epi16(1);
+    const __m128i max = _mm_set1_epi16(255);
+
+    __m128i source_low = _mm_unpacklo_epi8(source, zero);
+    __m128i source_high = _mm_unpackhi_epi8(source, zero);
+    __m128i destination_low = _mm_unpacklo_epi8(destination, zero);
+    __m128i destination_high = _mm_unpackhi_epi8(destination, zero);
+
+    __m128i alpha_low = pixels_broadcast_alpha8(source_low);
+    __m128i alpha_high = pixels_broadcast_alpha8(source_high);
+
+    __m128i low = _mm_add_epi16(
+        _mm_mullo_epi16(source_low, alpha_low),
+        _mm_mullo_epi16(destination_low, _mm_sub_epi16(max, alpha_low)));
+
+    __m128i high = _mm_add_epi16(
+        _mm_mullo_epi16(source_high, alpha_high),
+        _mm_mullo_epi16(destination_high, _mm_sub_epi16(max, alpha_high)));
+
+    low = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(low, one), _mm_srli_epi16(low, 8)), 8);
+    high = _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(high, one), _mm_srli_epi16(high, 8)), 8);
+
+    return _mm_or_si128(_mm_packus_epi16(low, high), _mm_set1_epi32(0xff000000));
+}
+
+static __always_inline PIXELS_SSE2 bool pixels_all_alpha(__m128i pixels, uint32_t alpha)
+{
+    const __m128i alpha_mask = _mm_set1_epi32(0xff000000);
+
+    __m128i masked = _mm_and_si128(pixels, alpha_mask);
+    __m128i expected = _mm_set1_epi32(alpha << 24);
+
+    return _mm_movemask_epi8(_mm_cmpeq_epi32(masked, expected)) == 0xffff;
+}
+
+static PIXELS_SSE2 void pixels_blend_premultiplied_sse2(Color *destination, const Color *source, size_t count)
+{
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i source_pixels = _mm_loadu_si128((const __m128i *)(source + i));
+
+        if (pixels_all_alpha(source_pixels, 255))
+        {
+            _mm_storeu_si128((__m128i *)(destination + i), source_pixels);
+            continue;
+        }
+
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(source_pixels, _mm_setzero_si128())) == 0xffff)
+        {
+            continue;
+        }
+
+        __m128i destination_pixels = _mm_loadu_si128((const __m128i *)(destination + i));
+
+        _mm_storeu_si128((__m128i *)(destination + i), pixels_blend4_premultiplied(source_pixels, destination_pixels));
+    }
+
+    pixels_blend_premultiplied_scalar(destination + i, source + i, count - i);
+}
+
+static PIXELS_SSE2 void pixels_premultiply_sse2(Color *destination, const Color *source, size_t count)
+{
+    const __m128i zero = _mm_setzero_si128();
+
+    // Keep the alpha channel as it is by multiplying it by 255.
+    const __m128i alpha_lanes = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i pixels = _mm_loadu_si128((const __m128i *)(source + i));
+
+        __m128i low = _mm_unpacklo_epi8(pixels, zero);
+        __m128i high = _mm_unpackhi_epi8(pixels, zero);
+
+        low = pixels_multiply8(low, _mm_or_si128(pixels_broadcast_alpha8(low), alpha_lanes));
+        high = pixels_multiply8(high, _mm_or_si128(pixels_broadcast_alpha8(high), alpha_lanes));
+
+        _mm_storeu_si128((__m128i *)(destination + i), _mm_packus_epi16(low, high));
+    }
+
+    pixels_premultiply_scalar(destination + i, source + i, count - i);
+}
+
+static PIXELS_SSE2 void pixels_copy_sse2(Color *destination, const Color *source, size_t count)
+{
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i first = _mm_loadu_si128((const __m128i *)(source + i));
+        __m128i second = _mm_loadu_si128((const __m128i *)(source + i + 4));
+
+        _mm_storeu_si128((__m128i *)(destination + i), first);
+        _mm_storeu_si128((__m128i *)(destination + i + 4), second);
+    }
+
+    pixels_copy_scalar(destination + i, source + i, count - i);
+}
+
+static PIXELS_SSE2 void pixels_copy_opaque_sse2(Color *destination, const Color *source, size_t count)
+{
+    const __m128i alpha_mask = _mm_set1_epi32(0xff000000);
+
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i first = _mm_loadu_si128((const __m128i *)(source + i));
+        __m128i second = _mm_loadu_si128((const __m128i *)(source + i + 4));
+
+        _mm_storeu_si128((__m128i *)(destination + i), _mm_or_si128(first, alpha_mask));
+        _mm_storeu_si128((__m128i *)(destination + i + 4), _mm_or_si128(second, alpha_mask));
+    }
+
+    pixels_copy_opaque_scalar(destination + i, source + i, count - i);
+}
+
+static __always_inline PIXELS_SSE2 __m128i pixels_swap_red_blue(__m128i pixels)
+{
+    const __m128i green_alpha_mask = _mm_set1_epi32(0xff00ff00);
+    const __m128i red_mask = _mm_set1_epi32(0x000000ff);
+
+    __m128i green_alpha = _mm_and_si128(pixels, green_alpha_mask);
+    __m128i red_blue = _mm_andnot_si128(green_alpha_mask, pixels);
+
+    // Swap the two bytes left in each pixel by rotating them by 16 bits.
+    __m128i swapped = _mm_or_si128(_mm_srli_epi32(red_blue, 16), _mm_slli_epi32(_mm_and_si128(red_blue, red_mask), 16));
+
+    return _mm_or_si128(green_alpha, swapped);
+}
+
+static PIXELS_SSE2 void pixels_copy_bgra_sse2(uint32_t *destination, const Color *source, size_t count)
+{
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        __m128i first = _mm_loadu_si128((const __m128i *)(source + i));
+        __m128i second = _mm_loadu_si128((const __m128i *)(source + i + 4));
+
+        _mm_storeu_si128((__m128i *)(destination + i), pixels_swap_red_blue(first));
+        _mm_storeu_si128((__m128i *)(destination + i + 4), pixels_swap_red_blue(second));
+    }
+
+    pixels_copy_bgra_scalar(destination + i, source + i, count - i);
+}
+
+static PIXELS_SSE2 void pixels_fill_sse2(Color *destination, Color color, size_t count)
+{
+    const __m128i pixels = _mm_set1_epi32(color.packed);
+
+    size_t i = 0;
+
+    for (; i + 8 <= count; i += 8)
+    {
+        _mm_storeu_si128((__m128i *)(destination + i), pixels);
+        _mm_storeu_si128((__m128i *)(destination + i + 4), pixels);
+    }
+
+    pixels_fill_scalar(destination + i, color, count - i);
+}
+
+static PIXELS_SSE2 void pixels_blend_sse2(Color *destination, const Color *source, size_t count)
+{
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i source_pixels = _mm_loadu_si128((const __m128i *)(source + i));
+
+        if (pixels_all_alpha(source_pixels, 255))
+        {
+            _mm_storeu_si128((__m128i *)(destination + i), source_pixels);
+            continue;
+        }
+
+        if (pixels_all_alpha(source_pixels, 0))
+        {
+            continue;
+        }
+
+        __m128i destination_pixels = _mm_loadu_si128((const __m128i *)(destination + i));
+
+        if (pixels_all_alpha(destination_pixels, 255))
+        {
+            _mm_storeu_si128((__m128i *)(destination + i), pixels_blend4_over_opaque(source_pixels, destination_pixels));
+        }
+        else
+        {
+            pixels_blend_scalar(destination + i, source + i, 4);
+        }
+    }
+
+    pixels_blend_scalar(destination + i, source + i, count - i);
+}
+
+static PIXELS_SSE2 void pixels_blend_color_sse2(Color *destination, Color color, size_t count)
+{
+    if (color.A == 255)
+    {
+        pixels_fill_sse2(destination, color, count);
+        return;
+    }
+
+    if (color.A == 0)
+    {
+        return;
+    }
+
+    const __m128i source_pixels = _mm_set1_epi32(color.packed);
+
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i destination_pixels = _mm_loadu_si128((const __m128i *)(destination + i));
+
+        if (pixels_all_alpha(destination_pixels, 255))
+        {
+            _mm_storeu_si128((__m128i *)(destination + i), pixels_blend4_over_opaque(source_pixels, destination_pixels));
+        }
+        else
+        {
+            pixels_blend_color_scalar(destination + i, color, 4);
+        }
+    }
+
+    pixels_blend_color_scalar(destination + i, color, count - i);
+}
+
+static PIXELS_SSE2 void pixels_blend_color_premultiplied_sse2(Color *destination, Color color, size_t count)
+{
+    if (color.A == 255)
+    {
+        pixels_fill_sse2(destination, color, count);
+        return;
+    }
+
+    if (color.packed == 0)
+    {
+        return;
+    }
+
+    const __m128i source_pixels = _mm_set1_epi32(color.packed);
+
+    size_t i = 0;
+
+    for (; i + 4 <= count; i += 4)
+    {
+        __m128i destination_pixels = _mm_loadu_si128((const __m128i *)(destination + i));
+
+        _mm_storeu_si128((__m128i *)(destination + i), pixels_blend4_premultiplied(source_pixels, destination_pixels));
+    }
+
+    pixels_blend_color_premultiplied_scalar(destination + i, color, count - i);
+}
+
+/* --- Dispatch ------------------------------------------------------------- */
+
+struct PixelsKernels
+{
+    void (*copy)(Color *destination, const Color *source, size_t count);
+    void (*copy_opaque)(Color *destination, const Color *source, size_t count);
+    void (*fill)(Color *destination, Color color, size_t count);
+    void (*blend)(Color *destination, const Color *source, size_t count);
+    void (*blend_color)(Color *destination, Color color, size_t count);
+    void (*blend_premultiplied)(Color *destination, const Color *source, size_t count);
+    void (*blend_color_premultiplied)(Color *destination, Color color, size_t count);
+    void (*premultiply)(Color *destination, const Color *source, size_t count);
+    void (*copy_bgra)(uint32_t *destination, const Color *source, size_t count);
+};
+
+static const PixelsKernels _scalar_kernels = {
+    pixels_copy_scalar,
+    pixels_copy_opaque_scalar,
+    pixels_fill_scalar,
+    pixels_blend_scalar,
+    pixels_blend_color_scalar,
+    pixels_blend_premultiplied_scalar,
+    pixels_blend_color_premultiplied_scalar,
+    pixels_premultiply_scalar,
+    pixels_copy_bgra_scalar,
+};
+
+static const PixelsKernels _sse2_kernels = {
+    pixels_copy_sse2,
+    pixels_copy_opaque_sse2,
+    pixels_fill_sse2,
+    pixels_blend_sse2,
+    pixels_blend_color_sse2,
+    pixels_blend_premultiplied_sse2,
+    pixels_blend_color_premultiplied_sse2,
+    pixels_premultiply_sse2,
+    pixels_copy_bgra_sse2,
+};
+
+static const PixelsKernels *_kernels = nullptr;
+
+// Bit of EDX reported by CPUID leaf 1 when SSE2 is supported.
+#define PIXELS_CPUID_EDX_SSE2 (1 << 26)
+
+bool pixels_simd_available()
+{
+    uint32_t eax = 1;
+    uint32_t ebx, ecx, edx;
+
+    asm volatile("cpuid"
+                 : "+a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx));
+
+    return edx & PIXELS_CPUID_EDX_SSE2;
+}
+
+void pixels_use_simd(bool enable)
+{
+    if (enable && pixels_simd_available())
+    {
+        _kernels = &_sse2_kernels;
+    }
+    else
+    {
+        _kernels = &_scalar_kernels;
+    }
+}
+
+static const PixelsKernels &pixels_kernels()
+{
+    if (!_kernels)
+    {
+        pixels_use_simd(true);
+    }
+
+    return *_kernels;
+}
+
+void pixels_copy(Color *destination, const Color *source, size_t count)
+{
+    pixels_kernels().copy(destination, source, count);
+}
+
+void pixels_copy_opaque(Color *destination, const Color *source, size_t count)
+{
+    pixels_kernels().copy_opaque(destination, source, count);
+}
+
+void pixels_fill(Color *destination, Color color, size_t count)
+{
+    pixels_kernels().fill(destination, color, count);
+}
+
+void pixels_blend(Color *destination, const Color *source, size_t count)
+{
+    pixels_kernels().blend(destination, source, count);
+}
+
+void pixels_blend_color(Color *destination, Color color, size_t count)
+{
+    pixels_kernels().blend_color(destination, color, count);
+}
+
+void pixels_blend_premultiplied(Color *destination, const Color *source, size_t count)
+{
+    pixels_kernels().blend_premultiplied(destination, source, count);
+}
+
+void pixels_blend_color_premultiplied(Color *destination, Color color, size_t count)
+{
+    pixels_kernels().blend_color_premultiplied(destination, color, count);
+}
+
+void pixels_blend_coverage(Color *destination, const Color *mask, int channel, Color color, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        uint8_t coverage = color_multiply(((const uint8_t *)&mask[i])[channel], color.A);
+
+        if (coverage == 255)
+        {
+            destination[i] = color;
+        }
+        else if (coverage != 0)
+        {
+            Color source = (Color){{
+                color_multiply(color.R, coverage),
+                color_multiply(color.G, coverage),
+                color_multiply(color.B, coverage),
+                coverage,
+            }};
+
+            destination[i] = color_blend_premultiplied(source, destination[i]);
+        }
+    }
+}
+
+void pixels_premultiply(Color *destination, const Color *source, size_t count)
+{
+    pixels_kernels().premultiply(destination, source, count);
+}
+
+void pixels_unpremultiply(Color *destination, const Color *source, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        destination[i] = color_unpremultiply(source[i]);
+    }
+}
+
+void pixels_copy_bgra(uint32_t *destination, const Color *source, size_t count)
+{
+    pixels_kernels().copy_bgra(destination, source, count);
+}
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <libgraphic/Color.h>
+
+// Kernels working on a run of pixels from a single scanline, the painter
+// calls them once per row. They use SSE2 when the CPU supports it.
+
+void pixels_copy(Color *destination, const Color *source, size_t count);
+
+// Same as pixels_copy() but the alpha channel of the result is set to 255.
+void pixels_copy_opaque(Color *destination, const Color *source, size_t count);
+
+void pixels_fill(Color *destination, Color color, size_t count);
+
+void pixels_blend(Color *destination, const Color *source, size_t count);
+
+void pixels_blend_color(Color *destination, Color color, size_t count);
+
+// Same as above but both sides are premultiplied, this is exact integer math.
+void pixels_blend_premultiplied(Color *destination, const Color *source, size_t count);
+
+void pixels_blend_color_premultiplied(Color *destination, Color color, size_t count);
+
+// Blend a straight color over premultiplied pixels, scaled by one channel
+// of the mask (the coverage of a glyph or the alpha of an icon).
+void pixels_blend_coverage(Color *destination, const Color *mask, int channel, Color color, size_t count);
+
+void pixels_premultiply(Color *destination, const Color *source, size_t count);
+
+void pixels_unpremultiply(Color *destination, const Color *source, size_t count);
+
+// Swap the red and blue channels, to write to a display using the BGRA layout.
+void pixels_copy_bgra(uint32_t *destination, const Color *source, size_t count);
+
+bool pixels_simd_available();
+
+// Allow to switch back to the scalar kernels, mostly useful for benchmarking.
+void pixels_use_simd(bool enable);
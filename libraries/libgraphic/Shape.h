@@ -3,6 +3,7 @@
 #include <libsystem/math/Math.h>
 #include <libsystem/math/MinMax.h>
 #include <libsystem/math/Vectors.h>
+#include <libutils/Iteration.h>
 
 struct Insets
 {
@@ -341,3 +342,326 @@ public:
 
     bool is_empty() const { return _width == 0 && _height == 0; };
 };
+
+#define REGION_MAX_RECTANGLES (16)
+
+// A set of pixels stored as disjoint rectangles sorted in horizontal bands:
+// top to bottom, then left to right, rectangles of a band sharing the same
+// y and height. The storage is fixed so a region can be copied around and
+// sent to the compositor as is. When a result doesn't fit, the region grows
+// to cover more pixels than asked but never less, which is what damage
+// tracking needs.
+struct Region
+{
+private:
+    int _count;
+    Rectangle _rectangles[REGION_MAX_RECTANGLES];
+
+    enum class Operation
+    {
+        UNITE,
+        INTERSECT,
+        SUBTRACT,
+    };
+
+    static void insert_sorted(int *values, int &count, int value)
+    {
+        int index = 0;
+
+        while (index < count && values[index] < value)
+        {
+            index++;
+        }
+
+        if (index < count && values[index] == value)
+        {
+            return;
+        }
+
+        for (int i = count; i > index; i--)
+        {
+            values[i] = values[i - 1];
+        }
+
+        values[index] = value;
+        count++;
+    }
+
+    static bool covers(const Region &region, int top, int bottom, int left, int right)
+    {
+        for (int i = 0; i < region._count; i++)
+        {
+            const Rectangle &rectangle = region._rectangles[i];
+
+            if (rectangle.y() <= top && rectangle.y() + rectangle.height() >= bottom &&
+                rectangle.x() <= left && rectangle.x() + rectangle.width() >= right)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    static bool keep(Operation operation, bool in_left, bool in_right)
+    {
+        switch (operation)
+        {
+        case Operation::UNITE:
+            return in_left || in_right;
+
+        case Operation::INTERSECT:
+            return in_left && in_right;
+
+        case Operation::SUBTRACT:
+            return in_left && !in_right;
+
+        default:
+            return false;
+        }
+    }
+
+    // Returns false if the result doesn't fit in a region.
+    static bool combine(const Region &left, const Region &right, Operation operation, Region &result)
+    {
+        int ys[REGION_MAX_RECTANGLES * 4];
+        int ys_count = 0;
+
+        int xs[REGION_MAX_RECTANGLES * 4];
+
+        for (int i = 0; i < left._count; i++)
+        {
+            insert_sorted(ys, ys_count, left._rectangles[i].y());
+            insert_sorted(ys, ys_count, left._rectangles[i].y() + left._rectangles[i].height());
+        }
+
+        for (int i = 0; i < right._count; i++)
+        {
+            insert_sorted(ys, ys_count, right._rectangles[i].y());
+            insert_sorted(ys, ys_count, right._rectangles[i].y() + right._rectangles[i].height());
+        }
+
+        result._count = 0;
+
+        int previous_band_start = 0;
+        int previous_band_count = 0;
+
+        for (int band = 0; band + 1 < ys_count; band++)
+        {
+            int top = ys[band];
+            int bottom = ys[band + 1];
+
+            int xs_count = 0;
+
+            for (int i = 0; i < left._count; i++)
+            {
+                const Rectangle &rectangle = left._rectangles[i];
+
+                if (rectangle.y() <= top && rectangle.y() + rectangle.height() >= bottom)
+                {
+                    insert_sorted(xs, xs_count, rectangle.x());
+                    insert_sorted(xs, xs_count, rectangle.x() + rectangle.width());
+                }
+            }
+
+            for (int i = 0; i < right._count; i++)
+            {
+                const Rectangle &rectangle = right._rectangles[i];
+
+                if (rectangle.y() <= top && rectangle.y() + rectangle.height() >= bottom)
+                {
+                    insert_sorted(xs, xs_count, rectangle.x());
+                    insert_sorted(xs, xs_count, rectangle.x() + rectangle.width());
+                }
+            }
+
+            int band_start = result._count;
+            int span_start = -1;
+
+            for (int i = 0; i + 1 < xs_count; i++)
+            {
+                bool kept = keep(
+                    operation,
+                    covers(left, top, bottom, xs[i], xs[i + 1]),
+                    covers(right, top, bottom, xs[i], xs[i + 1]));
+
+                if (kept && span_start == -1)
+                {
+                    span_start = xs[i];
+                }
+
+                bool span_ends = span_start != -1 && (!kept || i + 2 == xs_count);
+
+                if (span_ends)
+                {
+                    if (result._count == REGION_MAX_RECTANGLES)
+                    {
+                        return false;
+                    }
+
+                    int span_end = kept ? xs[i + 1] : xs[i];
+
+                    result._rectangles[result._count++] = Rectangle(span_start, top, span_end - span_start, bottom - top);
+                    span_start = -1;
+                }
+            }
+
+            int band_count = result._count - band_start;
+
+            if (band_count == 0)
+            {
+                continue;
+            }
+
+            // Grow the previous band instead if this one continues it.
+            bool same_spans = previous_band_count == band_count &&
+                              result._rectangles[previous_band_start].y() + result._rectangles[previous_band_start].height() == top;
+
+            for (int i = 0; same_spans && i < band_count; i++)
+            {
+                const Rectangle &previous = result._rectangles[previous_band_start + i];
+                const Rectangle &current = result._rectangles[band_start + i];
+
+                same_spans = previous.x() == current.x() && previous.width() == current.width();
+            }
+
+            if (same_spans)
+            {
+                for (int i = 0; i < band_count; i++)
+                {
+                    Rectangle &previous = result._rectangles[previous_band_start + i];
+                    previous = Rectangle(previous.x(), previous.y(), previous.width(), bottom - previous.y());
+                }
+
+                result._count = band_start;
+            }
+            else
+            {
+                previous_band_start = band_start;
+                previous_band_count = band_count;
+            }
+        }
+
+        return true;
+    }
+
+public:
+    static Region empty() { return Region(); }
+
+    Region() : _count(0) {}
+
+    Region(Rectangle rectangle) : _count(0)
+    {
+        if (rectangle.width() > 0 && rectangle.height() > 0)
+        {
+            _rectangles[0] = rectangle;
+            _count = 1;
+        }
+    }
+
+    int count() const { return _count; }
+
+    bool is_empty() const { return _count == 0; }
+
+    Rectangle operator[](int index) const { return _rectangles[index]; }
+
+    Rectangle bound() const
+    {
+        if (_count == 0)
+        {
+            return Rectangle::empty();
+        }
+
+        Rectangle bound = _rectangles[0];
+
+        for (int i = 1; i < _count; i++)
+        {
+            bound = bound.merged_with(_rectangles[i]);
+        }
+
+        return bound;
+    }
+
+    bool colide_with(Rectangle rectangle) const
+    {
+        for (int i = 0; i < _count; i++)
+        {
+            if (_rectangles[i].colide_with(rectangle))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    Region unite(const Region &other) const
+    {
+        Region result;
+
+        if (!combine(*this, other, Operation::UNITE, result))
+        {
+            return Region(bound().merged_with(other.bound()));
+        }
+
+        return result;
+    }
+
+    Region intersect(const Region &other) const
+    {
+        Region result;
+
+        if (!combine(*this, other, Operation::INTERSECT, result))
+        {
+            Rectangle bound = this->bound();
+            Rectangle other_bound = other.bound();
+
+            if (!bound.colide_with(other_bound))
+            {
+                return Region();
+            }
+
+            return Region(bound.clipped_with(other_bound));
+        }
+
+        return result;
+    }
+
+    Region subtract(const Region &other) const
+    {
+        Region result;
+
+        if (!combine(*this, other, Operation::SUBTRACT, result))
+        {
+            return *this;
+        }
+
+        return result;
+    }
+
+    Region offset(Vec2i offset) const
+    {
+        Region result = *this;
+
+        for (int i = 0; i < result._count; i++)
+        {
+            result._rectangles[i] = result._rectangles[i].offset(offset);
+        }
+
+        return result;
+    }
+
+    template <typename Callback>
+    Iteration foreach (Callback callback) const
+    {
+        for (int i = 0; i < _count; i++)
+        {
+            if (callback(_rectangles[i]) == Iteration::STOP)
+            {
+                return Iteration::STOP;
+            }
+        }
+
+        return Iteration::CONTINUE;
+    }
+};
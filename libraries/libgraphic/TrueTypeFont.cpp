@@ -1,13 +1,15 @@
 #include <libgraphic/Bitmap.h>
 #include <libgraphic/TrueType.h>
 #include <libgraphic/TrueTypeFont.h>
+#include <libsystem/io/File.h>
 #include <libsystem/io/Stream.h>
 #include <libsystem/math/Vectors.h>
+#include <libsystem/system/Memory.h>
 
 struct TrueTypeFamily
 {
     truetype_fontinfo info;
-    void *buffer;
+    const void *buffer;
     size_t buffer_size;
 };
 
@@ -25,16 +27,13 @@ struct TrueTypeFont
 
 TrueTypeFamily *truetype_family_create(const char *path)
 {
-    Stream *font_file = stream_open(path, OPEN_READ);
-
-    FileState state = {};
-    stream_stat(font_file, &state);
-
     TrueTypeFamily *family = __create(TrueTypeFamily);
-    family->buffer_size = state.size;
-    family->buffer = malloc(state.size);
 
-    stream_read(font_file, family->buffer, state.size);
+    if (file_map_all(path, &family->buffer, &family->buffer_size) != SUCCESS)
+    {
+        free(family);
+        return nullptr;
+    }
 
     truetype_InitFont(
         &family->info,
@@ -46,7 +45,7 @@ TrueTypeFamily *truetype_family_create(const char *path)
 
 void truetype_family_destroy(TrueTypeFamily *family)
 {
-    free(family->buffer);
+    memory_free((uintptr_t)family->buffer);
     free(family);
 }
 
@@ -70,6 +70,8 @@ Result __plug_process_get_directory(char *buffer, uint size);
 
 Result __plug_process_set_directory(const char *directory);
 
+Result __plug_process_set_priority(int pid, int priority);
+
 Result __plug_process_sleep(int time);
 
 Result __plug_process_wait(int pid, int *exit_value);
@@ -86,10 +88,24 @@ Result __plug_handle_select(
     SelectEvent *selected_events,
     Timeout timeout);
 
+Result __plug_handle_poll_control(int poll_handle, HandlePollOperation operation, int handle, SelectEvent events);
+
+Result __plug_handle_poll_wait(int poll_handle, HandlePollEvent *events, size_t count, size_t *ready, Timeout timeout);
+
 size_t __plug_handle_read(Handle *handle, void *buffer, size_t size);
 
 size_t __plug_handle_write(Handle *handle, const void *buffer, size_t size);
 
+size_t __plug_handle_readv(Handle *handle, const IOVector *vectors, size_t count);
+
+size_t __plug_handle_writev(Handle *handle, const IOVector *vectors, size_t count);
+
+size_t __plug_handle_pread(Handle *handle, void *buffer, size_t size, size_t offset);
+
+size_t __plug_handle_pwrite(Handle *handle, const void *buffer, size_t size, size_t offset);
+
+size_t __plug_handle_splice(Handle *source, Handle *destination, size_t size);
+
 Result __plug_handle_call(Handle *handle, IOCall request, void *args);
 
 int __plug_handle_seek(Handle *handle, int offset, Whence whence);
@@ -98,6 +114,8 @@ int __plug_handle_tell(Handle *handle, Whence whence);
 
 int __plug_handle_stat(Handle *handle, FileState *stat);
 
+Result __plug_handle_map(Handle *handle, uintptr_t *address, size_t *size);
+
 void __plug_handle_connect(Handle *handle, const char *path);
 
 void __plug_handle_accept(Handle *handle, Handle *connection_handle);
@@ -105,3 +123,5 @@ void __plug_handle_accept(Handle *handle, Handle *connection_handle);
 Result __plug_create_pipe(int *reader_handle, int *writer_handle);
 
 Result __plug_create_term(int *master_handle, int *slave_handle);
+
+Result __plug_create_poll(int *poll_handle);
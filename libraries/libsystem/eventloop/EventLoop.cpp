@@ -18,12 +18,13 @@ struct RunLater
 static List *_eventloop_timers = nullptr;
 static TimeStamp _eventloop_timer_last_fire = 0;
 
-static List *_eventloop_notifiers = nullptr;
 static Vector<RunLater> *_eventloop_run_later = nullptr;
 
-static size_t _eventloop_handles_count;
-static Handle *_eventloop_handles[PROCESS_HANDLE_COUNT];
-static SelectEvent _eventloop_events[PROCESS_HANDLE_COUNT];
+// Notifiers are indexed by the id of their handle, the kernel keeps track of
+// the handles we are interested in and gives back the ready ones in one go.
+static Handle *_eventloop_poll = nullptr;
+static Notifier *_eventloop_notifiers[PROCESS_HANDLE_COUNT] = {};
+static HandlePollEvent _eventloop_ready_events[PROCESS_HANDLE_COUNT];
 
 static bool _eventloop_is_running = false;
 static bool _eventloop_is_initialize = false;
@@ -39,7 +40,13 @@ void eventloop_initialize()
     _eventloop_timers = list_create();
     _eventloop_timer_last_fire = system_get_ticks();
 
-    _eventloop_notifiers = list_create();
+    _eventloop_poll = handle_poll_create();
+
+    if (handle_has_error(_eventloop_poll))
+    {
+        logger_error("Failled to create the eventloop poll: %s", handle_error_string(_eventloop_poll));
+    }
+
     _eventloop_run_later = new Vector<RunLater>();
 
     _eventloop_is_initialize = true;
@@ -49,7 +56,14 @@ void eventloop_uninitialize()
 {
     assert(_eventloop_is_initialize);
 
-    list_destroy(_eventloop_notifiers);
+    handle_poll_destroy(_eventloop_poll);
+    _eventloop_poll = nullptr;
+
+    for (size_t i = 0; i < PROCESS_HANDLE_COUNT; i++)
+    {
+        _eventloop_notifiers[i] = nullptr;
+    }
+
     list_destroy(_eventloop_timers);
     delete _eventloop_run_later;
 
@@ -158,15 +172,13 @@ void eventloop_pump(bool pool)
 
     eventloop_update_timers();
 
-    Handle *selected = nullptr;
-    SelectEvent selected_events = 0;
+    size_t ready = 0;
 
-    Result result = handle_select(
-        &_eventloop_handles[0],
-        &_eventloop_events[0],
-        _eventloop_handles_count,
-        &selected,
-        &selected_events,
+    Result result = handle_poll_wait(
+        _eventloop_poll,
+        &_eventloop_ready_events[0],
+        PROCESS_HANDLE_COUNT,
+        &ready,
         timeout);
 
     if (result_is_error(result))
@@ -177,11 +189,16 @@ void eventloop_pump(bool pool)
 
     eventloop_update_timers();
 
-    list_foreach(Notifier, notifier, _eventloop_notifiers)
+    for (size_t i = 0; i < ready; i++)
     {
-        if (notifier->handle == selected)
+        HandlePollEvent &event = _eventloop_ready_events[i];
+
+        // A previous callback might have destroyed the notifier.
+        Notifier *notifier = _eventloop_notifiers[event.handle];
+
+        if (notifier)
         {
-            notifier->callback(notifier->target, notifier->handle, selected_events);
+            notifier->callback(notifier->target, notifier->handle, event.events);
         }
     }
 
@@ -211,34 +228,39 @@ void eventloop_exit_nested(int exit_value)
     _nested_eventloop_exit_value = exit_value;
 }
 
-void eventloop_update_notifier()
-{
-    _eventloop_handles_count = 0;
-
-    list_foreach(Notifier, notifier, _eventloop_notifiers)
-    {
-        _eventloop_handles[_eventloop_handles_count] = notifier->handle;
-        _eventloop_events[_eventloop_handles_count] = notifier->events;
-
-        _eventloop_handles_count++;
-    }
-}
 void eventloop_register_notifier(Notifier *notifier)
 {
     assert(_eventloop_is_initialize);
 
-    list_pushback(_eventloop_notifiers, notifier);
+    int id = notifier->handle->id;
+
+    assert(id >= 0 && id < PROCESS_HANDLE_COUNT);
+    assert(!_eventloop_notifiers[id]);
 
-    eventloop_update_notifier();
+    _eventloop_notifiers[id] = notifier;
+
+    Result result = handle_poll_add(_eventloop_poll, notifier->handle, notifier->events);
+
+    if (result_is_error(result))
+    {
+        logger_error("Failled to watch handle %d: %s", id, result_to_string(result));
+    }
 }
 
 void eventloop_unregister_notifier(Notifier *notifier)
 {
     assert(_eventloop_is_initialize);
 
-    list_remove(_eventloop_notifiers, notifier);
+    int id = notifier->handle->id;
+
+    if (id < 0 || id >= PROCESS_HANDLE_COUNT || _eventloop_notifiers[id] != notifier)
+    {
+        return;
+    }
+
+    _eventloop_notifiers[id] = nullptr;
 
-    eventloop_update_notifier();
+    handle_poll_remove(_eventloop_poll, notifier->handle);
 }
 
 void eventloop_register_timer(struct Timer *timer)
@@ -1,5 +1,8 @@
 #include <libsystem/io/File.h>
+#include <libsystem/io/Handle.h>
 #include <libsystem/io/Stream.h>
+#include <libsystem/math/MinMax.h>
+#include <libsystem/system/Memory.h>
 
 Result file_read_all(const char *path, void **buffer, size_t *size)
 {
@@ -32,6 +35,61 @@ Result file_read_all(const char *path, void **buffer, size_t *size)
     return SUCCESS;
 }
 
+Result file_map_all(const char *path, const void **buffer, size_t *size)
+{
+    __cleanup(stream_cleanup) Stream *stream = stream_open(path, OPEN_READ);
+
+    if (handle_has_error(stream))
+    {
+        return handle_get_error(stream);
+    }
+
+    Result result = handle_map(HANDLE(stream), (void **)buffer, size);
+
+    if (result != ERR_OPERATION_NOT_SUPPORTED)
+    {
+        return result;
+    }
+
+    // Files that can't be mapped (like the ones living on a disk) are copied instead,
+    // the buffer is released with memory_free() either way.
+    FileState state = {};
+    stream_stat(stream, &state);
+
+    if (handle_has_error(stream))
+    {
+        return handle_get_error(stream);
+    }
+
+    uintptr_t address = 0;
+    result = memory_alloc(MAX(state.size, 1), &address);
+
+    if (result != SUCCESS)
+    {
+        return result;
+    }
+
+    size_t done = 0;
+
+    while (done < state.size)
+    {
+        size_t read = stream_read(stream, (char *)address + done, state.size - done);
+
+        if (handle_has_error(stream) || read == 0)
+        {
+            memory_free(address);
+            return handle_has_error(stream) ? handle_get_error(stream) : ERR_INPUT_OUTPUT_ERROR;
+        }
+
+        done += read;
+    }
+
+    *buffer = (const void *)address;
+    *size = state.size;
+
+    return SUCCESS;
+}
+
 Result file_write_all(const char *path, void *buffer, size_t size)
 {
     __cleanup(stream_cleanup) Stream *stream = stream_open(path, OPEN_WRITE);
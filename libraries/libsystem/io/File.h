@@ -5,6 +5,9 @@
 
 Result file_read_all(const char *path, void **buffer, size_t *size);
 
+// Map the file read-only instead of copying it, release it with memory_free().
+Result file_map_all(const char *path, const void **buffer, size_t *size);
+
 Result file_write_all(const char *path, void *buffer, size_t size);
 
 bool file_exist(const char *path);
\ No newline at end of file
@@ -56,3 +56,72 @@ Result handle_select(
 
     return result;
 }
+
+size_t handle_splice(Handle *source, Handle *destination, size_t size)
+{
+    return __plug_handle_splice(source, destination, size);
+}
+
+size_t handle_readv(Handle *handle, const IOVector *vectors, size_t count)
+{
+    return __plug_handle_readv(handle, vectors, count);
+}
+
+size_t handle_writev(Handle *handle, const IOVector *vectors, size_t count)
+{
+    return __plug_handle_writev(handle, vectors, count);
+}
+
+size_t handle_pread(Handle *handle, void *buffer, size_t size, size_t offset)
+{
+    return __plug_handle_pread(handle, buffer, size, offset);
+}
+
+size_t handle_pwrite(Handle *handle, const void *buffer, size_t size, size_t offset)
+{
+    return __plug_handle_pwrite(handle, buffer, size, offset);
+}
+
+Result handle_map(Handle *handle, void **address, size_t *size)
+{
+    return __plug_handle_map(handle, (uintptr_t *)address, size);
+}
+
+Handle *handle_poll_create()
+{
+    Handle *poll = __create(Handle);
+
+    poll->id = HANDLE_INVALID_ID;
+    poll->flags = OPEN_READ;
+    poll->result = __plug_create_poll(&poll->id);
+
+    return poll;
+}
+
+void handle_poll_destroy(Handle *poll)
+{
+    __plug_handle_close(poll);
+    free(poll);
+}
+
+Result handle_poll_add(Handle *poll, Handle *handle, SelectEvent events)
+{
+    return __plug_handle_poll_control(poll->id, HANDLE_POLL_ADD, handle->id, events);
+}
+
+Result handle_poll_modify(Handle *poll, Handle *handle, SelectEvent events)
+{
+    return __plug_handle_poll_control(poll->id, HANDLE_POLL_MODIFY, handle->id, events);
+}
+
+Result handle_poll_remove(Handle *poll, Handle *handle)
+{
+    return __plug_handle_poll_control(poll->id, HANDLE_POLL_REMOVE, handle->id, 0);
+}
+
+Result handle_poll_wait(Handle *poll, HandlePollEvent *events, size_t count, size_t *ready, Timeout timeout)
+{
+    *ready = 0;
+
+    return __plug_handle_poll_wait(poll->id, events, count, ready, timeout);
+}
@@ -15,3 +15,38 @@ Result handle_select(
     Handle **selected,
     SelectEvent *selected_events,
     Timeout timeout);
+
+// Move data from one handle to the other without copying it to user space,
+// one of them has to be a pipe. Data sitting in stream buffers is not moved,
+// the result is reported through the source handle.
+size_t handle_splice(Handle *source, Handle *destination, size_t size);
+
+// Scatter/gather I/O, the vectors are filled or written one after the other
+// in a single call, a read stops at the first vector that isn't filled.
+size_t handle_readv(Handle *handle, const IOVector *vectors, size_t count);
+
+size_t handle_writev(Handle *handle, const IOVector *vectors, size_t count);
+
+// Read or write at a given offset without moving the offset of the handle,
+// only supported by regular files and block devices.
+size_t handle_pread(Handle *handle, void *buffer, size_t size, size_t offset);
+
+size_t handle_pwrite(Handle *handle, const void *buffer, size_t size, size_t offset);
+
+// Map the content of a file read-only in the address space of the process,
+// the mapping is released with memory_free().
+Result handle_map(Handle *handle, void **address, size_t *size);
+
+// A set of handles kept by the kernel, handle_poll_wait() reports every
+// ready handle at once without passing the whole set on each call.
+Handle *handle_poll_create();
+
+void handle_poll_destroy(Handle *poll);
+
+Result handle_poll_add(Handle *poll, Handle *handle, SelectEvent events);
+
+Result handle_poll_modify(Handle *poll, Handle *handle, SelectEvent events);
+
+Result handle_poll_remove(Handle *poll, Handle *handle);
+
+Result handle_poll_wait(Handle *poll, HandlePollEvent *events, size_t count, size_t *ready, Timeout timeout);
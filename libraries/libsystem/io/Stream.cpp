@@ -152,14 +152,32 @@ int stream_read_buffered(Stream *stream, void *buffer, size_t size)
 
     while (data_left != 0)
     {
-        // Fill the buffer with data
+        // The buffer is empty, read straight into the caller buffer
+        // and refill ours with what comes after in the same call.
         if (stream->read_head == stream->read_used)
         {
-            if (stream_fill(stream) == 0)
+            IOVector vectors[2] = {
+                {data_to_read, data_left},
+                {stream->read_buffer, STREAM_BUFFER_SIZE},
+            };
+
+            size_t read = __plug_handle_readv(HANDLE(stream), vectors, 2);
+
+            if (read == 0)
             {
                 // Look like we have no more data to read
                 return size - data_left;
             }
+
+            size_t data_read = MIN(read, data_left);
+
+            data_left -= data_read;
+            data_to_read += data_read;
+
+            stream->read_head = 0;
+            stream->read_used = read - data_read;
+
+            continue;
         }
 
         // How many data can we copy from the buffer
@@ -171,6 +189,7 @@ int stream_read_buffered(Stream *stream, void *buffer, size_t size)
 
         // Update the amount read
         data_left -= data_added;
+        data_to_read += data_added;
         stream->read_head += data_added;
     }
 
@@ -232,29 +251,24 @@ static size_t stream_write_linebuffered(Stream *stream, const void *buffer, size
 
 static size_t stream_write_buffered(Stream *stream, const void *buffer, size_t size)
 {
-    int data_left = size;
-
-    char *data_to_write = (char *)buffer;
-
-    while (data_left > 0)
+    // Append the data to the buffer if it fits
+    if (stream->write_used + size < STREAM_BUFFER_SIZE)
     {
-        // Append the data to the buffer
-        int free_space = STREAM_BUFFER_SIZE - stream->write_used;
-        int data_added = MIN(free_space, data_left);
+        memcpy(((char *)(stream->write_buffer)) + stream->write_used, buffer, size);
+        stream->write_used += size;
 
-        // Copy the data to the buffer
-        memcpy(((char *)(stream->write_buffer)) + stream->write_used, data_to_write, data_added);
-        stream->write_used += data_added;
-        data_left -= data_added;
-        data_to_write += data_added;
-
-        // flush the data if buffer is full
-        if (stream->write_used == STREAM_BUFFER_SIZE)
-        {
-            stream_flush(stream);
-        }
+        return size;
     }
 
+    // Otherwise write what's buffered and the new data in a single call
+    IOVector vectors[2] = {
+        {stream->write_buffer, (size_t)stream->write_used},
+        {(void *)buffer, size},
+    };
+
+    __plug_handle_writev(HANDLE(stream), vectors, 2);
+    stream->write_used = 0;
+
     return size;
 }
 
@@ -279,6 +293,25 @@ size_t stream_write(Stream *stream, const void *buffer, size_t size)
     }
 }
 
+size_t stream_pread(Stream *stream, void *buffer, size_t size, size_t offset)
+{
+    if (!stream)
+        return 0;
+
+    return __plug_handle_pread(HANDLE(stream), buffer, size, offset);
+}
+
+size_t stream_pwrite(Stream *stream, const void *buffer, size_t size, size_t offset)
+{
+    if (!stream)
+        return 0;
+
+    // Pending writes have to land before this one.
+    stream_flush(stream);
+
+    return __plug_handle_pwrite(HANDLE(stream), buffer, size, offset);
+}
+
 void stream_flush(Stream *stream)
 {
     if (!stream)
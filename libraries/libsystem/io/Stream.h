@@ -42,6 +42,11 @@ size_t stream_read(Stream *stream, void *buffer, size_t size);
 
 size_t stream_write(Stream *stream, const void *buffer, size_t size);
 
+// Read or write at a given offset, the position of the stream is left untouched.
+size_t stream_pread(Stream *stream, void *buffer, size_t size, size_t offset);
+
+size_t stream_pwrite(Stream *stream, const void *buffer, size_t size, size_t offset);
+
 void stream_flush(Stream *stream);
 
 Result stream_call(Stream *stream, IOCall request, void *arg);
@@ -21,6 +21,16 @@ Result __plug_handle_select(HandleSet *handles, int *selected, SelectEvent *sele
     return (Result)__syscall(SYS_HANDLE_SELECT, (int)handles, (int)selected, (int)selected_events, timeout, 0);
 }
 
+Result __plug_handle_poll_control(int poll_handle, HandlePollOperation operation, int handle, SelectEvent events)
+{
+    return (Result)__syscall(SYS_HANDLE_POLL_CONTROL, poll_handle, operation, handle, events, 0);
+}
+
+Result __plug_handle_poll_wait(int poll_handle, HandlePollEvent *events, size_t count, size_t *ready, Timeout timeout)
+{
+    return (Result)__syscall(SYS_HANDLE_POLL_WAIT, poll_handle, (int)events, count, (int)ready, timeout);
+}
+
 size_t __plug_handle_read(Handle *handle, void *buffer, size_t size)
 {
     size_t read;
@@ -39,6 +49,51 @@ size_t __plug_handle_write(Handle *handle, const void *buffer, size_t size)
     return written;
 }
 
+size_t __plug_handle_readv(Handle *handle, const IOVector *vectors, size_t count)
+{
+    size_t read = 0;
+
+    handle->result = (Result)__syscall(SYS_HANDLE_READV, handle->id, (int)vectors, count, (int)&read, 0);
+
+    return read;
+}
+
+size_t __plug_handle_writev(Handle *handle, const IOVector *vectors, size_t count)
+{
+    size_t written = 0;
+
+    handle->result = (Result)__syscall(SYS_HANDLE_WRITEV, handle->id, (int)vectors, count, (int)&written, 0);
+
+    return written;
+}
+
+size_t __plug_handle_pread(Handle *handle, void *buffer, size_t size, size_t offset)
+{
+    size_t read = 0;
+
+    handle->result = (Result)__syscall(SYS_HANDLE_PREAD, handle->id, (int)buffer, size, offset, (int)&read);
+
+    return read;
+}
+
+size_t __plug_handle_pwrite(Handle *handle, const void *buffer, size_t size, size_t offset)
+{
+    size_t written = 0;
+
+    handle->result = (Result)__syscall(SYS_HANDLE_PWRITE, handle->id, (int)buffer, size, offset, (int)&written);
+
+    return written;
+}
+
+size_t __plug_handle_splice(Handle *source, Handle *destination, size_t size)
+{
+    size_t spliced;
+
+    source->result = (Result)__syscall(SYS_HANDLE_SPLICE, source->id, destination->id, size, (int)&spliced, 0);
+
+    return spliced;
+}
+
 Result __plug_handle_call(Handle *handle, IOCall request, void *args)
 {
 
@@ -70,6 +125,13 @@ int __plug_handle_stat(Handle *handle, FileState *stat)
     return 0;
 }
 
+Result __plug_handle_map(Handle *handle, uintptr_t *address, size_t *size)
+{
+    handle->result = (Result)__syscall(SYS_HANDLE_MAP, handle->id, (int)address, (int)size, 0, 0);
+
+    return handle->result;
+}
+
 void __plug_handle_connect(Handle *handle, const char *path)
 {
     handle->result = (Result)__syscall(SYS_HANDLE_CONNECT, (int)&handle->id, (int)path, 0, 0, 0);
@@ -89,3 +151,8 @@ Result __plug_create_term(int *master_handle, int *slave_handle)
 {
     return (Result)__syscall(SYS_CREATE_TERM, (int)master_handle, (int)slave_handle, 0, 0, 0);
 }
+
+Result __plug_create_poll(int *poll_handle)
+{
+    return (Result)__syscall(SYS_CREATE_POLL, (int)poll_handle, 0, 0, 0, 0);
+}
@@ -43,6 +43,11 @@ Result __plug_process_set_directory(const char *directory)
     return (Result)__syscall(SYS_PROCESS_SET_DIRECTORY, (int)directory, 0, 0, 0, 0);
 }
 
+Result __plug_process_set_priority(int pid, int priority)
+{
+    return (Result)__syscall(SYS_PROCESS_SET_PRIORITY, pid, priority, 0, 0, 0);
+}
+
 Result __plug_process_sleep(int time)
 {
     return (Result)__syscall(SYS_PROCESS_SLEEP, time, 0, 0, 0, 0);
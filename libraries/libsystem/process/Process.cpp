@@ -41,6 +41,11 @@ Result process_set_directory(const char *directory)
     return __plug_process_set_directory(directory);
 }
 
+Result process_set_priority(int pid, int priority)
+{
+    return __plug_process_set_priority(pid, priority);
+}
+
 Result process_sleep(int time)
 {
     return __plug_process_sleep(time);
@@ -17,6 +17,8 @@ Result process_get_directory(char *buffer, size_t size);
 
 Result process_set_directory(const char *directory);
 
+Result process_set_priority(int pid, int priority);
+
 int process_sleep(int time);
 
 int process_wait(int pid, int *exit_value);
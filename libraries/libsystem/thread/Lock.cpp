@@ -44,6 +44,18 @@ bool __lock_try_acquire(Lock *lock)
     return true;
 }
 
+bool __lock_try_acquire_by(Lock *lock, int holder)
+{
+    if (!__sync_bool_compare_and_swap(&lock->locked, 0, 1))
+        return false;
+
+    __sync_synchronize();
+
+    lock->holder = holder;
+
+    return true;
+}
+
 void __lock_release(Lock *lock, const char *file, const char *function, int line)
 {
     __lock_assert(lock, file, function, line);
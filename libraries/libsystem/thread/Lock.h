@@ -21,6 +21,8 @@ void __lock_release_by(Lock *lock, int holder, const char *file, const char *fun
 
 bool __lock_try_acquire(Lock *lock);
 
+bool __lock_try_acquire_by(Lock *lock, int holder);
+
 void __lock_assert(Lock *lock, const char *file, const char *function, int line);
 
 #define lock_init(lock) __lock_init(&lock, #lock)
@@ -31,6 +33,8 @@ void __lock_assert(Lock *lock, const char *file, const char *function, int line)
 
 #define lock_try_acquire(lock) __lock_try_acquire(&lock)
 
+#define lock_try_acquire_by(lock, __holder) __lock_try_acquire_by(&lock, __holder)
+
 #define lock_release(lock) __lock_release(&lock, __FILE__, __FUNCTION__, __LINE__)
 
 #define lock_release_by(lock, __holder) __lock_release_by(&lock, __holder, __FILE__, __FUNCTION__, __LINE__)
@@ -0,0 +1,15 @@
+#pragma once
+
+#include <libsystem/Common.h>
+
+// djb2, by Dan Bernstein.
+static inline uint32_t hash_string(const char *string)
+{
+    uint32_t hash = 5381;
+    int c;
+
+    while ((c = *string++))
+        hash = ((hash << 5) + hash) + c;
+
+    return hash;
+}
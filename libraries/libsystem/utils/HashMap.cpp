@@ -1,4 +1,5 @@
 #include <libsystem/core/CString.h>
+#include <libsystem/utils/Hash.h>
 #include <libsystem/utils/HashMap.h>
 
 typedef void *(*HashMapCopyKeyCallback)(const void *value);
@@ -31,13 +32,7 @@ static char *hashmap_string_copy(const char *string)
 
 static uint32_t hashmap_string_hash(const char *string)
 {
-    uint32_t hash = 5381;
-    int c;
-
-    while ((c = *string++))
-        hash = ((hash << 5) + hash) + c;
-
-    return hash;
+    return hash_string(string);
 }
 
 static int hashmap_string_compare(const char *left, const char *right)
@@ -29,6 +29,8 @@ struct List
     auto any() { return _count > 0; }
 
     auto count() { return _count; }
+
+    auto head() { return _head; }
 };
 
 typedef bool (*ListCompareElementCallback)(void *left, void *right);
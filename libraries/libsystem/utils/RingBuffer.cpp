@@ -1,22 +1,41 @@
-
 #include <libsystem/Assert.h>
+#include <libsystem/core/CString.h>
+#include <libsystem/math/MinMax.h>
 #include <libsystem/utils/RingBuffer.h>
 
 struct RingBuffer
 {
+    // head and tail are never wrapped, only their difference matters.
+    // The producer is the only one writing head and the consumer the only one writing tail.
     size_t head;
     size_t tail;
+
     size_t size;
-    size_t used;
+    size_t mask;
 
     char buffer[];
 };
 
+static size_t ringbuffer_storage_size(size_t size)
+{
+    size_t storage_size = 1;
+
+    while (storage_size < size)
+    {
+        storage_size <<= 1;
+    }
+
+    return storage_size;
+}
+
 RingBuffer *ringbuffer_create(size_t size)
 {
-    RingBuffer *ringbuffer = (RingBuffer *)calloc(1, sizeof(RingBuffer) + size);
+    size_t storage_size = ringbuffer_storage_size(size);
+
+    RingBuffer *ringbuffer = (RingBuffer *)calloc(1, sizeof(RingBuffer) + storage_size);
 
     ringbuffer->size = size;
+    ringbuffer->mask = storage_size - 1;
 
     return ringbuffer;
 }
@@ -38,58 +57,106 @@ bool ringbuffer_is_full(RingBuffer *ringbuffer)
 
 size_t ringbuffer_used(RingBuffer *ringbuffer)
 {
-    return ringbuffer->used;
+    size_t head = __atomic_load_n(&ringbuffer->head, __ATOMIC_ACQUIRE);
+    size_t tail = __atomic_load_n(&ringbuffer->tail, __ATOMIC_ACQUIRE);
+
+    return head - tail;
 }
 
 void ringbuffer_putc(RingBuffer *ringbuffer, char c)
 {
     assert(!ringbuffer_is_full(ringbuffer));
 
-    ringbuffer->buffer[ringbuffer->head] = c;
-    ringbuffer->head = (ringbuffer->head + 1) % (ringbuffer->size);
-    ringbuffer->used++;
+    ringbuffer->buffer[ringbuffer->head & ringbuffer->mask] = c;
+    __atomic_store_n(&ringbuffer->head, ringbuffer->head + 1, __ATOMIC_RELEASE);
 }
 
 char ringbuffer_getc(RingBuffer *ringbuffer)
 {
     assert(!ringbuffer_is_empty(ringbuffer));
 
-    char c = ringbuffer->buffer[ringbuffer->tail];
-    ringbuffer->tail = (ringbuffer->tail + 1) % (ringbuffer->size);
-    ringbuffer->used--;
+    char c = ringbuffer->buffer[ringbuffer->tail & ringbuffer->mask];
+    __atomic_store_n(&ringbuffer->tail, ringbuffer->tail + 1, __ATOMIC_RELEASE);
 
     return c;
 }
 
 char ringbuffer_peek(RingBuffer *ringbuffer, size_t peek)
 {
-    int offset = (ringbuffer->tail + peek) % (ringbuffer->size);
-
-    return ringbuffer->buffer[offset];
+    return ringbuffer->buffer[(ringbuffer->tail + peek) & ringbuffer->mask];
 }
 
 size_t ringbuffer_read(RingBuffer *ringbuffer, char *buffer, size_t size)
 {
-    size_t read = 0;
+    size_t tail = ringbuffer->tail;
+    size_t head = __atomic_load_n(&ringbuffer->head, __ATOMIC_ACQUIRE);
 
-    while (!ringbuffer_is_empty(ringbuffer) && read < size)
-    {
-        buffer[read] = ringbuffer_getc(ringbuffer);
-        read++;
-    }
+    size = MIN(size, head - tail);
+
+    // The data might wrap around the end of the storage.
+    size_t offset = tail & ringbuffer->mask;
+    size_t first_part = MIN(size, ringbuffer->mask + 1 - offset);
+
+    memcpy(buffer, &ringbuffer->buffer[offset], first_part);
+    memcpy(buffer + first_part, &ringbuffer->buffer[0], size - first_part);
 
-    return read;
+    __atomic_store_n(&ringbuffer->tail, tail + size, __ATOMIC_RELEASE);
+
+    return size;
 }
 
 size_t ringbuffer_write(RingBuffer *ringbuffer, const char *buffer, size_t size)
 {
-    size_t written = 0;
+    size_t head = ringbuffer->head;
+    size_t tail = __atomic_load_n(&ringbuffer->tail, __ATOMIC_ACQUIRE);
 
-    while (!ringbuffer_is_full(ringbuffer) && written < size)
-    {
-        ringbuffer_putc(ringbuffer, buffer[written]);
-        written++;
-    }
+    size = MIN(size, ringbuffer->size - (head - tail));
+
+    size_t offset = head & ringbuffer->mask;
+    size_t first_part = MIN(size, ringbuffer->mask + 1 - offset);
+
+    memcpy(&ringbuffer->buffer[offset], buffer, first_part);
+    memcpy(&ringbuffer->buffer[0], buffer + first_part, size - first_part);
+
+    __atomic_store_n(&ringbuffer->head, head + size, __ATOMIC_RELEASE);
+
+    return size;
+}
+
+size_t ringbuffer_readable_span(RingBuffer *ringbuffer, const char **span)
+{
+    size_t tail = ringbuffer->tail;
+    size_t head = __atomic_load_n(&ringbuffer->head, __ATOMIC_ACQUIRE);
+
+    size_t offset = tail & ringbuffer->mask;
+
+    *span = &ringbuffer->buffer[offset];
+
+    return MIN(head - tail, ringbuffer->mask + 1 - offset);
+}
+
+void ringbuffer_consume(RingBuffer *ringbuffer, size_t size)
+{
+    assert(size <= ringbuffer_used(ringbuffer));
+
+    __atomic_store_n(&ringbuffer->tail, ringbuffer->tail + size, __ATOMIC_RELEASE);
+}
+
+size_t ringbuffer_writable_span(RingBuffer *ringbuffer, char **span)
+{
+    size_t head = ringbuffer->head;
+    size_t tail = __atomic_load_n(&ringbuffer->tail, __ATOMIC_ACQUIRE);
+
+    size_t offset = head & ringbuffer->mask;
+
+    *span = &ringbuffer->buffer[offset];
+
+    return MIN(ringbuffer->size - (head - tail), ringbuffer->mask + 1 - offset);
+}
+
+void ringbuffer_commit(RingBuffer *ringbuffer, size_t size)
+{
+    assert(ringbuffer_used(ringbuffer) + size <= ringbuffer->size);
 
-    return written;
+    __atomic_store_n(&ringbuffer->head, ringbuffer->head + size, __ATOMIC_RELEASE);
 }
@@ -2,7 +2,10 @@
 
 #include <libsystem/Common.h>
 
- struct RingBuffer ;
+// A single producer and a single consumer can use a ringbuffer at the same
+// time without any locking, e.g. an interrupt handler and a task.
+// Anything else needs to be serialized by the caller.
+struct RingBuffer;
 
 RingBuffer *ringbuffer_create(size_t size);
 
@@ -23,3 +26,13 @@ char ringbuffer_peek(RingBuffer *ringbuffer, size_t peek);
 size_t ringbuffer_read(RingBuffer *ringbuffer, char *buffer, size_t size);
 
 size_t ringbuffer_write(RingBuffer *ringbuffer, const char *buffer, size_t size);
+
+// Direct access to the storage, the data or free space might be split in two
+// spans so these have to be called until they return zero.
+size_t ringbuffer_readable_span(RingBuffer *ringbuffer, const char **span);
+
+void ringbuffer_consume(RingBuffer *ringbuffer, size_t size);
+
+size_t ringbuffer_writable_span(RingBuffer *ringbuffer, char **span);
+
+void ringbuffer_commit(RingBuffer *ringbuffer, size_t size);
@@ -6,6 +6,7 @@
 #include <libsystem/io/Connection.h>
 #include <libsystem/io/Socket.h>
 #include <libsystem/process/Process.h>
+#include <libsystem/system/Memory.h>
 
 #include <libwidget/Application.h>
 #include <libwidget/Screen.h>
@@ -27,6 +28,10 @@ static Connection *_connection;
 static Notifier *_connection_notifier;
 static bool _is_debbuging_layout = false;
 
+static CompositorRing *_ring = nullptr;
+static bool _ring_flush_scheduled = false;
+static uint32_t _flip_sequence = 0;
+
 void application_do_message(CompositorMessage *message)
 {
     if (message->type == COMPOSITOR_MESSAGE_EVENT_WINDOW)
@@ -38,17 +43,16 @@ void application_do_message(CompositorMessage *message)
             window_event(window, &message->event_window.event);
         }
     }
+    else if (message->type == COMPOSITOR_MESSAGE_ACK)
+    {
+        // Late ack for a wait that was already satisfied.
+    }
     else
     {
         logger_warn("Got an invalid message from compositor!");
     }
 }
 
-void application_send_message(CompositorMessage message)
-{
-    connection_send(_connection, &message, sizeof(CompositorMessage));
-}
-
 CompositorMessage *application_wait_for_message(CompositorMessageType expected_message)
 {
     List *pending_messages = nullptr;
@@ -90,6 +94,105 @@ void application_wait_for_ack()
     }
 }
 
+void application_flush()
+{
+    _ring_flush_scheduled = false;
+
+    CompositorMessage message = {};
+    message.type = COMPOSITOR_MESSAGE_FLUSH;
+    connection_send(_connection, &message, sizeof(CompositorMessage));
+}
+
+// Block until the compositor makes progress and `done` holds.
+template <typename Predicate>
+void application_wait_for_compositor(Predicate done)
+{
+    while (!done())
+    {
+        __atomic_store_n(&_ring->waiting, 1, __ATOMIC_SEQ_CST);
+
+        // The compositor might have caught up before seeing the flag.
+        if (done())
+        {
+            break;
+        }
+
+        application_flush();
+        application_wait_for_ack();
+    }
+}
+
+bool application_ring_has_room()
+{
+    uint32_t tail = __atomic_load_n(&_ring->tail, __ATOMIC_SEQ_CST);
+    return _ring->head - tail < COMPOSITOR_RING_CAPACITY;
+}
+
+void application_send_message(CompositorMessage message)
+{
+    if (!_ring)
+    {
+        connection_send(_connection, &message, sizeof(CompositorMessage));
+        return;
+    }
+
+    application_wait_for_compositor(application_ring_has_room);
+
+    uint32_t head = _ring->head;
+    _ring->messages[head % COMPOSITOR_RING_CAPACITY] = message;
+    __atomic_store_n(&_ring->head, head + 1, __ATOMIC_RELEASE);
+
+    // Everything sent during this turn of the event loop is flushed at once.
+    if (!_ring_flush_scheduled)
+    {
+        _ring_flush_scheduled = true;
+        eventloop_run_later((RunLaterCallback)application_flush, nullptr);
+    }
+}
+
+void application_create_ring()
+{
+    uintptr_t address = 0;
+
+    if (memory_alloc(sizeof(CompositorRing), &address) != SUCCESS)
+    {
+        logger_warn("Failled to allocate the compositor ring, falling back to the connection.");
+        return;
+    }
+
+    int handle = -1;
+
+    if (memory_get_handle(address, &handle) != SUCCESS)
+    {
+        memory_free(address);
+        return;
+    }
+
+    CompositorMessage message = {
+        .type = COMPOSITOR_MESSAGE_GREETINGS,
+        .greetings = {
+            .screen_bound = Rectangle::empty(),
+            .ring = handle,
+        },
+    };
+
+    connection_send(_connection, &message, sizeof(CompositorMessage));
+
+    CompositorMessage *answer = application_wait_for_message(COMPOSITOR_MESSAGE_GREETINGS);
+
+    if (answer->greetings.ring != handle)
+    {
+        logger_warn("The compositor refused our message ring, falling back to the connection.");
+        free(answer);
+        memory_free(address);
+        return;
+    }
+
+    free(answer);
+
+    _ring = (CompositorRing *)address;
+}
+
 void application_request_callback(
     void *target,
     Connection *connection,
@@ -165,8 +268,11 @@ Result application_initialize(int argc, char **argv)
     if (greetings_message)
     {
         screen_set_bound(greetings_message->greetings.screen_bound);
+        free(greetings_message);
     }
 
+    application_create_ring();
+
     return SUCCESS;
 }
 
@@ -314,25 +420,41 @@ void application_hide_window(Window *window)
     application_exit_if_all_windows_are_closed();
 }
 
-void application_flip_window(Window *window, Rectangle bound)
+void application_flip_window(Window *window, Region region)
 {
     assert(_state >= APPLICATION_INITALIZED);
     assert(list_contains(_windows, window));
 
+    if (_ring)
+    {
+        // Keep a bounded amount of flips in flight instead of waiting for each one.
+        application_wait_for_compositor([]() {
+            uint32_t acknowledged = __atomic_load_n(&_ring->acknowledged, __ATOMIC_SEQ_CST);
+            return _flip_sequence - acknowledged < COMPOSITOR_RING_MAX_PENDING_FLIPS;
+        });
+    }
+
+    _flip_sequence++;
+
     CompositorMessage message = {
         .type = COMPOSITOR_MESSAGE_FLIP_WINDOW,
         .flip_window = {
             .id = window_handle(window),
+            .sequence = _flip_sequence,
             .frontbuffer = window_frontbuffer_handle(window),
             .frontbuffer_size = window->frontbuffer->size(),
             .backbuffer = window_backbuffer_handle(window),
             .backbuffer_size = window->frontbuffer->size(),
-            .bound = bound,
+            .region = region,
         },
     };
 
     application_send_message(message);
-    application_wait_for_ack();
+
+    if (!_ring)
+    {
+        application_wait_for_ack();
+    }
 }
 
 void application_move_window(Window *window, Vec2i position)
@@ -28,7 +28,7 @@ void application_show_window(Window *window);
 
 void application_hide_window(Window *window);
 
-void application_flip_window(Window *window, Rectangle bound);
+void application_flip_window(Window *window, Region region);
 
 void application_move_window(Window *window, Vec2i position);
 
@@ -67,7 +67,7 @@ void window_initialize(Window *window, WindowFlag flags)
     window->backbuffer_painter = Painter(window->backbuffer);
 
     window->on_screen_bound = Rectangle(250, 250);
-    window->dirty_rect = list_create();
+    window->dirty_region = Region::empty();
 
     window->header_container = container_create(nullptr);
     window->header_container->window = window;
@@ -111,8 +111,6 @@ void window_destroy(Window *window)
     window->backbuffer_painter.~Painter();
     window->backbuffer = nullptr;
 
-    list_destroy_with_callback(window->dirty_rect, free);
-
     if (window->destroy)
     {
         window->destroy(window);
@@ -697,30 +695,20 @@ Widget *window_root(Window *window)
 
 void window_update(Window *window)
 {
-    Rectangle repaited_regions = Rectangle::empty();
-
-    list_foreach(Rectangle, rectangle, window->dirty_rect)
-    {
-        window_paint(window, window->backbuffer_painter, *rectangle);
-
-        if (repaited_regions.is_empty())
-        {
-            repaited_regions = *rectangle;
-        }
-        else
-        {
-            repaited_regions = rectangle->merged_with(repaited_regions);
-        }
-    }
+    Region repainted_region = window->dirty_region;
+    window->dirty_region = Region::empty();
 
-    list_clear_with_callback(window->dirty_rect, free);
+    repainted_region.foreach ([&](Rectangle rectangle) {
+        window_paint(window, window->backbuffer_painter, rectangle);
+        window->frontbuffer->copy_from(*window->backbuffer, rectangle);
 
-    window->frontbuffer->copy_from(*window->backbuffer, repaited_regions);
+        return Iteration::CONTINUE;
+    });
 
     swap(window->frontbuffer, window->backbuffer);
     swap(window->frontbuffer_painter, window->backbuffer_painter);
 
-    application_flip_window(window, repaited_regions);
+    application_flip_window(window, repainted_region);
 }
 
 void window_schedule_update(Window *window, Rectangle rectangle)
@@ -728,25 +716,12 @@ void window_schedule_update(Window *window, Rectangle rectangle)
     if (!window->visible)
         return;
 
-    if (window->dirty_rect->empty())
+    if (window->dirty_region.is_empty())
     {
         eventloop_run_later((RunLaterCallback)window_update, window);
     }
 
-    list_foreach(Rectangle, dirty_rect, window->dirty_rect)
-    {
-        if (dirty_rect->colide_with(rectangle))
-        {
-            *dirty_rect = dirty_rect->merged_with(rectangle);
-            return;
-        }
-    }
-
-    Rectangle *dirty_rect = __create(Rectangle);
-
-    *dirty_rect = rectangle;
-
-    list_pushback(window->dirty_rect, dirty_rect);
+    window->dirty_region = window->dirty_region.unite(rectangle);
 }
 
 void window_layout(Window *window)
@@ -41,7 +41,7 @@ struct Window
     RefPtr<Bitmap> backbuffer;
     Painter backbuffer_painter;
 
-    List *dirty_rect;
+    Region dirty_region;
     bool dirty_layout;
 
     EventHandler handlers[EventType::__COUNT];